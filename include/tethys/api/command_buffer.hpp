@@ -7,8 +7,7 @@
 
 namespace tethys::api {
     [[nodiscard]] std::vector<vk::CommandBuffer> make_rendering_command_buffers();
-    [[nodiscard]] vk::CommandBuffer begin_transient();
-    void end_transient(const vk::CommandBuffer);
+    [[nodiscard]] std::vector<vk::CommandBuffer> make_secondary_command_buffers(const vk::CommandPool);
 } // namespace tethys::api
 
 #endif //TETHYS_COMMAND_BUFFER_HPP
@@ -2,10 +2,11 @@
 #define TETHYS_COMMAND_POOL_HPP
 
 #include <tethys/forwards.hpp>
+#include <tethys/types.hpp>
 
 namespace tethys::api {
     [[nodiscard]] vk::CommandPool make_command_pool();
-    [[nodiscard]] vk::CommandPool make_transient_pool();
+    [[nodiscard]] vk::CommandPool make_transient_pool(const u32);
 } // namespace tethys::api
 
 #endif //TETHYS_COMMAND_POOL_HPP
@@ -14,7 +14,17 @@ namespace tethys::api {
         vk::Device logical{};
         vk::Queue queue{};
         u32 family{};
+        // Dedicated transfer-only family when the device has one, same as family otherwise
+        vk::Queue transfer_queue{};
+        u32 transfer_family{};
+        // Highest count both colour and depth attachments support, the renderer picks its own up to it
         vk::SampleCountFlagBits samples{};
+        // pipelineStatisticsQuery and inheritedQueries, needed for the fragment invocation counter
+        bool pipeline_statistics{};
+        // geometryShader, fragment shaders may only read gl_PrimitiveID with it. Needed by the visibility buffer
+        bool primitive_id{};
+        // VK_KHR_draw_indirect_count, culled draws are compacted when available
+        bool draw_indirect_count{};
     };
 
     struct Swapchain {
@@ -41,6 +51,7 @@ namespace tethys::api {
         Swapchain swapchain{};
         vk::CommandPool command_pool{};
         vk::CommandPool transient_pool{};
+        vk::CommandPool transfer_pool{};
         vk::DescriptorPool descriptor_pool{};
     } context;
 } // namespace tethys::api
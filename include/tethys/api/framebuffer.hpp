@@ -7,6 +7,8 @@
 
 namespace tethys::api {
     [[nodiscard]] vk::Framebuffer make_offscreen_framebuffer(const Offscreen&, const vk::RenderPass);
+    [[nodiscard]] vk::Framebuffer make_gbuffer_framebuffer(const GBuffer&, const vk::RenderPass);
+    [[nodiscard]] vk::Framebuffer make_visibility_framebuffer(const VisibilityBuffer&, const vk::RenderPass);
 } // namespace tethys::api
 
 #endif //TETHYS_FRAMEBUFFER_HPP
@@ -0,0 +1,71 @@
+#ifndef TETHYS_GEOMETRY_BUFFER_HPP
+#define TETHYS_GEOMETRY_BUFFER_HPP
+
+#include <tethys/api/static_buffer.hpp>
+#include <tethys/api/upload.hpp>
+#include <tethys/forwards.hpp>
+#include <tethys/types.hpp>
+
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+namespace tethys::api {
+    // Device local vertex and index arena, every mesh is a suballocated range inside it.
+    // positions mirrors vertices with only the position, for depth-only passes.
+    // Index sizes count u32 slots, ranges with u16 indices take two per slot
+    // Packed arenas store PackedVertex and quantised positions instead of Vertex and vec3.
+    // The first scratch_size index slots are reserved for the meshlet culling pass, meshlets holds every mesh's clusters
+    struct GeometryBuffer {
+        StaticBuffer vertices{};
+        StaticBuffer positions{};
+        StaticBuffer indices{};
+        StaticBuffer meshlets{};
+
+        bool packed{};
+        usize vertex_stride{};
+        usize position_stride{};
+
+        usize vertex_capacity{};
+        usize vertex_size{};
+        usize index_capacity{};
+        usize index_size{};
+        usize meshlet_capacity{};
+        usize meshlet_size{};
+        usize scratch_size{};
+    };
+
+    struct GeometryRange {
+        usize vertex_offset{};
+        // In units of the range's index type, so it can be used as firstIndex directly
+        usize index_offset{};
+        // u16 indices, used when every index fits
+        bool short_indices{};
+        // Completes once the range's data is on the device
+        UploadToken upload{};
+    };
+
+    struct GeometryRead {
+        GeometryRange range{};
+        usize vertex_count{};
+        usize index_count{};
+        // Bounds the range was packed against, unused in unpacked arenas
+        glm::vec3 min{};
+        glm::vec3 extent{};
+    };
+
+    // Meshes with at most this many vertices are stored with u16 indices, 0xffff stays free for primitive restart
+    constexpr inline usize max_short_vertices = 65535;
+
+    // Vertex capacity, index capacity, packed and index slots reserved as scratch on top of the capacity
+    [[nodiscard]] GeometryBuffer make_geometry_buffer(const usize, const usize, const bool = false, const usize = 0);
+    // The bounds (min, extent) are only used to quantise positions in packed arenas
+    [[nodiscard]] GeometryRange append_geometry(GeometryBuffer&, const Vertex*, const usize, const u32*, const usize, const glm::vec3&, const glm::vec3&);
+    // Returns the index of the first meshlet in the arena's meshlet buffer
+    [[nodiscard]] usize append_meshlets(GeometryBuffer&, const Meshlet*, const usize);
+    // Copies every range back to the host through one readback buffer and blocks once until they all arrive, indices
+    // come back as u32 and packed vertices are decoded against their bounds. The result follows the order of the reads
+    [[nodiscard]] std::vector<VertexData> read_geometry(const GeometryBuffer&, const std::vector<GeometryRead>&);
+} // namespace tethys::api
+
+#endif //TETHYS_GEOMETRY_BUFFER_HPP
@@ -22,6 +22,8 @@ namespace tethys::api {
             vk::SampleCountFlagBits samples{};
 
             vk::ImageUsageFlags usage_flags{};
+            // Written by the transfer queue, shared with it instead of owned by the graphics queue
+            bool upload{};
         };
 
         i32 width{};
@@ -35,7 +37,7 @@ namespace tethys::api {
     };
 
     [[nodiscard]] Image make_image(const Image::CreateInfo&);
-    [[nodiscard]] vk::ImageView make_image_view(const vk::Image, const vk::Format, const vk::ImageAspectFlags, const u32);
+    [[nodiscard]] vk::ImageView make_image_view(const vk::Image, const vk::Format, const vk::ImageAspectFlags, const u32, const u32 = 0);
     void transition_image_layout(vk::Image, const vk::ImageLayout, const vk::ImageLayout, const u32);
 } // namespace tethys::api
 
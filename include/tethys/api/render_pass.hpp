@@ -4,7 +4,12 @@
 #include <tethys/forwards.hpp>
 
 namespace tethys::api {
-    [[nodiscard]] vk::RenderPass make_offscreen_render_pass(const Offscreen&);
+    // A resumed pass loads the color and depth left by a previous pass instead of clearing them
+    [[nodiscard]] vk::RenderPass make_offscreen_render_pass(const Offscreen&, const bool = false);
+    // Clears and fills the G-buffer, every target is left readable by the lighting pass
+    [[nodiscard]] vk::RenderPass make_gbuffer_render_pass(const GBuffer&);
+    // Clears and fills the triangle IDs, left readable by the resolve pass. Depth is not kept
+    [[nodiscard]] vk::RenderPass make_visibility_render_pass(const VisibilityBuffer&);
     [[nodiscard]] vk::RenderPass make_shadow_depth_render_pass(const ShadowDepth&);
 } // namespace tethys::api
 
@@ -5,14 +5,43 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include <vector>
+
 namespace tethys::api {
     struct Offscreen {
         api::Image color{};
         api::Image depth{};
+        // Resolved into color at the end of the pass, empty when single sampled, color is then drawn to directly
         api::Image msaa{};
+        // FXAA output, empty without it. R8G8B8A8 storage image holding sRGB encoded blue, green, red and alpha so it
+        // copies bit for bit to the B8G8R8A8 swapchain
+        api::Image aa{};
+
+        // Farthest depth per texel, one storage view per mip for building it
+        api::Image depth_pyramid{};
+        std::vector<vk::ImageView> depth_pyramid_levels{};
+    };
+
+    // Single sampled targets of the deferred path. albedo holds albedo and occlusion, normal the octahedral normal,
+    // metallic and roughness, negative roughness marks unlit surfaces. lit is written by the lighting pass
+    struct GBuffer {
+        api::Image albedo{};
+        api::Image normal{};
+        api::Image depth{};
+        api::Image lit{};
+    };
+
+    // Single sampled targets of the visibility buffer path. ids holds the triangle ID of every pixel, 0 where nothing
+    // was drawn. lit is written by the resolve pass
+    struct VisibilityBuffer {
+        api::Image ids{};
+        api::Image depth{};
+        api::Image lit{};
     };
 
-    [[nodiscard]] Offscreen make_offscreen_target();
+    [[nodiscard]] Offscreen make_offscreen_target(const vk::SampleCountFlagBits, const bool);
+    [[nodiscard]] GBuffer make_gbuffer_target();
+    [[nodiscard]] VisibilityBuffer make_visibility_target();
 } // namespace tethys::api
 
 #endif //TETHYS_RENDER_TARGET_HPP
@@ -7,7 +7,9 @@ namespace tethys::api {
     enum class SamplerType {
         eNone,
         eDefault,
-        eDepth
+        eDepth,
+        eNearest,
+        eLinear
     };
 
     void make_samplers();
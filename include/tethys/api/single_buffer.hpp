@@ -5,6 +5,8 @@
 #include <tethys/api/context.hpp>
 
 #include <type_traits>
+#include <algorithm>
+#include <cstring>
 
 namespace tethys::api {
     template <typename Ty>
@@ -21,9 +23,12 @@ namespace tethys::api {
         void create(const vk::BufferUsageFlags&);
         void write(const Ty&);
         void write(const std::vector<Ty>&);
+        void write(const usize, const Ty&);
+        void resize(const usize);
         void deallocate();
 
         [[nodiscard]] void* buf() const;
+        [[nodiscard]] vk::Buffer handle() const;
         [[nodiscard]] usize size() const;
         [[nodiscard]] vk::DescriptorBufferInfo info() const;
     };
@@ -70,6 +75,30 @@ namespace tethys::api {
         current_size = objs.size();
     }
 
+    template <typename Ty>
+    void SingleBuffer<Ty>::write(const usize index, const Ty& obj) {
+        static_assert(std::is_trivially_copyable_v<Ty>, "Type is not trivially copyable!");
+
+        std::memcpy(static_cast<Ty*>(mapped) + index, &obj, sizeof(Ty));
+    }
+
+    // Grows the buffer while keeping its current contents, unlike write(const std::vector<Ty>&)
+    template <typename Ty>
+    void SingleBuffer<Ty>::resize(const usize size) {
+        if (size > current_capacity) {
+            auto old_buffer = buffer;
+            auto old_mapped = mapped;
+
+            allocate(std::max(size, current_capacity * 2));
+            std::memcpy(mapped, old_mapped, current_size * sizeof(Ty));
+
+            vmaUnmapMemory(context.allocator, old_buffer.allocation);
+            destroy_buffer(old_buffer);
+        }
+
+        current_size = size;
+    }
+
     template <typename Ty>
     void SingleBuffer<Ty>::deallocate() {
         vmaUnmapMemory(context.allocator, buffer.allocation);
@@ -96,6 +125,11 @@ namespace tethys::api {
     void* SingleBuffer<Ty>::buf() const {
         return mapped;
     }
+
+    template <typename Ty>
+    vk::Buffer SingleBuffer<Ty>::handle() const {
+        return buffer.handle;
+    }
 } // namespace tethys::api
 
 #endif //TETHYS_SINGLE_BUFFER_HPP
@@ -1,6 +1,7 @@
 #ifndef TETHYS_STATIC_BUFFER_HPP
 #define TETHYS_STATIC_BUFFER_HPP
 
+#include <tethys/forwards.hpp>
 #include <tethys/types.hpp>
 
 #include <vulkan/vulkan.hpp>
@@ -13,10 +14,36 @@ namespace tethys::api {
         VmaAllocation allocation{};
     };
 
-    [[nodiscard]] StaticBuffer make_buffer(const usize, const vk::BufferUsageFlags&, const VmaMemoryUsage, const VmaAllocationCreateFlags);
-    void copy_buffer(const vk::Buffer, vk::Buffer, const usize);
-    void copy_buffer_to_image(const vk::Buffer, vk::Image, const u32, const u32);
+    // Persistently mapped upload memory. Regions are handed out from head and given back in the same order from tail
+    struct StagingRing {
+        StaticBuffer buffer{};
+        u8* mapped{};
+        usize size{};
+        usize head{};
+        usize tail{};
+        usize used{};
+    };
+
+    struct StagingRegion {
+        usize offset{};
+        usize size{};
+        u8* mapped{};
+        // Includes the padding skipped to reach offset, this is what gets released
+        usize consumed{};
+    };
+
+    // Buffers the transfer queue uploads into are created with upload = true, see make_buffer
+    [[nodiscard]] StaticBuffer make_buffer(const usize, const vk::BufferUsageFlags&, const VmaMemoryUsage, const VmaAllocationCreateFlags, const bool = false);
+    // Recorded into the open upload batch, see api::flush_uploads
+    UploadToken copy_buffer(const vk::Buffer, vk::Buffer, const usize, const usize = 0, const usize = 0);
+    // Copies height rows into mip 0 starting at the given row
+    UploadToken copy_buffer_to_image(const vk::Buffer, vk::Image, const u32, const u32, const usize = 0, const u32 = 0);
     void destroy_buffer(StaticBuffer& buffer);
+
+    [[nodiscard]] StagingRing make_staging_ring(const usize);
+    // Largest contiguous region of at most size bytes, a multiple of the granularity. Empty when the ring is full
+    [[nodiscard]] StagingRegion acquire_staging(StagingRing&, const usize, const usize);
+    void release_staging(StagingRing&, const usize);
 } // namespace tethys::api
 
 #endif //TETHYS_STATIC_BUFFER_HPP
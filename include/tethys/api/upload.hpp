@@ -0,0 +1,54 @@
+#ifndef TETHYS_UPLOAD_HPP
+#define TETHYS_UPLOAD_HPP
+
+#include <tethys/api/static_buffer.hpp>
+#include <tethys/forwards.hpp>
+#include <tethys/types.hpp>
+
+#include <vulkan/vulkan.hpp>
+
+#include <functional>
+#include <mutex>
+
+namespace tethys::api {
+    // Identifies the batch an upload was recorded into, batch 0 is always complete
+    struct UploadToken {
+        u64 batch{};
+    };
+
+    // Transfers recorded since the last flush, submitted together with a single fence
+    struct UploadBatch {
+        // Copies, runs on the transfer queue when the device has a dedicated family
+        vk::CommandBuffer transfer{};
+        // Blits and final layout changes on the graphics queue, runs after transfer. Same buffer as transfer without a dedicated family
+        vk::CommandBuffer graphics{};
+        // Bytes of the staging ring given back once the batch completes
+        usize staging{};
+        UploadToken token{};
+    };
+
+    // The open batch may be recorded into while the scope is alive
+    struct UploadScope {
+        std::unique_lock<std::recursive_mutex> lock;
+        UploadBatch& batch;
+    };
+
+    [[nodiscard]] UploadScope record_upload();
+    // Called with a mapped staging region, the source offset it starts at and its size in bytes
+    using UploadWriter = std::function<void(u8*, const usize, const usize)>;
+
+    // Copies size bytes into dst at the given offset through the staging ring
+    UploadToken upload_buffer(const void*, const usize, const vk::Buffer, const usize = 0);
+    // Same, but the writer fills the staging memory directly. Regions are a multiple of the granularity
+    UploadToken upload_buffer(const usize, const usize, const vk::Buffer, const usize, const UploadWriter&);
+    // Tightly packed rows into mip 0 of an image in TransferDstOptimal, regions are whole rows
+    UploadToken upload_image(vk::Image, const u32, const u32, const u32, const UploadWriter&);
+
+    // Submits the open batch, work submitted to the graphics queue afterwards sees its results
+    UploadToken flush_uploads();
+    [[nodiscard]] bool upload_complete(const UploadToken);
+    // Flushes first if the token belongs to the open batch
+    void wait_upload(const UploadToken);
+} // namespace tethys::api
+
+#endif //TETHYS_UPLOAD_HPP
@@ -9,16 +9,56 @@ namespace tethys {
         // Set = 0
         constexpr inline u32 camera = 0;
         constexpr inline u32 transform = 1;
-        constexpr inline u32 texture = 2;
+        constexpr inline u32 draw = 2;
+        constexpr inline u32 instances = 3;
+        constexpr inline u32 texture = 4; // Variable count, must stay the last binding
 
         // Set = 1
         constexpr inline u32 point_light = 0;
         constexpr inline u32 directional_light = 1;
+        constexpr inline u32 light_clusters = 2;
+        constexpr inline u32 light_indices = 3;
+        constexpr inline u32 light_stats = 4;
+
+        // Set = 1, culling pipeline
+        constexpr inline u32 cull_data = 0;
+        constexpr inline u32 visible_commands = 1;
+        constexpr inline u32 visibility = 2;
+        constexpr inline u32 cull_stats = 3;
+        constexpr inline u32 depth_pyramid = 4;
+        constexpr inline u32 meshlets = 5;
+        constexpr inline u32 geometry_indices = 6;
+        constexpr inline u32 meshlet_work = 7;
+        constexpr inline u32 meshlet_dispatch = 8;
+        constexpr inline u32 command_batches = 9;
+        constexpr inline u32 compacted_commands = 10;
+        constexpr inline u32 draw_counts = 11;
+
+        // Set = 0, depth pyramid pipelines
+        constexpr inline u32 reduce_source = 0;
+        constexpr inline u32 reduce_target = 1;
+
+        // Set = 2, deferred lighting pipeline
+        constexpr inline u32 gbuffer_albedo = 0;
+        constexpr inline u32 gbuffer_normal = 1;
+        constexpr inline u32 gbuffer_depth = 2;
+        constexpr inline u32 lit = 3;
+
+        // Set = 2, visibility buffer pipelines
+        constexpr inline u32 visibility_draws = 0;
+        constexpr inline u32 visibility_ids = 1;
+        constexpr inline u32 visibility_vertices = 2;
+        constexpr inline u32 visibility_indices = 3;
+        constexpr inline u32 visibility_lit = 4;
     } // namespace tethys::binding
 
     namespace layout {
         constexpr inline u32 generic = 0;
         constexpr inline u32 minimal = 1;
+        constexpr inline u32 cull = 2;
+        constexpr inline u32 depth_reduce = 3;
+        constexpr inline u32 deferred = 4;
+        constexpr inline u32 visibility = 5;
     } // namespace tethys::layout
 
     namespace shader {
@@ -27,6 +67,15 @@ namespace tethys {
         constexpr inline u32 pbr = 2;
     } // namespace tethys::shader
 
+    // Froxel grid for clustered lighting, the shaders hardcode the same values
+    namespace cluster {
+        constexpr inline u32 x = 16;
+        constexpr inline u32 y = 9;
+        constexpr inline u32 z = 24;
+        constexpr inline u32 count = x * y * z;
+        constexpr inline u32 max_lights = 128;
+    } // namespace tethys::cluster
+
     namespace texture {
         constexpr inline u32 white = 0;
         constexpr inline u32 black = 1;
@@ -35,6 +84,8 @@ namespace tethys {
 
     namespace api {
         constexpr inline u32 frames_in_flight = 2;
+        // Larger uploads are split and wait for earlier batches to retire
+        constexpr inline usize staging_ring_size = 64 * 1024 * 1024;
     } // namespace tethys::api
 } // namespace tethys
 
@@ -0,0 +1,36 @@
+#ifndef TETHYS_CULLING_HPP
+#define TETHYS_CULLING_HPP
+
+#include <tethys/types.hpp>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <vector>
+
+namespace tethys::culling {
+    // Width of the widest SIMD path, storage is padded to a multiple of it
+    constexpr inline usize lanes = 8;
+
+    // World space bounding spheres in structure-of-arrays form
+    struct Spheres {
+        std::vector<f32> x{};
+        std::vector<f32> y{};
+        std::vector<f32> z{};
+        std::vector<f32> radius{};
+        usize size{};
+    };
+
+    void resize(Spheres&, const usize);
+    void write(Spheres&, const usize, const glm::vec4&);
+
+    // Normalized planes (left, right, bottom, top, near, far) of a projection * view matrix
+    [[nodiscard]] std::array<glm::vec4, 6> frustum_planes(const glm::mat4&);
+
+    // Appends the index of every sphere inside the frustum and within the given distance of the eye, in ascending order
+    void cull(const Spheres&, const std::array<glm::vec4, 6>&, const glm::vec3&, const f32, std::vector<u32>&);
+} // namespace tethys::culling
+
+#endif //TETHYS_CULLING_HPP
@@ -0,0 +1,97 @@
+#ifndef TETHYS_DRAW_DATA_HPP
+#define TETHYS_DRAW_DATA_HPP
+
+#include <tethys/types.hpp>
+#include <tethys/mesh.hpp>
+
+#include <glm/vec4.hpp>
+
+namespace tethys {
+    // Per-draw record read by the shaders through the instance list the culling pass fills in (std430 layout)
+    struct DrawData {
+        u32 transform;
+        u32 albedo;
+        u32 metallic;
+        u32 normal;
+        u32 roughness;
+        u32 occlusion;
+        // Dequantises packed vertex positions as min + pos * extent, 0 and 1 for full vertices
+        f32 position_min[3];
+        f32 position_extent[3];
+    };
+
+    // Indirect command range and object space error of one level of detail
+    struct CullLod {
+        u32 first_index;
+        u32 index_count;
+        f32 error;
+    };
+
+    // Per-draw input of the culling pass, matched 1:1 with the draw data (std430 layout)
+    struct CullData {
+        glm::vec4 sphere;
+        // First of the instance group's commands, one per level of detail
+        u32 command;
+        // Group's first instance slot, each level of detail has group_size slots after it
+        u32 instance_slot;
+        u32 lod_count;
+        u32 short_indices;
+        CullLod lods[max_lods];
+        // Range inside the geometry arena's meshlet buffer, full detail draws with meshlets go through the meshlet pass
+        u32 meshlet_first;
+        u32 meshlet_count;
+        u32 group_size;
+        // Visibility buffer only. IDs from triangle_base on belong to this draw, its levels of detail one after the
+        // other. vertex_offset and lit let the resolve pass rebuild and shade its triangles
+        u32 triangle_base;
+        i32 vertex_offset;
+        u32 lit;
+        u32 padding[3];
+    };
+
+    static_assert(sizeof(CullData) == 128);
+
+    // Draw routed to the meshlet pass by the culling pass, its triangles go to the scratch slots starting at scratch
+    struct MeshletWork {
+        u32 draw;
+        // Command in the visible buffer whose index count the meshlet pass fills in
+        u32 slot;
+        u32 scratch;
+        u32 padding;
+    };
+
+    // Scratch index slots the culling pass allocates from, and the indirect dispatch of the meshlet pass per phase
+    struct MeshletDispatch {
+        u32 scratch_base;
+        u32 scratch_size;
+        u32 scratch_used;
+        u32 padding;
+        // x, y, z and padding
+        u32 groups[2][4];
+    };
+
+    // Draws and triangles rejected by culling in one frame
+    struct CullStats {
+        u32 frustum_draws;
+        u32 frustum_triangles;
+        u32 occlusion_draws;
+        u32 occlusion_triangles;
+        // Triangles of the draws that passed, at the level of detail they were drawn with
+        u32 submitted_triangles;
+        // Triangles of visible draws rejected by meshlet culling
+        u32 meshlet_triangles;
+    };
+
+    // Lights left out of full light lists in one frame, those lights do not shade the affected pixels
+    struct LightStats {
+        // Clusters that reached cluster::max_lights, and the lights they left out
+        u32 overflow_clusters;
+        u32 dropped_cluster_lights;
+        // Deferred tiles whose light list overflowed and were shaded against every light, and the most lights any
+        // tile binned. Both stay 0 with forward and visibility shading
+        u32 overflow_tiles;
+        u32 peak_tile_lights;
+    };
+} // namespace tethys
+
+#endif //TETHYS_DRAW_DATA_HPP
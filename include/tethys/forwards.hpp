@@ -22,19 +22,28 @@ namespace vk {
 namespace tethys {
     struct Mesh;
     struct Model;
+    struct Meshlet;
     struct Vertex;
+    struct VertexData;
     struct Texture;
     struct Pipeline;
     struct PointLight;
     struct DirectionalLight;
+    struct DrawData;
+    struct CullStats;
+    struct LightStats;
     struct RenderData;
+    struct DrawCommand;
 } // namespace tethys
 
 namespace tethys::api {
     struct Context;
+    struct UploadToken;
     struct Device;
     struct Swapchain;
     struct Offscreen;
+    struct GBuffer;
+    struct VisibilityBuffer;
     struct ShadowDepth;
     struct StaticBuffer;
     class DescriptorSet;
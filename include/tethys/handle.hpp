@@ -8,6 +8,8 @@ namespace tethys {
     template <typename Ty>
     struct Handle {
         usize index{};
+        // Bumped every time the slot is freed, handles to an earlier occupant stop matching
+        u32 generation{};
     };
 } // namespace tethys
 
@@ -0,0 +1,30 @@
+#ifndef TETHYS_JOBS_HPP
+#define TETHYS_JOBS_HPP
+
+#include <tethys/types.hpp>
+
+#include <functional>
+#include <atomic>
+
+namespace tethys::jobs {
+    // Number of unfinished jobs in a group, jobs::wait blocks until it drops to zero
+    struct Counter {
+        std::atomic<u32> pending{};
+    };
+
+    // Spawns hardware_concurrency() - 1 workers when 0, at least one. The thread calling wait() acts as one more
+    // Jobs submitted before initialise run inline on the submitting thread
+    void initialise(const u32 = 0);
+    // Joins the workers and runs whatever is still queued on the caller, later submissions run inline
+    void shutdown();
+
+    void submit(std::function<void()>, Counter&);
+    // Splits [0, count) in chunks of at most grain elements, each chunk is a job calling fn(first, last)
+    void parallel_for(const usize, const usize, const std::function<void(usize, usize)>&, Counter&);
+    // Runs queued jobs on the calling thread while the group is busy, sleeps when there is nothing to take
+    void wait(Counter&);
+
+    [[nodiscard]] u32 worker_count();
+} // namespace tethys::jobs
+
+#endif //TETHYS_JOBS_HPP
@@ -1,26 +1,73 @@
 #ifndef TETHYS_MESH_HPP
 #define TETHYS_MESH_HPP
 
-#include <tethys/api/vertex_buffer.hpp>
-#include <tethys/api/index_buffer.hpp>
 #include <tethys/vertex.hpp>
 #include <tethys/handle.hpp>
 #include <tethys/types.hpp>
 
+#include <glm/vec4.hpp>
+
 #include <vector>
+#include <array>
 
 namespace tethys {
+    constexpr inline usize max_lods = 5;
+
+    // One level of detail, every level of a mesh shares its vertices
+    struct MeshLod {
+        // Relative to the mesh's first index
+        u32 index_offset;
+        u32 index_count;
+        // Object space distance the simplified surface may be off by, 0 for the full mesh
+        f32 error;
+    };
+
+    // Cluster of the full detail level read by the meshlet culling pass (std430 layout)
+    struct Meshlet {
+        // Object space bounds, w is the radius
+        glm::vec4 sphere;
+        // Every triangle faces away when dot(normalize(cone_apex - camera), cone_axis) >= cone_apex.w
+        glm::vec4 cone_apex;
+        glm::vec4 cone_axis;
+        // Relative to the mesh's first index. Triangle counts are even so u16 ranges start on a 4 byte boundary
+        u32 index_offset;
+        u32 index_count;
+        u32 padding[2];
+    };
+
     struct VertexData {
         std::vector<Vertex> geometry{};
+        // Every level back to back, full detail first
         std::vector<u32> indices{};
+        // Empty when indices is a single level
+        std::vector<MeshLod> lods{};
+        // Split of the full detail level, empty when it was not clustered
+        std::vector<Meshlet> meshlets{};
     };
 
+    // Range inside the renderer's shared geometry arena
     struct Mesh {
-        api::VertexBuffer vbo;
-        api::IndexBuffer ibo;
+        usize vertex_offset;
+        // In units of the index type
+        usize index_offset;
 
         usize vertex_count;
         usize index_count;
+        // u16 instead of u32 indices
+        bool short_indices;
+
+        // lods[0] is index_offset and index_count
+        std::array<MeshLod, max_lods> lods;
+        u32 lod_count;
+
+        // Range inside the arena's meshlet buffer, empty unless meshlet culling is enabled
+        usize meshlet_offset;
+        u32 meshlet_count;
+
+        // Object space bounds, sphere.w is the radius
+        glm::vec4 sphere;
+        glm::vec3 min;
+        glm::vec3 max;
     };
 } // namespace tethys
 
@@ -0,0 +1,58 @@
+#ifndef TETHYS_MESH_OPTIMISER_HPP
+#define TETHYS_MESH_OPTIMISER_HPP
+
+#include <tethys/types.hpp>
+#include <tethys/mesh.hpp>
+
+#include <vector>
+
+namespace tethys::optimise {
+    // FIFO post-transform cache size ACMR is measured with
+    constexpr inline usize cache_size = 16;
+    // Overdraw reordering may make ACMR at most this much worse than the cache optimised order
+    constexpr inline f32 overdraw_threshold = 1.05f;
+    // Each level of detail targets this fraction of the previous level's triangles
+    constexpr inline f32 lod_reduction = 0.5f;
+    // Levels are not generated below this many triangles
+    constexpr inline usize min_lod_triangles = 64;
+    // Error a single level may add, relative to the mesh's bounding radius
+    constexpr inline f32 max_lod_error = 0.1f;
+    // Meshlet size limits, 124 keeps the triangle count even and the index count a multiple of 4
+    constexpr inline usize meshlet_vertices = 64;
+    constexpr inline usize meshlet_triangles = 124;
+
+    struct Stats {
+        usize triangles{};
+        usize vertices_before{};
+        usize vertices_after{};
+        f32 acmr_before{};
+        f32 acmr_after{};
+    };
+
+    // Merges bit-identical vertices and remaps the indices
+    void weld(VertexData&);
+    // Forsyth's linear-speed vertex cache optimisation, reorders triangles only
+    void vertex_cache(std::vector<u32>&, const usize);
+    // Splits the triangle order in cache-friendly clusters and sorts them so outward facing clusters are drawn first,
+    // after Sander et al. 2007. ACMR grows by at most the threshold
+    void overdraw(VertexData&, const f32 = overdraw_threshold);
+    // Renumbers vertices in the order the indices first reference them, unreferenced vertices are dropped
+    void vertex_fetch(VertexData&);
+    // Quadric error edge collapse (Garland & Heckbert 1997) towards the target index count, stopping early once a
+    // collapse would move the surface further than the target error. Vertices only collapse onto existing ones, those
+    // on borders and attribute seams stay put. Returns the new indices and writes the error reached
+    [[nodiscard]] std::vector<u32> simplify(const std::vector<Vertex>&, const std::vector<u32>&, const usize, const f32, f32&);
+    // Appends up to max_lods - 1 simplified levels after the full mesh and fills VertexData::lods
+    void lods(VertexData&);
+    // Splits the full detail level in order into meshlets with a bounding sphere and normal cone each, filling
+    // VertexData::meshlets. Meshlets with an odd triangle count get a degenerate one, later levels move back to match
+    void meshlets(VertexData&);
+
+    // Average cache miss ratio, vertices transformed per triangle with a FIFO cache of cache_size entries
+    [[nodiscard]] f32 acmr(const std::vector<u32>&, const usize);
+
+    // Runs every pass in order. Meshes that are not triangle lists are left untouched
+    [[nodiscard]] Stats mesh(VertexData&);
+} // namespace tethys::optimise
+
+#endif //TETHYS_MESH_OPTIMISER_HPP
@@ -4,10 +4,13 @@
 #include <tethys/forwards.hpp>
 #include <tethys/texture.hpp>
 #include <tethys/handle.hpp>
+#include <tethys/tmesh.hpp>
 #include <tethys/types.hpp>
 #include <tethys/mesh.hpp>
 
 #include <vector>
+#include <array>
+#include <string>
 #include <filesystem>
 
 namespace tethys {
@@ -25,6 +28,33 @@ namespace tethys {
         std::vector<SubMesh> submeshes;
     };
 
+    // A texture referenced by a scene and its decoded pixels
+    struct TextureRequest {
+        std::string path;
+        vk::Format format;
+        ImageData image;
+    };
+
+    // CPU side of a model import, produced without touching the GPU or renderer state
+    struct ModelImport {
+        std::vector<VertexData> meshes;
+        // Albedo, metallic and normal paths per mesh, empty when the material has none. Empty for PBR imports
+        std::vector<std::array<std::string, 3>> texture_paths;
+        // Every unique texture the scene references
+        std::vector<TextureRequest> textures;
+        // Mapped .tmesh the geometry is written from instead of meshes, when the import came from a baked file
+        tmesh::File baked;
+    };
+
+    // Parses the scene, then converts every mesh and decodes its textures in parallel on the job system.
+    // Flags: collect textures, skip textures already loaded (only safe on the render thread), decode them
+    [[nodiscard]] ModelImport import_model(const std::string&, const bool, const bool, const bool = true);
+    // Same as import_model, but reads the baked .tmesh next to the source instead when it is up to date
+    [[nodiscard]] ModelImport import_any(const std::string&, const bool, const bool);
+    // Records the uploads of an import from the render thread, they go out with the next upload batch
+    [[nodiscard]] Model finish_import(ModelImport&);
+
+    // Uses the baked .tmesh next to the source when it is up to date
     [[nodiscard]] Model load_model(const std::string&);
     [[nodiscard]] Model load_model_pbr(const std::string&);
     [[nodiscard]] Model load_model(const VertexData&, const char*, const char*, const char*);
@@ -22,6 +22,7 @@ namespace tethys {
             vk::PushConstantRange push_constants{};
 
             std::string vertex{};
+            // Empty for depth-only pipelines, colour writes are then disabled
             std::string fragment{};
 
             u32 subpass_idx{};
@@ -30,6 +31,28 @@ namespace tethys {
             vk::SampleCountFlagBits samples{};
             vk::CullModeFlagBits cull{};
             std::vector<vk::DynamicState> dynamic_states{};
+
+            // Reads the position-only stream of the geometry arena instead of full vertices
+            bool position_only = false;
+            // Reads PackedVertex, the vertex shaders decode it through specialisation constant 0
+            bool packed_vertices = false;
+            bool depth_write = true;
+            vk::CompareOp depth_compare = vk::CompareOp::eLessOrEqual;
+            // G-buffer pipelines write several targets, blending is only enabled with a single one
+            u32 color_attachments = 1;
+            // Integer targets can't be blended
+            bool blending = true;
+            // Runs the fragment shader for every covered sample instead of once per pixel
+            bool sample_shading = false;
+        };
+
+        struct ComputeCreateInfo {
+            std::vector<vk::DescriptorSetLayout> layouts{};
+            vk::PushConstantRange push_constants{};
+
+            std::string compute{};
+            // Specialisation constant 0, for shaders fetching vertices from the geometry arena
+            bool packed_vertices = false;
         };
 
         vk::Pipeline handle{};
@@ -37,6 +60,7 @@ namespace tethys {
     };
 
     [[nodiscard]] Pipeline make_pipeline(const Pipeline::CreateInfo&);
+    [[nodiscard]] Pipeline make_compute_pipeline(const Pipeline::ComputeCreateInfo&);
 } // namespace tethys
 
 #endif //TETHYS_PIPELINE_HPP
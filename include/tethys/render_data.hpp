@@ -3,6 +3,7 @@
 
 #include <tethys/pipeline.hpp>
 #include <tethys/forwards.hpp>
+#include <tethys/handle.hpp>
 #include <tethys/camera.hpp>
 #include <tethys/model.hpp>
 #include <tethys/mesh.hpp>
@@ -10,18 +11,15 @@
 #include <glm/mat4x4.hpp>
 
 namespace tethys {
+    // Registered once through renderer::add_instance, then referenced by Handle<DrawCommand>
     struct DrawCommand {
-        Model model{};
+        Handle<Model> model{};
         glm::mat4 transform{};
         Pipeline shader{};
     };
 
+    // Per-frame data, everything else lives in the renderer's retained scene
     struct RenderData {
-        std::vector<DrawCommand> draw_commands{};
-
-        std::vector<PointLight> point_lights{};
-        std::vector<DirectionalLight> directional_lights{};
-
         Camera camera{}; // Just one for now
     };
 } // namespace tethys
@@ -1,6 +1,7 @@
 #ifndef TETHYS_RENDERER_HPP
 #define TETHYS_RENDERER_HPP
 
+#include <tethys/constants.hpp>
 #include <tethys/forwards.hpp>
 #include <tethys/handle.hpp>
 #include <tethys/mesh.hpp>
@@ -9,23 +10,115 @@
 #include <glm/vec4.hpp>
 
 #include <filesystem>
+#include <limits>
 #include <vector>
 
 namespace tethys {
     namespace renderer {
-        void initialise();
+        enum class Culling {
+            automatic, // CPU on software rasterizers, GPU otherwise
+            gpu,
+            cpu
+        };
+
+        enum class Shading {
+            // Lights are clustered and every lit pipeline shades its own fragments
+            forward,
+            // Single sampled G-buffer, lit by a tiled compute pass. Every lit pipeline is shaded as PBR
+            deferred,
+            // Single sampled 32-bit triangle IDs, a compute pass refetches each pixel's triangle and shades it as PBR
+            // with the clustered lights. Needs gl_PrimitiveID in fragment shaders, falls back to forward without it
+            visibility
+        };
+
+        struct Settings {
+            Culling culling = Culling::automatic;
+            // Only honoured by CPU culling
+            f32 draw_distance = std::numeric_limits<f32>::infinity();
+            // Two-phase Hi-Z culling, only honoured by GPU culling
+            bool occlusion_culling = true;
+            // Depth-only pass before the colour pass so every fragment is shaded once
+            bool depth_prepass = false;
+            // 20 byte PackedVertex in the geometry arena instead of the 56 byte Vertex
+            bool packed_vertices = false;
+            // Per-draw level of detail, the coarsest one whose error projects to at most lod_threshold pixels
+            bool lod = true;
+            f32 lod_threshold = 1.0f;
+            // Switching to a coarser level needs the error this fraction below the threshold, 0 disables it
+            f32 lod_hysteresis = 0.1f;
+            // Full detail draws are split in meshlets culled against the frustum and for backfacing, only honoured by
+            // GPU culling. Reserves meshlet_scratch index slots per frame in flight in the geometry arena
+            bool meshlet_culling = false;
+            u32 meshlet_scratch = 1u << 20u;
+            // Consecutive draws of the same mesh and pipeline are drawn as one instanced command
+            bool instancing = true;
+            // Deferred and visibility shading are cheaper with thousands of lights, they give up MSAA, occlusion culling
+            // and the pre-pass. The visibility buffer also gives up meshlet culling, and draw throws once the scene holds
+            // more triangles than its 32-bit IDs can tell apart
+            Shading shading = Shading::forward;
+            // MSAA samples of the forward path, 1, 2, 4 or 8 lowered to what the device supports. 0 picks 1 on software
+            // rasterizers and 4 otherwise
+            u32 samples = 0;
+            // Shades every covered sample instead of once per pixel, smooths shader aliasing at samples times the cost
+            bool sample_shading = false;
+            // FXAA pass over the final image, works with every shading mode and sample count
+            bool fxaa = false;
+        };
+
+        void initialise(const Settings& = {});
 
         [[nodiscard]] Mesh write_geometry(const VertexData&);
         [[nodiscard]] Mesh write_geometry(const std::vector<Vertex>&, const std::vector<u32>&);
+        // The indices hold every level of detail back to back, without a level table they are a single level
+        // Meshlets are only kept with meshlet culling enabled
+        [[nodiscard]] Mesh write_geometry(const Vertex*, const usize, const u32*, const usize, const MeshLod* = nullptr, const usize = 0, const Meshlet* = nullptr, const usize = 0);
         [[nodiscard]] Texture upload_texture(const u8, const u8, const u8, const u8, const vk::Format);
         [[nodiscard]] Texture upload_texture(const char*, const vk::Format);
+        // Tightly packed RGBA8 pixels
+        [[nodiscard]] Texture upload_texture(const u8*, const u32, const u32, const vk::Format);
+        // Return immediately. Until the asset is decoded and on the GPU, instances of the model draw nothing and textures
+        // use the builtin placeholders, the result is swapped in by draw() between frames
+        [[nodiscard]] Handle<Model> upload_model_async(const std::string&);
+        [[nodiscard]] Texture upload_texture_async(const char*, const vk::Format, const u32 = texture::white);
         [[nodiscard]] Model upload_model(const std::string&);
         [[nodiscard]] Model upload_model_pbr(const std::string&);
         [[nodiscard]] Model upload_model(const VertexData&, const char* = nullptr, const char* = nullptr, const char* = nullptr);
         [[nodiscard]] Model upload_model(const VertexData&, const char* = nullptr, const char* = nullptr, const char* = nullptr, const char* = nullptr, const char* = nullptr);
 
+        [[nodiscard]] Handle<Model> add_model(const Model&);
+        // Instances of a removed model draw nothing, a pending async load into it is dropped
+        void remove_model(const Handle<Model>);
+        [[nodiscard]] Handle<DrawCommand> add_instance(const DrawCommand&);
+        // Stale handles, to instances already removed, are ignored with a warning
+        void update_instance(const Handle<DrawCommand>, const glm::mat4&);
+        void remove_instance(const Handle<DrawCommand>);
+        // Pre-transforms the draws' full detail geometry into one instance drawn with an identity transform. The draws
+        // must share a pipeline and their models must have finished loading. Geometry is grouped by material and split
+        // in spatially compact chunks of about 16k vertices, each drawn and culled on its own. A single mesh larger than
+        // that keeps a chunk to itself. Draws with a degenerate transform are left out. The source instances stay in the
+        // scene, remove them once the batch replaces them or they are drawn twice
+        [[nodiscard]] Handle<DrawCommand> bake_static_batch(const std::vector<DrawCommand>&);
+        [[nodiscard]] Handle<PointLight> add_point_light(const PointLight&);
+        void update_point_light(const Handle<PointLight>, const PointLight&);
+        void remove_point_light(const Handle<PointLight>);
+        [[nodiscard]] Handle<DirectionalLight> add_directional_light(const DirectionalLight&);
+        void update_directional_light(const Handle<DirectionalLight>, const DirectionalLight&);
+        void remove_directional_light(const Handle<DirectionalLight>);
+
         void draw(const RenderData&);
         void submit();
+        // Stops the asset loader and waits for its uploads and the GPU. Call before jobs::shutdown, the loader runs
+        // imports on the job system
+        void shutdown();
+
+        // Draws and triangles rejected by culling in the last completed frame
+        [[nodiscard]] CullStats cull_stats();
+        // Light list overflow of the last completed frame, see LightStats
+        [[nodiscard]] LightStats light_stats();
+        // Fragment shader invocations of the last completed frame, 0 without pipeline statistics support
+        [[nodiscard]] u64 fragment_invocations();
+        // Threads the last frame's draws were recorded on, 0 when they were recorded inline
+        [[nodiscard]] u32 secondary_workers();
     } // namespace tethys::renderer
 
     namespace texture {
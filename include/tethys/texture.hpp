@@ -1,21 +1,41 @@
 #ifndef TETHYS_TEXTURE_HPP
 #define TETHYS_TEXTURE_HPP
 
+#include <tethys/api/upload.hpp>
 #include <tethys/api/image.hpp>
 #include <tethys/forwards.hpp>
 #include <tethys/types.hpp>
 
 #include <vulkan/vulkan.hpp>
 
+#include <memory>
+
 namespace tethys {
     struct Texture {
         api::Image image{};
-        u32 index{}; // Temporary fix, indicates texture index in texture descriptor
+        u32 index{}; // Slot in the texture descriptor array, assigned by the renderer
         u32 mips{};
+        // Completes once every mip is uploaded
+        api::UploadToken upload{};
 
         [[nodiscard]] vk::DescriptorImageInfo info(const api::SamplerType&) const;
     };
 
+    struct ImageDeleter {
+        void operator ()(u8*) const;
+    };
+
+    // Decoded RGBA8 pixels, safe to produce from any thread. The pixels are freed with the ImageData
+    struct ImageData {
+        std::unique_ptr<u8, ImageDeleter> pixels{};
+        u32 width{};
+        u32 height{};
+    };
+
+    [[nodiscard]] ImageData decode_image(const char*);
+    // Frees the pixels early, once they have been uploaded
+    void free_image(ImageData&);
+
     [[nodiscard]] Texture load_texture(const char*, const vk::Format);
     [[nodiscard]] Texture load_texture(const u8*, const u32, const u32, const u32, const vk::Format);
 } // namespace tethys
@@ -0,0 +1,72 @@
+#ifndef TETHYS_TMESH_HPP
+#define TETHYS_TMESH_HPP
+
+#include <tethys/forwards.hpp>
+#include <tethys/vertex.hpp>
+#include <tethys/mesh.hpp>
+#include <tethys/types.hpp>
+#include <tethys/util.hpp>
+
+#include <string>
+
+// Baked model format written by tethys-bake, loaded without going through Assimp.
+// Layout: Header, SubMesh[submesh_count], Vertex[vertex_count], u32[index_count], Meshlet[meshlet_count], string table
+namespace tethys::tmesh {
+    constexpr inline char magic[4]{ 'T', 'M', 'S', 'H' };
+    // 2: geometry is welded and reordered by the mesh optimiser
+    // 3: levels of detail, the indices of a submesh hold every level
+    // 4: meshlets of the full detail level
+    constexpr inline u32 version = 4;
+    constexpr inline u32 no_texture = ~0u;
+
+    struct Header {
+        char magic[4];
+        u32 version;
+        // Write time of the source file the bake was made from
+        i64 source_time;
+        u32 submesh_count;
+        u32 vertex_stride;
+        u64 vertex_count;
+        u64 index_count;
+        u64 meshlet_count;
+        u64 strings_size;
+    };
+
+    struct SubMesh {
+        u64 vertex_offset;
+        u64 vertex_count;
+        u64 index_offset;
+        u64 index_count;
+        u64 meshlet_offset;
+        u64 meshlet_count;
+        // Albedo, metallic and normal texture names relative to the model directory, as offsets into the string table
+        u32 textures[3];
+        u32 lod_count;
+        MeshLod lods[max_lods];
+        u32 padding;
+    };
+
+    // Pointers into the mapped file
+    struct File {
+        util::MappedFile mapping{};
+        const Header* header{};
+        const SubMesh* submeshes{};
+        const Vertex* vertices{};
+        const u32* indices{};
+        const Meshlet* meshlets{};
+        const char* strings{};
+    };
+
+    // The source path with its extension replaced by .tmesh
+    [[nodiscard]] std::string baked_path(const std::string&);
+    // True when the baked file exists and was made from the current source with this version of the format, or
+    // from any source when the source is missing
+    [[nodiscard]] bool up_to_date(const std::string&);
+    void bake(const std::string&, const std::string&);
+
+    // Throws when any section or submesh range reaches past the end of the file
+    [[nodiscard]] File open(const std::string&);
+    void close(File&);
+} // namespace tethys::tmesh
+
+#endif //TETHYS_TMESH_HPP
@@ -13,6 +13,9 @@
 #elif __linux__
     #include <dlfcn.h>
     #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
 #endif
 
 #include <type_traits>
@@ -39,6 +42,20 @@ namespace tethys::util {
     Funct load_symbol(void* handle, const char* symbol);
     void close_module(void*);
 #endif
+
+    // Read-only view of a whole file
+    struct MappedFile {
+        const u8* data{};
+        usize size{};
+#if _WIN32
+        HANDLE file{};
+        HANDLE mapping{};
+#endif
+    };
+
+    [[nodiscard]] MappedFile map_file(const char*);
+    void unmap_file(MappedFile&);
+
     template <typename ...Args>
     [[nodiscard]] std::string format(const std::string& str, Args&& ...args) {
         /* Check if argument count and format specifiers match */ {
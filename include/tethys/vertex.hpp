@@ -1,6 +1,8 @@
 #ifndef TETHYS_VERTEX_HPP
 #define TETHYS_VERTEX_HPP
 
+#include <tethys/types.hpp>
+
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
 
@@ -12,6 +14,22 @@ namespace tethys {
         glm::vec3 tangent;
         glm::vec3 bitangent;
     };
+
+    // 20 byte vertex. Position is quantised to the mesh bounds, w holds the bitangent sign.
+    // Normal and tangent are octahedral encoded, the bitangent is rebuilt as cross(normal, tangent) * sign
+    struct PackedVertex {
+        u16 pos[4];
+        i16 norms[2];
+        i16 tangent[2];
+        u16 uvs[2];
+    };
+
+    static_assert(sizeof(PackedVertex) == 20);
+
+    // Bounds the positions are quantised against, see DrawData::position_min
+    [[nodiscard]] PackedVertex pack_vertex(const Vertex&, const glm::vec3&, const glm::vec3&);
+    // Inverse of pack_vertex up to quantisation, the bitangent comes back as cross(normal, tangent) * sign
+    [[nodiscard]] Vertex unpack_vertex(const PackedVertex&, const glm::vec3&, const glm::vec3&);
 } // namespace tethys
 
 #endif //TETHYS_VERTEX_HPP
@@ -0,0 +1,76 @@
+#version 460
+#extension GL_EXT_nonuniform_qualifier : enable
+
+layout (location = 0) in vertex_out {
+    vec3 vertex_pos;
+    vec3 frag_pos;
+    vec2 uvs;
+    vec3 view_pos;
+    vec3 normals;
+};
+layout (location = 5) flat in uint draw_index;
+
+// Must match the tethys::api::GBuffer formats
+layout (location = 0) out vec4 albedo_occlusion;
+layout (location = 1) out vec4 normal_material;
+
+struct DrawData {
+    uint transform_index;
+    uint albedo_index;
+    uint metallic_index;
+    uint normal_index;
+    uint roughness_index;
+    uint occlusion_index;
+    float position_min[3];
+    float position_extent[3];
+};
+
+layout (std430, set = 0, binding = 2) buffer readonly Draws {
+    DrawData[] draws;
+};
+
+layout (set = 0, binding = 4) uniform sampler2D[] textures;
+
+vec3 process_normal_map(vec3 normal_map);
+vec2 oct_encode(vec3 n);
+
+void main() {
+    DrawData draw = draws[draw_index];
+
+    vec3 albedo = texture(textures[nonuniformEXT(draw.albedo_index)], uvs).rgb;
+    float metallic = texture(textures[nonuniformEXT(draw.metallic_index)], uvs).r;
+    vec3 norms = process_normal_map(texture(textures[nonuniformEXT(draw.normal_index)], uvs).xyz);
+    float roughness = texture(textures[nonuniformEXT(draw.roughness_index)], uvs).r;
+    float occlusion = texture(textures[nonuniformEXT(draw.occlusion_index)], uvs).r;
+
+    albedo_occlusion = vec4(albedo, occlusion);
+    normal_material = vec4(oct_encode(norms), metallic, roughness);
+}
+
+vec3 process_normal_map(vec3 normal_map) {
+    vec3 tangent_normal = normal_map * 2.0 - 1.0;
+
+    vec3 Q1 = dFdx(frag_pos);
+    vec3 Q2 = dFdy(frag_pos);
+    vec2 st1 = dFdx(uvs);
+    vec2 st2 = dFdy(uvs);
+
+    vec3 N = normalize(normals);
+    vec3 T = normalize(Q1 * st2.t - Q2 * st1.t);
+    vec3 B = -normalize(cross(N, T));
+    mat3 TBN = mat3(T, B, N);
+
+    return normalize(TBN * tangent_normal);
+}
+
+// Same octahedral mapping as vertex.cpp, decoded by the lighting pass
+vec2 oct_encode(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.xy;
+
+    if (n.z < 0.0) {
+        e = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return e;
+}
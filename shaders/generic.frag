@@ -11,6 +11,7 @@ layout (location = 0) in vertex_out {
     vec3 normals;
     mat3 TBN;
 };
+layout (location = 8) flat in uint draw_index;
 
 layout (location = 0) out vec4 frag_color;
 
@@ -28,7 +29,22 @@ struct DirectionalLight {
     vec4 color;
 };
 
-layout (set = 0, binding = 2) uniform sampler2D[] textures;
+struct DrawData {
+    uint transform_index;
+    uint albedo_index;
+    uint metallic_index;
+    uint normal_index;
+    uint roughness_index;
+    uint occlusion_index;
+    float position_min[3];
+    float position_extent[3];
+};
+
+layout (std430, set = 0, binding = 2) buffer readonly Draws {
+    DrawData[] draws;
+};
+
+layout (set = 0, binding = 4) uniform sampler2D[] textures;
 
 layout (std430, set = 1, binding = 0) buffer readonly PointLights {
     PointLight[] point_lights;
@@ -38,35 +54,53 @@ layout (std430, set = 1, binding = 1) buffer readonly DirectionalLights {
     DirectionalLight[] directional_lights;
 };
 
+layout (std430, set = 1, binding = 2) buffer readonly LightClusters {
+    uint[] cluster_lights;
+};
+
+layout (std430, set = 1, binding = 3) buffer readonly LightIndices {
+    uint[] light_indices;
+};
+
 layout (push_constant) uniform Constants {
-    uint transform_index;
-    uint albedo_index;
-    uint specular_index;
-    uint normal_index;
     uint point_lights_count;
     uint directional_lights_count;
+    float near;
+    float far;
+    vec2 tile_size;
 };
 
+// Must match tethys::cluster
+const uvec3 cluster_count = uvec3(16, 9, 24);
+const uint max_cluster_lights = 128;
+
+uint cluster_index();
+
 vec3 apply_point_light(PointLight light, vec3 color, vec3 specular, vec3 normal, vec3 view_dir);
 vec3 apply_directional_light(DirectionalLight light, vec3 color, vec3 specular, vec3 normal, vec3 view_dir);
 
 void main() {
     vec3 result = vec3(1.0);
 
-    vec3 albedo = texture(textures[albedo_index], uvs).rgb;
-    vec3 specular = texture(textures[specular_index], uvs).rgb;
+    DrawData draw = draws[draw_index];
+
+    vec3 albedo = texture(textures[nonuniformEXT(draw.albedo_index)], uvs).rgb;
+    vec3 specular = texture(textures[nonuniformEXT(draw.metallic_index)], uvs).rgb;
     vec3 normal = normals;
 
-    if (normal_index != 2) {
-        normal = normalize(TBN * (2.0 * texture(textures[normal_index], uvs).rgb - 1.0));
+    if (draw.normal_index != 2) {
+        normal = normalize(TBN * (2.0 * texture(textures[nonuniformEXT(draw.normal_index)], uvs).rgb - 1.0));
     }
 
     result = albedo * ambient;
 
     vec3 view_dir = normalize(view_pos - frag_pos);
 
-    for (uint i = 0; i < point_lights_count; ++i) {
-        result += apply_point_light(point_lights[i], albedo, specular, normal, view_dir);
+    uint cluster = cluster_index();
+    uint cluster_offset = cluster * max_cluster_lights;
+
+    for (uint i = 0; i < cluster_lights[cluster]; ++i) {
+        result += apply_point_light(point_lights[light_indices[cluster_offset + i]], albedo, specular, normal, view_dir);
     }
 
     for (uint i = 0; i < directional_lights_count; ++i) {
@@ -76,6 +110,18 @@ void main() {
     frag_color = vec4(result, 1.0);
 }
 
+// Froxel containing this fragment, depth is sliced exponentially between the near and far planes
+uint cluster_index() {
+    float depth = near * far / (far - gl_FragCoord.z * (far - near));
+    uint slice = uint(max(log(depth / near) / log(far / near) * float(cluster_count.z), 0.0));
+    uvec2 tile = uvec2(gl_FragCoord.xy / tile_size);
+
+    tile = min(tile, cluster_count.xy - 1);
+    slice = min(slice, cluster_count.z - 1);
+
+    return tile.x + tile.y * cluster_count.x + slice * cluster_count.x * cluster_count.y;
+}
+
 vec3 apply_point_light(PointLight light, vec3 color, vec3 specular, vec3 normal, vec3 view_dir) {
     vec3 light_dir = normalize(vec3(light.position) - frag_pos);
 
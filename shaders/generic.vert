@@ -1,6 +1,6 @@
 #version 460
 
-layout (location = 0) in vec3 ivertex_pos;
+layout (location = 0) in vec4 ivertex_pos;
 layout (location = 1) in vec3 inormals;
 layout (location = 2) in vec2 iuvs;
 layout (location = 3) in vec3 itangents;
@@ -14,6 +14,24 @@ layout (location = 0) out vertex_out {
     vec3 normals;
     mat3 TBN;
 };
+layout (location = 8) flat out uint draw_index;
+
+// Matches the depth pre-pass bit for bit
+invariant gl_Position;
+
+// Set by the pipeline when the vertices are tethys::PackedVertex
+layout (constant_id = 0) const bool packed_vertices = false;
+
+struct DrawData {
+    uint transform_index;
+    uint albedo_index;
+    uint metallic_index;
+    uint normal_index;
+    uint roughness_index;
+    uint occlusion_index;
+    float position_min[3];
+    float position_extent[3];
+};
 
 layout (set = 0, binding = 0) uniform Camera {
     mat4 proj;
@@ -25,27 +43,55 @@ layout (set = 0, binding = 1) buffer readonly Transform {
     mat4[] transforms;
 };
 
-layout (push_constant) uniform Constants {
-    uint transform_index;
-    uint albedo_index;
-    uint specular_index;
-    uint normal_index;
-    uint point_lights_count;
-    uint directional_lights_count;
+layout (std430, set = 0, binding = 2) buffer readonly Draws {
+    DrawData[] draws;
+};
+
+// Draw index of every instance, filled in by the culling pass. gl_InstanceIndex already includes firstInstance
+layout (std430, set = 0, binding = 3) buffer readonly Instances {
+    uint[] instances;
 };
 
+// Positions are quantised to the mesh bounds, unpacked meshes use a zero min and unit extent
+vec3 dequantise(uint index, vec3 position) {
+    DrawData draw = draws[index];
+    return vec3(draw.position_min[0], draw.position_min[1], draw.position_min[2]) +
+        position * vec3(draw.position_extent[0], draw.position_extent[1], draw.position_extent[2]);
+}
+
+// Inverse of the octahedral mapping in vertex.cpp
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
 void main() {
-    mat4 model = transforms[transform_index];
+    draw_index = instances[gl_InstanceIndex];
+    mat4 model = transforms[draws[draw_index].transform_index];
+
+    vec3 position = dequantise(draw_index, ivertex_pos.xyz);
+    vec3 normal = inormals;
+    vec3 tangent = itangents;
+    vec3 bitangent = ibi_tangents;
+
+    // The bitangent is rebuilt from the handedness stored in position.w
+    if (packed_vertices) {
+        normal = oct_decode(inormals.xy);
+        tangent = oct_decode(itangents.xy);
+        bitangent = cross(normal, tangent) * (ivertex_pos.w * 2.0 - 1.0);
+    }
 
-    vec3 T = normalize(vec3(model * vec4(itangents, 0.0)));
-    vec3 B = normalize(vec3(model * vec4(ibi_tangents, 0.0)));
-    vec3 N = normalize(vec3(model * vec4(inormals, 0.0)));
+    vec3 T = normalize(vec3(model * vec4(tangent, 0.0)));
+    vec3 B = normalize(vec3(model * vec4(bitangent, 0.0)));
+    vec3 N = normalize(vec3(model * vec4(normal, 0.0)));
 
     TBN = mat3(T, B, N);
-    vertex_pos = ivertex_pos;
-    frag_pos = vec3(model * vec4(ivertex_pos, 1.0));
+    vertex_pos = position;
+    frag_pos = vec3(model * vec4(position, 1.0));
     uvs = iuvs;
     view_pos = vec3(camera.pos);
-    normals = inormals;
+    normals = normal;
     gl_Position = camera.proj * camera.view * vec4(frag_pos, 1.0);
 }
\ No newline at end of file
@@ -2,16 +2,27 @@
 #extension GL_EXT_nonuniform_qualifier : enable
 
 layout (location = 0) in vec2 uvs;
+layout (location = 1) flat in uint draw_index;
 
 layout (location = 0) out vec4 frag_color;
 
-layout (set = 0, binding = 2) uniform sampler2D[] textures;
-
-layout (push_constant) uniform Constants {
+struct DrawData {
     uint transform_index;
     uint albedo_index;
+    uint metallic_index;
+    uint normal_index;
+    uint roughness_index;
+    uint occlusion_index;
+    float position_min[3];
+    float position_extent[3];
+};
+
+layout (std430, set = 0, binding = 2) buffer readonly Draws {
+    DrawData[] draws;
 };
 
+layout (set = 0, binding = 4) uniform sampler2D[] textures;
+
 void main() {
-    frag_color = vec4(texture(textures[albedo_index], uvs).rgb, 1.0);
+    frag_color = vec4(texture(textures[nonuniformEXT(draws[draw_index].albedo_index)], uvs).rgb, 1.0);
 }
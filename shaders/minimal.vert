@@ -1,12 +1,30 @@
 #version 460
 
-layout (location = 0) in vec3 ivertex_pos;
+layout (location = 0) in vec4 ivertex_pos;
 layout (location = 1) in vec3 inormals;
 layout (location = 2) in vec2 iuvs;
 layout (location = 3) in vec3 itangents;
 layout (location = 4) in vec3 ibi_tangents;
 
 layout (location = 0) out vec2 uvs;
+layout (location = 1) flat out uint draw_index;
+
+// Matches the depth pre-pass bit for bit
+invariant gl_Position;
+
+// Set by the pipeline when the vertices are tethys::PackedVertex
+layout (constant_id = 0) const bool packed_vertices = false;
+
+struct DrawData {
+    uint transform_index;
+    uint albedo_index;
+    uint metallic_index;
+    uint normal_index;
+    uint roughness_index;
+    uint occlusion_index;
+    float position_min[3];
+    float position_extent[3];
+};
 
 layout (set = 0, binding = 0) uniform Camera {
     mat4 proj;
@@ -18,12 +36,27 @@ layout (set = 0, binding = 1) buffer readonly Transform {
     mat4[] transforms;
 };
 
-layout (push_constant) uniform Constants {
-    uint transform_index;
-    uint albedo_index;
+layout (std430, set = 0, binding = 2) buffer readonly Draws {
+    DrawData[] draws;
+};
+
+// Draw index of every instance, filled in by the culling pass. gl_InstanceIndex already includes firstInstance
+layout (std430, set = 0, binding = 3) buffer readonly Instances {
+    uint[] instances;
 };
 
+// Positions are quantised to the mesh bounds, unpacked meshes use a zero min and unit extent
+vec3 dequantise(uint index, vec3 position) {
+    DrawData draw = draws[index];
+    return vec3(draw.position_min[0], draw.position_min[1], draw.position_min[2]) +
+        position * vec3(draw.position_extent[0], draw.position_extent[1], draw.position_extent[2]);
+}
+
 void main() {
+    draw_index = instances[gl_InstanceIndex];
+    mat4 model = transforms[draws[draw_index].transform_index];
+    vec3 frag_pos = vec3(model * vec4(dequantise(draw_index, ivertex_pos.xyz), 1.0));
+
     uvs = iuvs;
-    gl_Position = camera.proj * camera.view * transforms[transform_index] * vec4(ivertex_pos, 1.0);
+    gl_Position = camera.proj * camera.view * vec4(frag_pos, 1.0);
 }
\ No newline at end of file
@@ -11,6 +11,7 @@ layout (location = 0) in vertex_out {
     vec3 view_pos;
     vec3 normals;
 };
+layout (location = 5) flat in uint draw_index;
 
 layout (location = 0) out vec4 frag_color;
 
@@ -28,7 +29,22 @@ struct DirectionalLight {
     vec4 color;
 };
 
-layout (set = 0, binding = 2) uniform sampler2D[] textures;
+struct DrawData {
+    uint transform_index;
+    uint albedo_index;
+    uint metallic_index;
+    uint normal_index;
+    uint roughness_index;
+    uint occlusion_index;
+    float position_min[3];
+    float position_extent[3];
+};
+
+layout (std430, set = 0, binding = 2) buffer readonly Draws {
+    DrawData[] draws;
+};
+
+layout (set = 0, binding = 4) uniform sampler2D[] textures;
 
 layout (std140, set = 1, binding = 0) buffer readonly PointLights {
     PointLight[] point_lights;
@@ -38,17 +54,28 @@ layout (std140, set = 1, binding = 1) buffer readonly DirectionalLights {
     DirectionalLight[] directional_lights;
 };
 
+layout (std430, set = 1, binding = 2) buffer readonly LightClusters {
+    uint[] cluster_lights;
+};
+
+layout (std430, set = 1, binding = 3) buffer readonly LightIndices {
+    uint[] light_indices;
+};
+
 layout (push_constant) uniform Constants {
-    uint transform_index;
-    uint albedo_index;
-    uint metallic_index;
-    uint normal_index;
-    uint roughness_index;
-    uint occlusion_index;
     uint point_lights_count;
     uint directional_lights_count;
+    float near;
+    float far;
+    vec2 tile_size;
 };
 
+// Must match tethys::cluster
+const uvec3 cluster_count = uvec3(16, 9, 24);
+const uint max_cluster_lights = 128;
+
+uint cluster_index();
+
 vec3 process_normal_map(vec3 normal_map);
 float process_ggx_distribution(vec3 N, vec3 H, float roughness);
 float process_geometry_schlick_ggx(float NV, float roughness);
@@ -58,20 +85,25 @@ vec3 fresnel_schlick(float cos_theta, vec3 F0);
 void main() {
     vec3 result = vec3(1.0);
 
-    vec3 albedo = texture(textures[albedo_index], uvs).rgb;
-    float metallic = texture(textures[metallic_index], uvs).r;
-    vec3 norms = process_normal_map(texture(textures[normal_index], uvs).xyz);
-    float roughness = texture(textures[roughness_index], uvs).r;
-    float occlusion = texture(textures[occlusion_index], uvs).r;
+    DrawData draw = draws[draw_index];
+
+    vec3 albedo = texture(textures[nonuniformEXT(draw.albedo_index)], uvs).rgb;
+    float metallic = texture(textures[nonuniformEXT(draw.metallic_index)], uvs).r;
+    vec3 norms = process_normal_map(texture(textures[nonuniformEXT(draw.normal_index)], uvs).xyz);
+    float roughness = texture(textures[nonuniformEXT(draw.roughness_index)], uvs).r;
+    float occlusion = texture(textures[nonuniformEXT(draw.occlusion_index)], uvs).r;
 
     vec3 V = normalize(view_pos - frag_pos);
 
     vec3 F0 = vec3(0.04);
     F0 = mix(F0, albedo, metallic);
 
+    uint cluster = cluster_index();
+    uint cluster_offset = cluster * max_cluster_lights;
+
     vec3 Lo = vec3(0.0);
-    for (uint i = 0; i < point_lights_count; ++i) {
-        PointLight light = point_lights[i];
+    for (uint i = 0; i < cluster_lights[cluster]; ++i) {
+        PointLight light = point_lights[light_indices[cluster_offset + i]];
 
         // Per-light radiance
         vec3 L = normalize(vec3(light.position) - frag_pos);
@@ -100,6 +132,18 @@ void main() {
     frag_color = vec4(color, 1.0);
 }
 
+// Froxel containing this fragment, depth is sliced exponentially between the near and far planes
+uint cluster_index() {
+    float depth = near * far / (far - gl_FragCoord.z * (far - near));
+    uint slice = uint(max(log(depth / near) / log(far / near) * float(cluster_count.z), 0.0));
+    uvec2 tile = uvec2(gl_FragCoord.xy / tile_size);
+
+    tile = min(tile, cluster_count.xy - 1);
+    slice = min(slice, cluster_count.z - 1);
+
+    return tile.x + tile.y * cluster_count.x + slice * cluster_count.x * cluster_count.y;
+}
+
 vec3 process_normal_map(vec3 normal_map) {
     vec3 tangent_normal = normal_map * 2.0 - 1.0;
 
@@ -0,0 +1,9 @@
+#version 460
+
+layout (location = 0) flat in uint triangle_base;
+
+layout (location = 0) out uint triangle_id;
+
+void main() {
+    triangle_id = triangle_base + gl_PrimitiveID;
+}
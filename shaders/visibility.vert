@@ -0,0 +1,87 @@
+#version 460
+
+layout (location = 0) in vec4 ivertex_pos;
+
+// First triangle ID of the level of detail this instance is drawn with, gl_PrimitiveID is added per fragment
+layout (location = 0) flat out uint triangle_base;
+
+// Set by the pipeline when the vertices are tethys::PackedVertex
+layout (constant_id = 0) const bool packed_vertices = false;
+
+// Must match tethys::max_lods
+const uint max_lods = 5;
+
+struct DrawData {
+    uint transform_index;
+    uint albedo_index;
+    uint metallic_index;
+    uint normal_index;
+    uint roughness_index;
+    uint occlusion_index;
+    float position_min[3];
+    float position_extent[3];
+};
+
+struct Lod {
+    uint first_index;
+    uint index_count;
+    float error;
+};
+
+struct CullData {
+    vec4 sphere;
+    uint command;
+    uint instance_slot;
+    uint lod_count;
+    uint short_indices;
+    Lod lods[max_lods];
+    uint meshlet_first;
+    uint meshlet_count;
+    uint group_size;
+    uint triangle_base;
+    int vertex_offset;
+    uint lit;
+};
+
+layout (set = 0, binding = 0) uniform Camera {
+    mat4 proj;
+    mat4 view;
+    vec4 pos;
+} camera;
+
+layout (set = 0, binding = 1) buffer readonly Transform {
+    mat4[] transforms;
+};
+
+layout (std430, set = 0, binding = 2) buffer readonly Draws {
+    DrawData[] draws;
+};
+
+// Draw index of every instance, filled in by the culling pass. gl_InstanceIndex already includes firstInstance
+layout (std430, set = 0, binding = 3) buffer readonly Instances {
+    uint[] instances;
+};
+
+layout (std430, set = 2, binding = 0) buffer readonly Cull {
+    CullData[] cull_data;
+};
+
+// Positions are quantised to the mesh bounds, unpacked meshes use a zero min and unit extent
+vec3 dequantise(uint index, vec3 position) {
+    DrawData draw = draws[index];
+    return vec3(draw.position_min[0], draw.position_min[1], draw.position_min[2]) +
+        position * vec3(draw.position_extent[0], draw.position_extent[1], draw.position_extent[2]);
+}
+
+void main() {
+    uint draw_index = instances[gl_InstanceIndex];
+    CullData cull = cull_data[draw_index];
+    mat4 model = transforms[draws[draw_index].transform_index];
+
+    // Each level of detail owns group_size instance slots after the group's first one, only the first culling phase
+    // is used in this mode
+    uint lod = (uint(gl_InstanceIndex) - cull.instance_slot) / cull.group_size;
+
+    triangle_base = cull.triangle_base + (cull.lods[lod].first_index - cull.lods[0].first_index) / 3;
+    gl_Position = camera.proj * camera.view * model * vec4(dequantise(draw_index, ivertex_pos.xyz), 1.0);
+}
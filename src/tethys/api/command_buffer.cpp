@@ -20,36 +20,17 @@ namespace tethys::api {
         return buffers;
     }
 
-    vk::CommandBuffer begin_transient() {
-        vk::CommandBufferAllocateInfo command_buffer_allocate_info{}; {
-            command_buffer_allocate_info.commandBufferCount = 1;
-            command_buffer_allocate_info.level = vk::CommandBufferLevel::ePrimary;
-            command_buffer_allocate_info.commandPool = context.transient_pool;
-        }
-
-        auto command_buffers = context.device.logical.allocateCommandBuffers(command_buffer_allocate_info, context.dispatcher);
-
-        vk::CommandBufferBeginInfo begin_info{}; {
-            begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
-        }
-
-        command_buffers[0].begin(begin_info, context.dispatcher);
-
-        return command_buffers[0];
-    }
-
-    void end_transient(const vk::CommandBuffer command_buffer) {
-        command_buffer.end(context.dispatcher);
-
-        vk::SubmitInfo submit_info{}; {
-            submit_info.commandBufferCount = 1;
-            submit_info.pCommandBuffers = &command_buffer;
+    std::vector<vk::CommandBuffer> make_secondary_command_buffers(const vk::CommandPool pool) {
+        vk::CommandBufferAllocateInfo allocate_info{}; {
+            allocate_info.commandPool = pool;
+            allocate_info.commandBufferCount = context.swapchain.image_count;
+            allocate_info.level = vk::CommandBufferLevel::eSecondary;
         }
 
-        context.device.queue.submit(submit_info, nullptr, context.dispatcher);
+        auto buffers = context.device.logical.allocateCommandBuffers(allocate_info, context.dispatcher);
 
-        context.device.queue.waitIdle(context.dispatcher);
+        logger::info("Created {} secondary command buffers for rendering", allocate_info.commandBufferCount);
 
-        context.device.logical.freeCommandBuffers(context.transient_pool, command_buffer, context.dispatcher);
+        return buffers;
     }
 } // namespace tethys::api
\ No newline at end of file
@@ -19,9 +19,9 @@ namespace tethys::api {
         return pool;
     }
 
-    vk::CommandPool make_transient_pool() {
+    vk::CommandPool make_transient_pool(const u32 family) {
         vk::CommandPoolCreateInfo command_pool_create_info{}; {
-            command_pool_create_info.queueFamilyIndex = context.device.family;
+            command_pool_create_info.queueFamilyIndex = family;
             command_pool_create_info.flags =
                 vk::CommandPoolCreateFlagBits::eResetCommandBuffer |
                 vk::CommandPoolCreateFlagBits::eTransient;
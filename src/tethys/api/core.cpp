@@ -92,7 +92,8 @@ namespace tethys::api {
         context.surface = tethys::window::surface();
         context.device = make_device();
         context.command_pool = make_command_pool();
-        context.transient_pool = make_transient_pool();
+        context.transient_pool = make_transient_pool(context.device.family);
+        context.transfer_pool = make_transient_pool(context.device.transfer_family);
         load_vma();
         context.allocator = make_allocator();
         context.swapchain = make_swapchain();
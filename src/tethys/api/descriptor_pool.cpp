@@ -7,10 +7,11 @@
 
 namespace tethys::api {
     vk::DescriptorPool make_descriptor_pool() {
-        std::array<vk::DescriptorPoolSize, 3> descriptor_pool_sizes{ {
+        std::array<vk::DescriptorPoolSize, 4> descriptor_pool_sizes{ {
             { vk::DescriptorType::eCombinedImageSampler, 1000 },
             { vk::DescriptorType::eUniformBuffer, 100000 },
             { vk::DescriptorType::eStorageBuffer, 100000 },
+            { vk::DescriptorType::eStorageImage, 1000 },
         } };
 
         vk::DescriptorPoolCreateInfo descriptor_pool_create_info{}; {
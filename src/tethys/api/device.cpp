@@ -36,17 +36,24 @@ namespace tethys::api {
      [[nodiscard]] static vk::PhysicalDevice get_physical_device() {
         auto physical_devices = context.instance.enumeratePhysicalDevices(context.dispatcher);
 
+        // Software rasterizers (lavapipe, llvmpipe) are only picked when no hardware device is suitable
+        std::stable_partition(physical_devices.begin(), physical_devices.end(), [](const vk::PhysicalDevice& device) {
+            return device.getProperties(context.dispatcher).deviceType != vk::PhysicalDeviceType::eCpu;
+        });
+
         for (const auto& device : physical_devices) {
             auto device_properties = device.getProperties(context.dispatcher);
             auto device_features = device.getFeatures(context.dispatcher);
 
             if ((device_properties.deviceType == vk::PhysicalDeviceType::eDiscreteGpu  ||
                  device_properties.deviceType == vk::PhysicalDeviceType::eIntegratedGpu ||
-                 device_properties.deviceType == vk::PhysicalDeviceType::eVirtualGpu) &&
+                 device_properties.deviceType == vk::PhysicalDeviceType::eVirtualGpu ||
+                 device_properties.deviceType == vk::PhysicalDeviceType::eCpu) &&
 
                 device_features.shaderSampledImageArrayDynamicIndexing &&
                 device_features.samplerAnisotropy &&
-                device_features.multiDrawIndirect) {
+                device_features.multiDrawIndirect &&
+                device_features.drawIndirectFirstInstance) {
 
                 auto major = device_properties.apiVersion >> 22u;
                 auto minor = device_properties.apiVersion >> 12u & 0x3ffu;
@@ -74,36 +81,68 @@ namespace tethys::api {
         throw std::runtime_error("Failed to find a queue family");
     }
 
-    [[nodiscard]] static vk::Device get_device(const u32 queue_family, const vk::PhysicalDevice& physical_device, const vk::DispatchLoaderDynamic& dispatcher) {
-        using namespace std::string_literals;
+    // Transfer-only families map to the copy engines, buffers and images are shared concurrently with them
+    [[nodiscard]] static u32 get_transfer_family(const vk::PhysicalDevice& physical_device, const u32 graphics_family, const vk::DispatchLoaderDynamic& dispatcher) {
+        auto queue_family_properties = physical_device.getQueueFamilyProperties({}, dispatcher);
+
+        for (u32 i = 0; i < queue_family_properties.size(); ++i) {
+            const auto flags = queue_family_properties[i].queueFlags;
+
+            if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & vk::QueueFlagBits::eGraphics) && !(flags & vk::QueueFlagBits::eCompute)) {
+                return i;
+            }
+        }
+
+        return graphics_family;
+    }
+
+    [[nodiscard]] static bool has_extension(const vk::PhysicalDevice& physical_device, const char* name, const vk::DispatchLoaderDynamic& dispatcher) {
         auto extensions = physical_device.enumerateDeviceExtensionProperties(nullptr, {}, dispatcher);
 
-        constexpr std::array enabled_exts{
+        return std::any_of(extensions.begin(), extensions.end(), [name](const vk::ExtensionProperties& properties) {
+            return std::strcmp(properties.extensionName, name) == 0;
+        });
+    }
+
+    [[nodiscard]] static vk::Device get_device(const u32 queue_family, const u32 transfer_family, const vk::PhysicalDevice& physical_device, const bool pipeline_statistics, const bool primitive_id, const bool draw_indirect_count, const vk::DispatchLoaderDynamic& dispatcher) {
+        constexpr std::array required_exts{
             VK_KHR_SWAPCHAIN_EXTENSION_NAME,
             VK_KHR_BIND_MEMORY_2_EXTENSION_NAME,
             VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME
         };
 
-        if (!std::all_of(enabled_exts.begin(), enabled_exts.end(), [&extensions](const char* required_name) {
-            return std::any_of(extensions.begin(), extensions.end(), [required_name](const vk::ExtensionProperties& properties) {
-                return std::strcmp(properties.extensionName, required_name) == 0;
-            });
+        if (!std::all_of(required_exts.begin(), required_exts.end(), [&physical_device, &dispatcher](const char* required_name) {
+            return has_extension(physical_device, required_name, dispatcher);
         })) {
             throw std::runtime_error("Required device extension not supported");
         }
 
+        std::vector<const char*> enabled_exts{ required_exts.begin(), required_exts.end() };
+
+        if (draw_indirect_count) {
+            enabled_exts.emplace_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        }
+
         float priorities[]{ 1.0f };
 
-        vk::DeviceQueueCreateInfo queue_create_info{}; {
-            queue_create_info.queueCount = 1;
-            queue_create_info.queueFamilyIndex = queue_family;
-            queue_create_info.pQueuePriorities = priorities;
+        std::array<vk::DeviceQueueCreateInfo, 2> queue_create_infos{}; {
+            queue_create_infos[0].queueCount = 1;
+            queue_create_infos[0].queueFamilyIndex = queue_family;
+            queue_create_infos[0].pQueuePriorities = priorities;
+
+            queue_create_infos[1].queueCount = 1;
+            queue_create_infos[1].queueFamilyIndex = transfer_family;
+            queue_create_infos[1].pQueuePriorities = priorities;
         }
 
         vk::PhysicalDeviceFeatures features{}; {
             features.samplerAnisotropy = true;
             features.multiDrawIndirect = true;
+            features.drawIndirectFirstInstance = true;
             features.sampleRateShading = true;
+            features.pipelineStatisticsQuery = pipeline_statistics;
+            features.inheritedQueries = pipeline_statistics;
+            features.geometryShader = primitive_id;
         }
 
         vk::PhysicalDeviceDescriptorIndexingFeatures descriptor_indexing_features{}; {
@@ -122,8 +161,8 @@ namespace tethys::api {
             device_create_info.pNext = &ray_tracing_features;
             device_create_info.ppEnabledExtensionNames = enabled_exts.data();
             device_create_info.enabledExtensionCount = enabled_exts.size();
-            device_create_info.pQueueCreateInfos = &queue_create_info;
-            device_create_info.queueCreateInfoCount = 1;
+            device_create_info.pQueueCreateInfos = queue_create_infos.data();
+            device_create_info.queueCreateInfoCount = transfer_family != queue_family ? 2 : 1;
             device_create_info.pEnabledFeatures = &features;
         }
 
@@ -139,10 +178,30 @@ namespace tethys::api {
 
         device.physical = get_physical_device();
         device.family = get_queue_family(context.surface, device.physical, context.dispatcher);
-        device.logical = get_device(device.family, device.physical, context.dispatcher);
+        const auto features = device.physical.getFeatures(context.dispatcher);
+
+        // Secondary command buffers are executed while the query is active
+        device.pipeline_statistics = features.pipelineStatisticsQuery && features.inheritedQueries;
+        device.primitive_id = features.geometryShader;
+        device.draw_indirect_count = has_extension(device.physical, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME, context.dispatcher);
+        device.transfer_family = get_transfer_family(device.physical, device.family, context.dispatcher);
+        device.logical = get_device(device.family, device.transfer_family, device.physical, device.pipeline_statistics, device.primitive_id, device.draw_indirect_count, context.dispatcher);
         device.queue = get_queue(device.logical, device.family, context.dispatcher);
+        device.transfer_queue = get_queue(device.logical, device.transfer_family, context.dispatcher);
         device.samples = get_max_sample_count(device.physical);
 
+        if (device.transfer_family != device.family) {
+            logger::info("Using dedicated transfer queue family: {}", device.transfer_family);
+        }
+
+        if (!device.pipeline_statistics) {
+            logger::warning("Pipeline statistics queries not supported, fragment invocations will not be counted");
+        }
+
+        if (!device.draw_indirect_count) {
+            logger::warning("VK_KHR_draw_indirect_count not supported, culled draws will not be compacted");
+        }
+
         return device;
     }
 
@@ -7,8 +7,11 @@
 
 namespace tethys::api {
     vk::Framebuffer make_offscreen_framebuffer(const Offscreen& offscreen, const vk::RenderPass render_pass) {
+        // Single sampled targets have no resolve attachment
+        const auto multisampled = offscreen.depth.samples != vk::SampleCountFlagBits::e1;
+
         std::array<vk::ImageView, 3> attachments{}; {
-            attachments[0] = offscreen.msaa.view;
+            attachments[0] = multisampled ? offscreen.msaa.view : offscreen.color.view;
             attachments[1] = offscreen.depth.view;
             attachments[2] = offscreen.color.view;
         }
@@ -18,7 +21,7 @@ namespace tethys::api {
             framebuffer_create_info.height = offscreen.color.height;
             framebuffer_create_info.width = offscreen.color.width;
             framebuffer_create_info.layers = 1;
-            framebuffer_create_info.attachmentCount = attachments.size();
+            framebuffer_create_info.attachmentCount = multisampled ? attachments.size() : 2;
             framebuffer_create_info.pAttachments = attachments.data();
         }
 
@@ -28,4 +31,49 @@ namespace tethys::api {
 
         return framebuffer;
     }
+
+    vk::Framebuffer make_gbuffer_framebuffer(const GBuffer& gbuffer, const vk::RenderPass render_pass) {
+        std::array<vk::ImageView, 3> attachments{}; {
+            attachments[0] = gbuffer.albedo.view;
+            attachments[1] = gbuffer.normal.view;
+            attachments[2] = gbuffer.depth.view;
+        }
+
+        vk::FramebufferCreateInfo framebuffer_create_info{}; {
+            framebuffer_create_info.renderPass = render_pass;
+            framebuffer_create_info.height = gbuffer.albedo.height;
+            framebuffer_create_info.width = gbuffer.albedo.width;
+            framebuffer_create_info.layers = 1;
+            framebuffer_create_info.attachmentCount = attachments.size();
+            framebuffer_create_info.pAttachments = attachments.data();
+        }
+
+        auto framebuffer = context.device.logical.createFramebuffer(framebuffer_create_info, nullptr, context.dispatcher);
+
+        logger::info("Framebuffer successfully created with G-buffer renderpass");
+
+        return framebuffer;
+    }
+
+    vk::Framebuffer make_visibility_framebuffer(const VisibilityBuffer& visibility, const vk::RenderPass render_pass) {
+        std::array<vk::ImageView, 2> attachments{}; {
+            attachments[0] = visibility.ids.view;
+            attachments[1] = visibility.depth.view;
+        }
+
+        vk::FramebufferCreateInfo framebuffer_create_info{}; {
+            framebuffer_create_info.renderPass = render_pass;
+            framebuffer_create_info.height = visibility.ids.height;
+            framebuffer_create_info.width = visibility.ids.width;
+            framebuffer_create_info.layers = 1;
+            framebuffer_create_info.attachmentCount = attachments.size();
+            framebuffer_create_info.pAttachments = attachments.data();
+        }
+
+        auto framebuffer = context.device.logical.createFramebuffer(framebuffer_create_info, nullptr, context.dispatcher);
+
+        logger::info("Framebuffer successfully created with visibility buffer renderpass");
+
+        return framebuffer;
+    }
 } // namespace tethys::api
\ No newline at end of file
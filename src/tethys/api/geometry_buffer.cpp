@@ -0,0 +1,257 @@
+#include <tethys/api/geometry_buffer.hpp>
+#include <tethys/api/static_buffer.hpp>
+#include <tethys/api/context.hpp>
+#include <tethys/api/upload.hpp>
+#include <tethys/vertex.hpp>
+#include <tethys/mesh.hpp>
+#include <tethys/logger.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace tethys::api {
+    constexpr usize initial_meshlets = 1u << 14u;
+
+    [[nodiscard]] static StaticBuffer make_arena(const usize size, const vk::BufferUsageFlags usage) {
+        return make_buffer(
+            size,
+            vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst | usage,
+            VMA_MEMORY_USAGE_GPU_ONLY,
+            VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT,
+            true);
+    }
+
+    static void grow(StaticBuffer& buffer, usize& capacity, const usize used, const usize required, const usize stride) {
+        if (required <= capacity) {
+            return;
+        }
+
+        const auto new_capacity = std::max(capacity * 2, required);
+        auto new_buffer = make_arena(new_capacity * stride, buffer.flags);
+
+        if (used != 0) {
+            // Pending uploads into the old arena have to land before it is copied
+            wait_upload(flush_uploads());
+            wait_upload(copy_buffer(buffer.handle, new_buffer.handle, used * stride));
+        }
+
+        // The old arena may still be referenced by frames in flight
+        context.device.logical.waitIdle(context.dispatcher);
+        destroy_buffer(buffer);
+
+        logger::info("Geometry arena grown from {} to {} elements", capacity, new_capacity);
+
+        buffer = new_buffer;
+        capacity = new_capacity;
+    }
+
+    GeometryBuffer make_geometry_buffer(const usize vertex_capacity, const usize index_capacity, const bool packed, const usize scratch) {
+        GeometryBuffer geometry{}; {
+            geometry.packed = packed;
+            geometry.vertex_stride = packed ? sizeof(PackedVertex) : sizeof(Vertex);
+            // The packed position is the first 8 bytes of PackedVertex
+            geometry.position_stride = packed ? sizeof(PackedVertex::pos) : sizeof(glm::vec3);
+            // Also a storage buffer, the visibility buffer resolve fetches the vertices of every shaded triangle
+            geometry.vertices = make_arena(vertex_capacity * geometry.vertex_stride, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+            geometry.positions = make_arena(vertex_capacity * geometry.position_stride, vk::BufferUsageFlagBits::eVertexBuffer);
+            // Also a storage buffer, the meshlet culling pass copies surviving triangles into the scratch slots
+            geometry.indices = make_arena((scratch + index_capacity) * sizeof(u32), vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+            geometry.meshlets = make_arena(initial_meshlets * sizeof(Meshlet), vk::BufferUsageFlagBits::eStorageBuffer);
+            geometry.vertex_capacity = vertex_capacity;
+            geometry.index_capacity = scratch + index_capacity;
+            geometry.index_size = scratch;
+            geometry.meshlet_capacity = initial_meshlets;
+            geometry.scratch_size = scratch;
+        }
+
+        logger::info("Allocated {} geometry arena with capacity: {} vertices, {} indices, {} scratch indices", packed ? "packed" : "full", vertex_capacity, index_capacity, scratch);
+
+        return geometry;
+    }
+
+    GeometryRange append_geometry(GeometryBuffer& geometry, const Vertex* vertices, const usize vertex_count, const u32* indices, const usize index_count, const glm::vec3& min, const glm::vec3& extent) {
+        auto position_capacity = geometry.vertex_capacity;
+        const auto vertex_stride = geometry.vertex_stride;
+        const auto position_stride = geometry.position_stride;
+
+        grow(geometry.positions, position_capacity, geometry.vertex_size, geometry.vertex_size + vertex_count, position_stride);
+        grow(geometry.vertices, geometry.vertex_capacity, geometry.vertex_size, geometry.vertex_size + vertex_count, vertex_stride);
+        const auto short_indices = vertex_count <= max_short_vertices;
+        const auto index_slots = short_indices ? (index_count + 1) / 2 : index_count;
+
+        grow(geometry.indices, geometry.index_capacity, geometry.index_size, geometry.index_size + index_slots, sizeof(u32));
+
+        GeometryRange range{}; {
+            range.vertex_offset = geometry.vertex_size;
+            range.index_offset = short_indices ? geometry.index_size * 2 : geometry.index_size;
+            range.short_indices = short_indices;
+        }
+
+        if (vertex_count != 0 && geometry.packed) {
+            // Packed straight into staging memory
+            range.upload = upload_buffer(
+                vertex_count * vertex_stride,
+                vertex_stride,
+                geometry.vertices.handle,
+                range.vertex_offset * vertex_stride,
+                [vertices, &min, &extent](u8* mapped, const usize offset, const usize size) {
+                    const auto first = offset / sizeof(PackedVertex);
+
+                    for (usize i = 0; i < size / sizeof(PackedVertex); ++i) {
+                        const auto packed = pack_vertex(vertices[first + i], min, extent);
+                        std::memcpy(mapped + i * sizeof(PackedVertex), &packed, sizeof(PackedVertex));
+                    }
+                });
+        } else if (vertex_count != 0) {
+            range.upload = upload_buffer(vertices, vertex_count * vertex_stride, geometry.vertices.handle, range.vertex_offset * vertex_stride);
+        }
+
+        if (vertex_count != 0) {
+            // Extracted straight into staging memory, in packed arenas this is the quantised position of each vertex
+            range.upload = upload_buffer(
+                vertex_count * position_stride,
+                position_stride,
+                geometry.positions.handle,
+                range.vertex_offset * position_stride,
+                [vertices, &geometry, &min, &extent](u8* mapped, const usize offset, const usize size) {
+                    const auto stride = geometry.position_stride;
+                    const auto first = offset / stride;
+
+                    for (usize i = 0; i < size / stride; ++i) {
+                        if (geometry.packed) {
+                            const auto packed = pack_vertex(vertices[first + i], min, extent);
+                            std::memcpy(mapped + i * stride, packed.pos, stride);
+                        } else {
+                            std::memcpy(mapped + i * stride, &vertices[first + i].pos, stride);
+                        }
+                    }
+                });
+        }
+
+        if (index_count != 0 && short_indices) {
+            // Narrowed straight into staging memory
+            range.upload = upload_buffer(
+                index_count * sizeof(u16),
+                sizeof(u16),
+                geometry.indices.handle,
+                range.index_offset * sizeof(u16),
+                [indices](u8* mapped, const usize offset, const usize size) {
+                    const auto first = offset / sizeof(u16);
+
+                    for (usize i = 0; i < size / sizeof(u16); ++i) {
+                        const auto index = static_cast<u16>(indices[first + i]);
+                        std::memcpy(mapped + i * sizeof(u16), &index, sizeof(u16));
+                    }
+                });
+        } else if (index_count != 0) {
+            range.upload = upload_buffer(indices, index_count * sizeof(u32), geometry.indices.handle, range.index_offset * sizeof(u32));
+        }
+
+        geometry.vertex_size += vertex_count;
+        geometry.index_size += index_slots;
+
+        return range;
+    }
+
+    usize append_meshlets(GeometryBuffer& geometry, const Meshlet* meshlets, const usize count) {
+        const auto offset = geometry.meshlet_size;
+
+        grow(geometry.meshlets, geometry.meshlet_capacity, geometry.meshlet_size, geometry.meshlet_size + count, sizeof(Meshlet));
+
+        if (count != 0) {
+            (void)upload_buffer(meshlets, count * sizeof(Meshlet), geometry.meshlets.handle, offset * sizeof(Meshlet));
+        }
+
+        geometry.meshlet_size += count;
+
+        return offset;
+    }
+
+    std::vector<VertexData> read_geometry(const GeometryBuffer& geometry, const std::vector<GeometryRead>& reads) {
+        // Byte offset of every read's vertices inside the readback buffer, its indices follow them
+        std::vector<usize> offsets(reads.size());
+        usize total = 0;
+
+        for (usize i = 0; i < reads.size(); ++i) {
+            const auto& read = reads[i];
+            const auto index_stride = read.range.short_indices ? sizeof(u16) : sizeof(u32);
+
+            offsets[i] = total;
+
+            if (read.vertex_count != 0 && read.index_count != 0) {
+                total += read.vertex_count * geometry.vertex_stride + read.index_count * index_stride;
+            }
+        }
+
+        std::vector<VertexData> data(reads.size());
+
+        if (total == 0) {
+            return data;
+        }
+
+        auto readback = make_buffer(total, vk::BufferUsageFlagBits::eTransferDst, VMA_MEMORY_USAGE_GPU_TO_CPU, 0);
+
+        // Pending uploads into the ranges have to land before they are copied
+        wait_upload(flush_uploads());
+
+        UploadToken copied{};
+
+        for (usize i = 0; i < reads.size(); ++i) {
+            const auto& read = reads[i];
+            const auto index_stride = read.range.short_indices ? sizeof(u16) : sizeof(u32);
+            const auto vertex_bytes = read.vertex_count * geometry.vertex_stride;
+
+            if (read.vertex_count == 0 || read.index_count == 0) {
+                continue;
+            }
+
+            (void)copy_buffer(geometry.vertices.handle, readback.handle, vertex_bytes, read.range.vertex_offset * geometry.vertex_stride, offsets[i]);
+            copied = copy_buffer(geometry.indices.handle, readback.handle, read.index_count * index_stride, read.range.index_offset * index_stride, offsets[i] + vertex_bytes);
+        }
+
+        wait_upload(copied);
+
+        void* mapped{};
+        vmaMapMemory(context.allocator, readback.allocation, &mapped);
+        vmaInvalidateAllocation(context.allocator, readback.allocation, 0, VK_WHOLE_SIZE);
+
+        for (usize i = 0; i < reads.size(); ++i) {
+            const auto& read = reads[i];
+            const auto vertex_bytes = read.vertex_count * geometry.vertex_stride;
+            const auto* bytes = static_cast<const u8*>(mapped) + offsets[i];
+            auto& result = data[i];
+
+            if (read.vertex_count == 0 || read.index_count == 0) {
+                continue;
+            }
+
+            result.geometry.resize(read.vertex_count);
+            result.indices.resize(read.index_count);
+
+            if (geometry.packed) {
+                for (usize j = 0; j < read.vertex_count; ++j) {
+                    PackedVertex packed{};
+                    std::memcpy(&packed, bytes + j * sizeof(PackedVertex), sizeof(PackedVertex));
+                    result.geometry[j] = unpack_vertex(packed, read.min, read.extent);
+                }
+            } else {
+                std::memcpy(result.geometry.data(), bytes, vertex_bytes);
+            }
+
+            if (read.range.short_indices) {
+                for (usize j = 0; j < read.index_count; ++j) {
+                    u16 index{};
+                    std::memcpy(&index, bytes + vertex_bytes + j * sizeof(u16), sizeof(u16));
+                    result.indices[j] = index;
+                }
+            } else {
+                std::memcpy(result.indices.data(), bytes + vertex_bytes, read.index_count * sizeof(u32));
+            }
+        }
+
+        vmaUnmapMemory(context.allocator, readback.allocation);
+        destroy_buffer(readback);
+
+        return data;
+    }
+} // namespace tethys::api
\ No newline at end of file
@@ -1,5 +1,5 @@
-#include <tethys/api/command_buffer.hpp>
 #include <tethys/api/context.hpp>
+#include <tethys/api/upload.hpp>
 #include <tethys/api/image.hpp>
 
 namespace tethys::api {
@@ -22,6 +22,16 @@ namespace tethys::api {
             image_info.initialLayout = vk::ImageLayout::eUndefined;
             image_info.usage = info.usage_flags;
             image_info.samples = info.samples;
+        }
+
+        // Same sharing as make_buffer
+        const std::array families{ context.device.family, context.device.transfer_family };
+
+        if (info.upload && families[0] != families[1]) {
+            image_info.queueFamilyIndexCount = families.size();
+            image_info.pQueueFamilyIndices = families.data();
+            image_info.sharingMode = vk::SharingMode::eConcurrent;
+        } else {
             image_info.sharingMode = vk::SharingMode::eExclusive;
         }
 
@@ -55,7 +65,7 @@ namespace tethys::api {
         return image;
     }
 
-    vk::ImageView make_image_view(const vk::Image image, const vk::Format format, const vk::ImageAspectFlags aspect, const u32 mips) {
+    vk::ImageView make_image_view(const vk::Image image, const vk::Format format, const vk::ImageAspectFlags aspect, const u32 mips, const u32 base_mip) {
         vk::ImageViewCreateInfo image_view_create_info{}; {
             image_view_create_info.image = image;
             image_view_create_info.format = format;
@@ -65,7 +75,7 @@ namespace tethys::api {
             image_view_create_info.components.a = vk::ComponentSwizzle::eIdentity;
             image_view_create_info.viewType = vk::ImageViewType::e2D;
             image_view_create_info.subresourceRange.aspectMask = aspect;
-            image_view_create_info.subresourceRange.baseMipLevel = 0;
+            image_view_create_info.subresourceRange.baseMipLevel = base_mip;
             image_view_create_info.subresourceRange.levelCount = mips;
             image_view_create_info.subresourceRange.baseArrayLayer = 0;
             image_view_create_info.subresourceRange.layerCount = 1;
@@ -75,7 +85,7 @@ namespace tethys::api {
     }
 
     void transition_image_layout(vk::Image image, const vk::ImageLayout old_layout, const vk::ImageLayout new_layout, const u32 mips) {
-        auto command_buffer = begin_transient(); {
+        auto scope = record_upload(); {
             vk::ImageMemoryBarrier image_memory_barrier{}; {
                 image_memory_barrier.image = image;
 
@@ -141,6 +151,9 @@ namespace tethys::api {
                 }
             }
 
+            // Transitions into transfer layouts happen before the copies, anything later needs the graphics queue
+            const auto command_buffer = destination_stage == vk::PipelineStageFlagBits::eTransfer ? scope.batch.transfer : scope.batch.graphics;
+
             command_buffer.pipelineBarrier(
                 source_stage,
                 destination_stage,
@@ -149,8 +162,6 @@ namespace tethys::api {
                 nullptr,
                 image_memory_barrier,
                 context.dispatcher);
-
-            end_transient(command_buffer);
         }
     }
 } // namespace tethys::api
\ No newline at end of file
@@ -6,25 +6,35 @@
 #include <vulkan/vulkan.hpp>
 
 namespace tethys::api {
-    vk::RenderPass make_offscreen_render_pass(const Offscreen& offscreen) {
+    vk::RenderPass make_offscreen_render_pass(const Offscreen& offscreen, const bool resume) {
+        const auto samples = offscreen.depth.samples;
+        const auto multisampled = samples != vk::SampleCountFlagBits::e1;
+
         std::array<vk::AttachmentDescription, 3> attachments{}; {
-            attachments[0].format = offscreen.msaa.format;
-            attachments[0].samples = context.device.samples;
-            attachments[0].loadOp = vk::AttachmentLoadOp::eClear;
+            attachments[0].format = offscreen.color.format;
+            attachments[0].samples = samples;
+            attachments[0].loadOp = resume ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
             attachments[0].storeOp = vk::AttachmentStoreOp::eStore;
             attachments[0].stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
             attachments[0].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-            attachments[0].initialLayout = vk::ImageLayout::eUndefined;
+            attachments[0].initialLayout = resume ? vk::ImageLayout::eColorAttachmentOptimal : vk::ImageLayout::eUndefined;
             attachments[0].finalLayout = vk::ImageLayout::eColorAttachmentOptimal;
 
+            // Single sampled passes draw to the copy source directly, there is nothing to resolve
+            if (!multisampled) {
+                attachments[0].initialLayout = resume ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::eUndefined;
+                attachments[0].finalLayout = vk::ImageLayout::eTransferSrcOptimal;
+            }
+
             attachments[1].format = offscreen.depth.format;
-            attachments[1].samples = context.device.samples;
-            attachments[1].loadOp = vk::AttachmentLoadOp::eClear;
-            attachments[1].storeOp = vk::AttachmentStoreOp::eDontCare;
+            attachments[1].samples = samples;
+            // Depth is kept after the first pass, the depth pyramid is built from it
+            attachments[1].loadOp = resume ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
+            attachments[1].storeOp = resume ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore;
             attachments[1].stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
             attachments[1].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-            attachments[1].initialLayout = vk::ImageLayout::eUndefined;
-            attachments[1].finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+            attachments[1].initialLayout = resume ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eUndefined;
+            attachments[1].finalLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
 
             attachments[2].format = offscreen.color.format;
             attachments[2].samples = vk::SampleCountFlagBits::e1;
@@ -55,26 +65,39 @@ namespace tethys::api {
             subpass_description.colorAttachmentCount = 1;
             subpass_description.pColorAttachments = &color_attachment;
             subpass_description.pDepthStencilAttachment = &depth_attachment;
-            subpass_description.pResolveAttachments = &color_resolve_attachment;
+            subpass_description.pResolveAttachments = multisampled ? &color_resolve_attachment : nullptr;
             subpass_description.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
         }
 
-        vk::SubpassDependency subpass_dependency{}; {
-            subpass_dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-            subpass_dependency.dstSubpass = 0;
-            subpass_dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-            subpass_dependency.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-            subpass_dependency.srcAccessMask = {};
-            subpass_dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
+        std::array<vk::SubpassDependency, 2> subpass_dependencies{}; {
+            // Also waits for the depth pyramid build that samples the attachments of a previous pass, and for the
+            // copy or FXAA pass reading the colour target
+            subpass_dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+            subpass_dependencies[0].dstSubpass = 0;
+            subpass_dependencies[0].srcStageMask =
+                vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests |
+                vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer;
+            subpass_dependencies[0].dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+            subpass_dependencies[0].srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+            subpass_dependencies[0].dstAccessMask =
+                vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite |
+                vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+
+            subpass_dependencies[1].srcSubpass = 0;
+            subpass_dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+            subpass_dependencies[1].srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests;
+            subpass_dependencies[1].dstStageMask = vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer;
+            subpass_dependencies[1].srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+            subpass_dependencies[1].dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead;
         }
 
         vk::RenderPassCreateInfo render_pass_create_info{}; {
-            render_pass_create_info.attachmentCount = attachments.size();
+            render_pass_create_info.attachmentCount = multisampled ? attachments.size() : 2;
             render_pass_create_info.pAttachments = attachments.data();
             render_pass_create_info.subpassCount = 1;
             render_pass_create_info.pSubpasses = &subpass_description;
-            render_pass_create_info.dependencyCount = 1;
-            render_pass_create_info.pDependencies = &subpass_dependency;
+            render_pass_create_info.dependencyCount = subpass_dependencies.size();
+            render_pass_create_info.pDependencies = subpass_dependencies.data();
         }
 
         auto render_pass = context.device.logical.createRenderPass(render_pass_create_info, nullptr, context.dispatcher);
@@ -83,4 +106,162 @@ namespace tethys::api {
 
         return render_pass;
     }
+
+    vk::RenderPass make_gbuffer_render_pass(const GBuffer& gbuffer) {
+        std::array<vk::AttachmentDescription, 3> attachments{}; {
+            attachments[0].format = gbuffer.albedo.format;
+            attachments[0].samples = vk::SampleCountFlagBits::e1;
+            attachments[0].loadOp = vk::AttachmentLoadOp::eClear;
+            attachments[0].storeOp = vk::AttachmentStoreOp::eStore;
+            attachments[0].stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+            attachments[0].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+            attachments[0].initialLayout = vk::ImageLayout::eUndefined;
+            attachments[0].finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+            attachments[1].format = gbuffer.normal.format;
+            attachments[1].samples = vk::SampleCountFlagBits::e1;
+            attachments[1].loadOp = vk::AttachmentLoadOp::eClear;
+            attachments[1].storeOp = vk::AttachmentStoreOp::eStore;
+            attachments[1].stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+            attachments[1].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+            attachments[1].initialLayout = vk::ImageLayout::eUndefined;
+            attachments[1].finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+            attachments[2].format = gbuffer.depth.format;
+            attachments[2].samples = vk::SampleCountFlagBits::e1;
+            attachments[2].loadOp = vk::AttachmentLoadOp::eClear;
+            attachments[2].storeOp = vk::AttachmentStoreOp::eStore;
+            attachments[2].stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+            attachments[2].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+            attachments[2].initialLayout = vk::ImageLayout::eUndefined;
+            attachments[2].finalLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+        }
+
+        std::array<vk::AttachmentReference, 2> color_attachments{}; {
+            color_attachments[0].layout = vk::ImageLayout::eColorAttachmentOptimal;
+            color_attachments[0].attachment = 0;
+
+            color_attachments[1].layout = vk::ImageLayout::eColorAttachmentOptimal;
+            color_attachments[1].attachment = 1;
+        }
+
+        vk::AttachmentReference depth_attachment{}; {
+            depth_attachment.layout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+            depth_attachment.attachment = 2;
+        }
+
+        vk::SubpassDescription subpass_description{}; {
+            subpass_description.colorAttachmentCount = color_attachments.size();
+            subpass_description.pColorAttachments = color_attachments.data();
+            subpass_description.pDepthStencilAttachment = &depth_attachment;
+            subpass_description.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+        }
+
+        std::array<vk::SubpassDependency, 2> subpass_dependencies{}; {
+            // The previous frame's lighting pass has to be done reading the targets
+            subpass_dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+            subpass_dependencies[0].dstSubpass = 0;
+            subpass_dependencies[0].srcStageMask = vk::PipelineStageFlagBits::eComputeShader;
+            subpass_dependencies[0].dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+            subpass_dependencies[0].srcAccessMask = vk::AccessFlagBits::eShaderRead;
+            subpass_dependencies[0].dstAccessMask =
+                vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite |
+                vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+
+            subpass_dependencies[1].srcSubpass = 0;
+            subpass_dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+            subpass_dependencies[1].srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests;
+            subpass_dependencies[1].dstStageMask = vk::PipelineStageFlagBits::eComputeShader;
+            subpass_dependencies[1].srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+            subpass_dependencies[1].dstAccessMask = vk::AccessFlagBits::eShaderRead;
+        }
+
+        vk::RenderPassCreateInfo render_pass_create_info{}; {
+            render_pass_create_info.attachmentCount = attachments.size();
+            render_pass_create_info.pAttachments = attachments.data();
+            render_pass_create_info.subpassCount = 1;
+            render_pass_create_info.pSubpasses = &subpass_description;
+            render_pass_create_info.dependencyCount = subpass_dependencies.size();
+            render_pass_create_info.pDependencies = subpass_dependencies.data();
+        }
+
+        auto render_pass = context.device.logical.createRenderPass(render_pass_create_info, nullptr, context.dispatcher);
+
+        logger::info("G-buffer renderpass successfully created");
+
+        return render_pass;
+    }
+
+    vk::RenderPass make_visibility_render_pass(const VisibilityBuffer& visibility) {
+        std::array<vk::AttachmentDescription, 2> attachments{}; {
+            attachments[0].format = visibility.ids.format;
+            attachments[0].samples = vk::SampleCountFlagBits::e1;
+            attachments[0].loadOp = vk::AttachmentLoadOp::eClear;
+            attachments[0].storeOp = vk::AttachmentStoreOp::eStore;
+            attachments[0].stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+            attachments[0].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+            attachments[0].initialLayout = vk::ImageLayout::eUndefined;
+            attachments[0].finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+            attachments[1].format = visibility.depth.format;
+            attachments[1].samples = vk::SampleCountFlagBits::e1;
+            attachments[1].loadOp = vk::AttachmentLoadOp::eClear;
+            attachments[1].storeOp = vk::AttachmentStoreOp::eDontCare;
+            attachments[1].stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+            attachments[1].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+            attachments[1].initialLayout = vk::ImageLayout::eUndefined;
+            attachments[1].finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+        }
+
+        vk::AttachmentReference color_attachment{}; {
+            color_attachment.layout = vk::ImageLayout::eColorAttachmentOptimal;
+            color_attachment.attachment = 0;
+        }
+
+        vk::AttachmentReference depth_attachment{}; {
+            depth_attachment.layout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+            depth_attachment.attachment = 1;
+        }
+
+        vk::SubpassDescription subpass_description{}; {
+            subpass_description.colorAttachmentCount = 1;
+            subpass_description.pColorAttachments = &color_attachment;
+            subpass_description.pDepthStencilAttachment = &depth_attachment;
+            subpass_description.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+        }
+
+        std::array<vk::SubpassDependency, 2> subpass_dependencies{}; {
+            // The previous frame's resolve pass has to be done reading the IDs, and its depth writes done before the clear
+            subpass_dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+            subpass_dependencies[0].dstSubpass = 0;
+            subpass_dependencies[0].srcStageMask = vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eLateFragmentTests;
+            subpass_dependencies[0].dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+            subpass_dependencies[0].srcAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+            subpass_dependencies[0].dstAccessMask =
+                vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite |
+                vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+
+            subpass_dependencies[1].srcSubpass = 0;
+            subpass_dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+            subpass_dependencies[1].srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests;
+            subpass_dependencies[1].dstStageMask = vk::PipelineStageFlagBits::eComputeShader;
+            subpass_dependencies[1].srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+            subpass_dependencies[1].dstAccessMask = vk::AccessFlagBits::eShaderRead;
+        }
+
+        vk::RenderPassCreateInfo render_pass_create_info{}; {
+            render_pass_create_info.attachmentCount = attachments.size();
+            render_pass_create_info.pAttachments = attachments.data();
+            render_pass_create_info.subpassCount = 1;
+            render_pass_create_info.pSubpasses = &subpass_description;
+            render_pass_create_info.dependencyCount = subpass_dependencies.size();
+            render_pass_create_info.pDependencies = subpass_dependencies.data();
+        }
+
+        auto render_pass = context.device.logical.createRenderPass(render_pass_create_info, nullptr, context.dispatcher);
+
+        logger::info("Visibility buffer renderpass successfully created");
+
+        return render_pass;
+    }
 } // namespace tethys::api
\ No newline at end of file
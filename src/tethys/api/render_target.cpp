@@ -1,15 +1,20 @@
 #include <tethys/api/render_target.hpp>
 #include <tethys/api/context.hpp>
 
+#include <algorithm>
+
 namespace tethys::api {
-    Offscreen make_offscreen_target() {
+    Offscreen make_offscreen_target(const vk::SampleCountFlagBits samples, const bool fxaa) {
         Offscreen offscreen{};
 
         Image::CreateInfo color_image_info{}; {
             color_image_info.format = vk::Format::eB8G8R8A8Srgb;
             color_image_info.width = context.swapchain.extent.width;
             color_image_info.height = context.swapchain.extent.height;
-            color_image_info.usage_flags = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc;
+            // The deferred path blits its lit image in, FXAA samples it
+            color_image_info.usage_flags =
+                vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc |
+                vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
             color_image_info.samples = vk::SampleCountFlagBits::e1;
             color_image_info.tiling = vk::ImageTiling::eOptimal;
             color_image_info.aspect = vk::ImageAspectFlagBits::eColor;
@@ -21,26 +26,163 @@ namespace tethys::api {
             depth_image_info.format = vk::Format::eD32SfloatS8Uint;
             depth_image_info.width = context.swapchain.extent.width;
             depth_image_info.height = context.swapchain.extent.height;
-            depth_image_info.usage_flags = vk::ImageUsageFlagBits::eDepthStencilAttachment;
+            depth_image_info.usage_flags = vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled;
             depth_image_info.tiling = vk::ImageTiling::eOptimal;
             depth_image_info.aspect = vk::ImageAspectFlagBits::eDepth;
-            depth_image_info.samples = context.device.samples;
+            depth_image_info.samples = samples;
             depth_image_info.mips = 1;
         }
         offscreen.depth = api::make_image(depth_image_info);
 
-        Image::CreateInfo msaa_image_info{}; {
-            msaa_image_info.format = vk::Format::eB8G8R8A8Srgb;
-            msaa_image_info.width = context.swapchain.extent.width;
-            msaa_image_info.height = context.swapchain.extent.height;
-            msaa_image_info.usage_flags = vk::ImageUsageFlagBits::eColorAttachment;
-            msaa_image_info.aspect = vk::ImageAspectFlagBits::eColor;
-            msaa_image_info.samples = context.device.samples;
-            msaa_image_info.tiling = vk::ImageTiling::eOptimal;
-            msaa_image_info.mips = 1;
+        if (samples != vk::SampleCountFlagBits::e1) {
+            Image::CreateInfo msaa_image_info{}; {
+                msaa_image_info.format = vk::Format::eB8G8R8A8Srgb;
+                msaa_image_info.width = context.swapchain.extent.width;
+                msaa_image_info.height = context.swapchain.extent.height;
+                msaa_image_info.usage_flags = vk::ImageUsageFlagBits::eColorAttachment;
+                msaa_image_info.aspect = vk::ImageAspectFlagBits::eColor;
+                msaa_image_info.samples = samples;
+                msaa_image_info.tiling = vk::ImageTiling::eOptimal;
+                msaa_image_info.mips = 1;
+            }
+            offscreen.msaa = api::make_image(msaa_image_info);
+        }
+
+        if (fxaa) {
+            Image::CreateInfo aa_image_info{}; {
+                aa_image_info.format = vk::Format::eR8G8B8A8Unorm;
+                aa_image_info.width = context.swapchain.extent.width;
+                aa_image_info.height = context.swapchain.extent.height;
+                aa_image_info.usage_flags = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc;
+                aa_image_info.aspect = vk::ImageAspectFlagBits::eColor;
+                aa_image_info.samples = vk::SampleCountFlagBits::e1;
+                aa_image_info.tiling = vk::ImageTiling::eOptimal;
+                aa_image_info.mips = 1;
+            }
+            offscreen.aa = api::make_image(aa_image_info);
+        }
+
+        const auto largest = static_cast<u32>(std::max(context.swapchain.extent.width, context.swapchain.extent.height));
+        u32 levels = 1;
+
+        while (largest >> levels) {
+            ++levels;
+        }
+
+        Image::CreateInfo pyramid_image_info{}; {
+            pyramid_image_info.format = vk::Format::eR32Sfloat;
+            pyramid_image_info.width = context.swapchain.extent.width;
+            pyramid_image_info.height = context.swapchain.extent.height;
+            pyramid_image_info.usage_flags = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled;
+            pyramid_image_info.aspect = vk::ImageAspectFlagBits::eColor;
+            pyramid_image_info.samples = vk::SampleCountFlagBits::e1;
+            pyramid_image_info.tiling = vk::ImageTiling::eOptimal;
+            pyramid_image_info.mips = levels;
+        }
+        offscreen.depth_pyramid = api::make_image(pyramid_image_info);
+
+        offscreen.depth_pyramid_levels.reserve(levels);
+        for (u32 i = 0; i < levels; ++i) {
+            offscreen.depth_pyramid_levels.emplace_back(api::make_image_view(offscreen.depth_pyramid.handle, vk::Format::eR32Sfloat, vk::ImageAspectFlagBits::eColor, 1, i));
         }
-        offscreen.msaa = api::make_image(msaa_image_info);
 
         return offscreen;
     }
+
+    GBuffer make_gbuffer_target() {
+        GBuffer gbuffer{};
+
+        Image::CreateInfo albedo_image_info{}; {
+            albedo_image_info.format = vk::Format::eR8G8B8A8Srgb;
+            albedo_image_info.width = context.swapchain.extent.width;
+            albedo_image_info.height = context.swapchain.extent.height;
+            albedo_image_info.usage_flags = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled;
+            albedo_image_info.samples = vk::SampleCountFlagBits::e1;
+            albedo_image_info.tiling = vk::ImageTiling::eOptimal;
+            albedo_image_info.aspect = vk::ImageAspectFlagBits::eColor;
+            albedo_image_info.mips = 1;
+        }
+        gbuffer.albedo = api::make_image(albedo_image_info);
+
+        Image::CreateInfo normal_image_info{}; {
+            normal_image_info.format = vk::Format::eR16G16B16A16Sfloat;
+            normal_image_info.width = context.swapchain.extent.width;
+            normal_image_info.height = context.swapchain.extent.height;
+            normal_image_info.usage_flags = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled;
+            normal_image_info.samples = vk::SampleCountFlagBits::e1;
+            normal_image_info.tiling = vk::ImageTiling::eOptimal;
+            normal_image_info.aspect = vk::ImageAspectFlagBits::eColor;
+            normal_image_info.mips = 1;
+        }
+        gbuffer.normal = api::make_image(normal_image_info);
+
+        Image::CreateInfo depth_image_info{}; {
+            depth_image_info.format = vk::Format::eD32Sfloat;
+            depth_image_info.width = context.swapchain.extent.width;
+            depth_image_info.height = context.swapchain.extent.height;
+            depth_image_info.usage_flags = vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled;
+            depth_image_info.samples = vk::SampleCountFlagBits::e1;
+            depth_image_info.tiling = vk::ImageTiling::eOptimal;
+            depth_image_info.aspect = vk::ImageAspectFlagBits::eDepth;
+            depth_image_info.mips = 1;
+        }
+        gbuffer.depth = api::make_image(depth_image_info);
+
+        Image::CreateInfo lit_image_info{}; {
+            lit_image_info.format = vk::Format::eR16G16B16A16Sfloat;
+            lit_image_info.width = context.swapchain.extent.width;
+            lit_image_info.height = context.swapchain.extent.height;
+            lit_image_info.usage_flags = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc;
+            lit_image_info.samples = vk::SampleCountFlagBits::e1;
+            lit_image_info.tiling = vk::ImageTiling::eOptimal;
+            lit_image_info.aspect = vk::ImageAspectFlagBits::eColor;
+            lit_image_info.mips = 1;
+        }
+        gbuffer.lit = api::make_image(lit_image_info);
+
+        return gbuffer;
+    }
+
+    VisibilityBuffer make_visibility_target() {
+        VisibilityBuffer visibility{};
+
+        Image::CreateInfo ids_image_info{}; {
+            ids_image_info.format = vk::Format::eR32Uint;
+            ids_image_info.width = context.swapchain.extent.width;
+            ids_image_info.height = context.swapchain.extent.height;
+            ids_image_info.usage_flags = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled;
+            ids_image_info.samples = vk::SampleCountFlagBits::e1;
+            ids_image_info.tiling = vk::ImageTiling::eOptimal;
+            ids_image_info.aspect = vk::ImageAspectFlagBits::eColor;
+            ids_image_info.mips = 1;
+        }
+        visibility.ids = api::make_image(ids_image_info);
+
+        // Only tested against, the resolve pass interpolates depth from the triangle
+        Image::CreateInfo depth_image_info{}; {
+            depth_image_info.format = vk::Format::eD32Sfloat;
+            depth_image_info.width = context.swapchain.extent.width;
+            depth_image_info.height = context.swapchain.extent.height;
+            depth_image_info.usage_flags = vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eTransientAttachment;
+            depth_image_info.samples = vk::SampleCountFlagBits::e1;
+            depth_image_info.tiling = vk::ImageTiling::eOptimal;
+            depth_image_info.aspect = vk::ImageAspectFlagBits::eDepth;
+            depth_image_info.mips = 1;
+        }
+        visibility.depth = api::make_image(depth_image_info);
+
+        Image::CreateInfo lit_image_info{}; {
+            lit_image_info.format = vk::Format::eR16G16B16A16Sfloat;
+            lit_image_info.width = context.swapchain.extent.width;
+            lit_image_info.height = context.swapchain.extent.height;
+            lit_image_info.usage_flags = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc;
+            lit_image_info.samples = vk::SampleCountFlagBits::e1;
+            lit_image_info.tiling = vk::ImageTiling::eOptimal;
+            lit_image_info.aspect = vk::ImageAspectFlagBits::eColor;
+            lit_image_info.mips = 1;
+        }
+        visibility.lit = api::make_image(lit_image_info);
+
+        return visibility;
+    }
 } // namespace tethys::api
\ No newline at end of file
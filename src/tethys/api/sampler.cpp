@@ -4,6 +4,8 @@
 namespace tethys::api {
     static vk::Sampler default_sampler{};
     static vk::Sampler depth_sampler{};
+    static vk::Sampler nearest_sampler{};
+    static vk::Sampler linear_sampler{};
 
     [[nodiscard]] static vk::Sampler make_default_sampler() {
         vk::SamplerCreateInfo info{}; {
@@ -49,9 +51,57 @@ namespace tethys::api {
         return context.device.logical.createSampler(info, nullptr, context.dispatcher);
     }
 
+    // Unfiltered, reaches every mip, used to read exact texel values such as the depth pyramid
+    [[nodiscard]] static vk::Sampler make_nearest_sampler() {
+        vk::SamplerCreateInfo info{}; {
+            info.magFilter = vk::Filter::eNearest;
+            info.minFilter = vk::Filter::eNearest;
+            info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+            info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+            info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+            info.anisotropyEnable = false;
+            info.maxAnisotropy = 1;
+            info.borderColor = vk::BorderColor::eFloatOpaqueWhite;
+            info.unnormalizedCoordinates = false;
+            info.compareEnable = false;
+            info.compareOp = vk::CompareOp::eAlways;
+            info.mipmapMode = vk::SamplerMipmapMode::eNearest;
+            info.minLod = 0;
+            info.maxLod = VK_LOD_CLAMP_NONE;
+            info.mipLodBias = 0;
+        }
+
+        return context.device.logical.createSampler(info, nullptr, context.dispatcher);
+    }
+
+    // Bilinear on the base level, clamped to the edge, for screen-space passes such as FXAA
+    [[nodiscard]] static vk::Sampler make_linear_sampler() {
+        vk::SamplerCreateInfo info{}; {
+            info.magFilter = vk::Filter::eLinear;
+            info.minFilter = vk::Filter::eLinear;
+            info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+            info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+            info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+            info.anisotropyEnable = false;
+            info.maxAnisotropy = 1;
+            info.borderColor = vk::BorderColor::eFloatOpaqueWhite;
+            info.unnormalizedCoordinates = false;
+            info.compareEnable = false;
+            info.compareOp = vk::CompareOp::eAlways;
+            info.mipmapMode = vk::SamplerMipmapMode::eNearest;
+            info.minLod = 0;
+            info.maxLod = 0;
+            info.mipLodBias = 0;
+        }
+
+        return context.device.logical.createSampler(info, nullptr, context.dispatcher);
+    }
+
     void make_samplers() {
         default_sampler = make_default_sampler();
         depth_sampler = make_depth_sampler();
+        nearest_sampler = make_nearest_sampler();
+        linear_sampler = make_linear_sampler();
     }
 
     vk::Sampler sampler_from_type(const SamplerType& type) {
@@ -60,6 +110,10 @@ namespace tethys::api {
                 return default_sampler;
             case SamplerType::eDepth:
                 return depth_sampler;
+            case SamplerType::eNearest:
+                return nearest_sampler;
+            case SamplerType::eLinear:
+                return linear_sampler;
             default:
                 return nullptr;
         }
@@ -1,15 +1,29 @@
-#include <tethys/api/command_buffer.hpp>
 #include <tethys/api/static_buffer.hpp>
+#include <tethys/api/upload.hpp>
 #include <tethys/api/context.hpp>
 #include <tethys/api/device.hpp>
+#include <tethys/logger.hpp>
+
+#include <algorithm>
 
 namespace tethys::api {
-    StaticBuffer make_buffer(const usize size, const vk::BufferUsageFlags& usage, const VmaMemoryUsage memory_usage, const VmaAllocationCreateFlags alloc_flags) {
+    StaticBuffer make_buffer(const usize size, const vk::BufferUsageFlags& usage, const VmaMemoryUsage memory_usage, const VmaAllocationCreateFlags alloc_flags, const bool upload) {
         vk::BufferCreateInfo buffer_create_info{}; {
             buffer_create_info.size = size;
+            buffer_create_info.usage = usage;
+        }
+
+        // Upload destinations are shared with the transfer queue so uploads need no ownership transfers. Concurrent
+        // sharing may cost bandwidth on some GPUs, everything else stays exclusive
+        const std::array families{ context.device.family, context.device.transfer_family };
+
+        if (upload && families[0] != families[1]) {
+            buffer_create_info.queueFamilyIndexCount = families.size();
+            buffer_create_info.pQueueFamilyIndices = families.data();
+            buffer_create_info.sharingMode = vk::SharingMode::eConcurrent;
+        } else {
             buffer_create_info.queueFamilyIndexCount = 1;
             buffer_create_info.pQueueFamilyIndices = &context.device.family;
-            buffer_create_info.usage = usage;
             buffer_create_info.sharingMode = vk::SharingMode::eExclusive;
         }
 
@@ -38,44 +52,112 @@ namespace tethys::api {
         return buffer;
     }
 
-    void copy_buffer(const vk::Buffer src, vk::Buffer dst, const usize size) {
-        auto command_buffer = begin_transient(); {
-            vk::BufferCopy region{}; {
-                region.size = size;
-                region.srcOffset = 0;
-                region.dstOffset = 0;
-            }
+    UploadToken copy_buffer(const vk::Buffer src, vk::Buffer dst, const usize size, const usize src_offset, const usize dst_offset) {
+        auto scope = record_upload();
+
+        vk::BufferCopy region{}; {
+            region.size = size;
+            region.srcOffset = src_offset;
+            region.dstOffset = dst_offset;
+        }
 
-            command_buffer.copyBuffer(src, dst, region, context.dispatcher);
+        scope.batch.transfer.copyBuffer(src, dst, region, context.dispatcher);
+
+        return scope.batch.token;
+    }
 
-            end_transient(command_buffer);
+    UploadToken copy_buffer_to_image(const vk::Buffer buffer, vk::Image image, const u32 width, const u32 height, const usize buffer_offset, const u32 first_row) {
+        auto scope = record_upload();
+
+        vk::BufferImageCopy region{}; {
+            region.bufferOffset = buffer_offset;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+
+            region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+            region.imageSubresource.mipLevel = 0;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+
+            region.imageOffset = { { 0, static_cast<i32>(first_row), 0 } };
+            region.imageExtent = { {
+                width,
+                height,
+                1
+            } };
         }
+
+        scope.batch.transfer.copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal, region, context.dispatcher);
+
+        return scope.batch.token;
+    }
+
+    StagingRing make_staging_ring(const usize size) {
+        StagingRing ring{}; {
+            ring.buffer = make_buffer(size, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_CPU_ONLY, VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT);
+            ring.size = size;
+        }
+
+        // Never unmapped, CPU_ONLY memory is host coherent
+        void* mapped{};
+        vmaMapMemory(context.allocator, ring.buffer.allocation, &mapped);
+        ring.mapped = static_cast<u8*>(mapped);
+
+        logger::info("Allocated staging ring with size (in bytes): {}", size);
+
+        return ring;
     }
 
-    void copy_buffer_to_image(const vk::Buffer buffer, vk::Image image, const u32 width, const u32 height) {
-        auto command_buffer = begin_transient(); {
-            vk::BufferImageCopy region{}; {
-                region.bufferOffset = 0;
-                region.bufferRowLength = 0;
-                region.bufferImageHeight = 0;
-
-                region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-                region.imageSubresource.mipLevel = 0;
-                region.imageSubresource.baseArrayLayer = 0;
-                region.imageSubresource.layerCount = 1;
-
-                region.imageOffset = { { 0, 0, 0 } };
-                region.imageExtent = { {
-                    width,
-                    height,
-                    1
-                } };
-            }
-
-            command_buffer.copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal, region, context.dispatcher);
-
-            end_transient(command_buffer);
+    StagingRegion acquire_staging(StagingRing& ring, const usize size, const usize granularity) {
+        // Satisfies the offset alignment of buffer to image copies for every format in use
+        constexpr usize alignment = 16;
+
+        if (granularity > ring.size - alignment) {
+            throw std::runtime_error("Upload granularity larger than the staging ring");
+        }
+
+        if (ring.used == 0) {
+            ring.head = 0;
+            ring.tail = 0;
+        }
+
+        if (ring.used == ring.size) {
+            return {};
+        }
+
+        auto start = (ring.head + alignment - 1) & ~(alignment - 1);
+        auto end = ring.head >= ring.tail ? ring.size : ring.tail;
+        auto padding = start - ring.head;
+
+        // Not even one unit fits before the end of the buffer, skip the rest of it and continue at 0
+        if (ring.head >= ring.tail && (start >= end || end - start < granularity)) {
+            padding = ring.size - ring.head;
+            start = 0;
+            end = ring.tail;
         }
+
+        if (start >= end || end - start < granularity) {
+            return {};
+        }
+
+        const auto available = std::min(size, end - start);
+
+        StagingRegion region{}; {
+            region.offset = start;
+            region.size = available - available % granularity;
+            region.mapped = ring.mapped + start;
+            region.consumed = padding + region.size;
+        }
+
+        ring.head = start + region.size;
+        ring.used += region.consumed;
+
+        return region;
+    }
+
+    void release_staging(StagingRing& ring, const usize size) {
+        ring.tail = (ring.tail + size) % ring.size;
+        ring.used -= size;
     }
 
     void destroy_buffer(StaticBuffer& buffer) {
@@ -0,0 +1,265 @@
+#include <tethys/api/static_buffer.hpp>
+#include <tethys/api/context.hpp>
+#include <tethys/api/upload.hpp>
+#include <tethys/constants.hpp>
+#include <tethys/logger.hpp>
+
+#include <cstring>
+#include <deque>
+
+namespace tethys::api {
+    struct PendingBatch {
+        UploadBatch batch{};
+        vk::Fence fence{};
+        vk::Semaphore semaphore{};
+    };
+
+    static std::recursive_mutex upload_mutex{};
+    static StagingRing ring{};
+    static UploadBatch open_batch{};
+    static bool batch_open{};
+    static u64 next_batch = 1;
+    static u64 completed_batch{};
+    static std::deque<PendingBatch> pending{};
+
+    [[nodiscard]] static bool dedicated_transfer() {
+        return context.device.transfer_family != context.device.family;
+    }
+
+    [[nodiscard]] static vk::CommandBuffer begin_commands(const vk::CommandPool pool) {
+        vk::CommandBufferAllocateInfo allocate_info{}; {
+            allocate_info.commandBufferCount = 1;
+            allocate_info.level = vk::CommandBufferLevel::ePrimary;
+            allocate_info.commandPool = pool;
+        }
+
+        auto command_buffer = context.device.logical.allocateCommandBuffers(allocate_info, context.dispatcher)[0];
+
+        vk::CommandBufferBeginInfo begin_info{}; {
+            begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+        }
+
+        command_buffer.begin(begin_info, context.dispatcher);
+
+        return command_buffer;
+    }
+
+    static void open() {
+        if (!ring.mapped) {
+            ring = make_staging_ring(staging_ring_size);
+        }
+
+        open_batch.token.batch = next_batch;
+        open_batch.transfer = begin_commands(dedicated_transfer() ? context.transfer_pool : context.transient_pool);
+        open_batch.graphics = dedicated_transfer() ? begin_commands(context.transient_pool) : open_batch.transfer;
+        batch_open = true;
+
+        // Large uploads span batches, later copies may depend on transitions and copies of the previous one
+        vk::MemoryBarrier ordering_barrier{}; {
+            ordering_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            ordering_barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite;
+        }
+
+        open_batch.transfer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::DependencyFlagBits{},
+            ordering_barrier,
+            nullptr,
+            nullptr,
+            context.dispatcher);
+    }
+
+    // Releases everything owned by batches whose fence has signalled, oldest first
+    static void retire() {
+        while (!pending.empty()) {
+            auto& front = pending.front();
+
+            if (context.device.logical.getFenceStatus(front.fence, context.dispatcher) != vk::Result::eSuccess) {
+                break;
+            }
+
+            release_staging(ring, front.batch.staging);
+
+            if (dedicated_transfer()) {
+                context.device.logical.freeCommandBuffers(context.transfer_pool, front.batch.transfer, context.dispatcher);
+                context.device.logical.destroySemaphore(front.semaphore, nullptr, context.dispatcher);
+            }
+
+            context.device.logical.freeCommandBuffers(context.transient_pool, front.batch.graphics, context.dispatcher);
+            context.device.logical.destroyFence(front.fence, nullptr, context.dispatcher);
+
+            completed_batch = front.batch.token.batch;
+            pending.pop_front();
+        }
+    }
+
+    [[nodiscard]] static UploadToken flush_locked() {
+        if (!batch_open) {
+            return { next_batch - 1 };
+        }
+
+        // Later submissions on the graphics queue are in the second scope, so frames see the uploaded data
+        vk::MemoryBarrier visibility_barrier{}; {
+            visibility_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            visibility_barrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+        }
+
+        open_batch.graphics.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eAllCommands,
+            vk::DependencyFlagBits{},
+            visibility_barrier,
+            nullptr,
+            nullptr,
+            context.dispatcher);
+
+        PendingBatch submitted{}; {
+            submitted.batch = std::move(open_batch);
+            submitted.fence = context.device.logical.createFence(vk::FenceCreateInfo{}, nullptr, context.dispatcher);
+        }
+
+        const vk::PipelineStageFlags wait_stage = vk::PipelineStageFlagBits::eAllCommands;
+
+        if (dedicated_transfer()) {
+            submitted.batch.transfer.end(context.dispatcher);
+            submitted.semaphore = context.device.logical.createSemaphore(vk::SemaphoreCreateInfo{}, nullptr, context.dispatcher);
+
+            vk::SubmitInfo transfer_submit{}; {
+                transfer_submit.commandBufferCount = 1;
+                transfer_submit.pCommandBuffers = &submitted.batch.transfer;
+                transfer_submit.signalSemaphoreCount = 1;
+                transfer_submit.pSignalSemaphores = &submitted.semaphore;
+            }
+
+            context.device.transfer_queue.submit(transfer_submit, nullptr, context.dispatcher);
+        }
+
+        submitted.batch.graphics.end(context.dispatcher);
+
+        vk::SubmitInfo graphics_submit{}; {
+            graphics_submit.commandBufferCount = 1;
+            graphics_submit.pCommandBuffers = &submitted.batch.graphics;
+
+            if (dedicated_transfer()) {
+                graphics_submit.waitSemaphoreCount = 1;
+                graphics_submit.pWaitSemaphores = &submitted.semaphore;
+                graphics_submit.pWaitDstStageMask = &wait_stage;
+            }
+        }
+
+        context.device.queue.submit(graphics_submit, submitted.fence, context.dispatcher);
+
+        const auto token = submitted.batch.token;
+
+        pending.emplace_back(std::move(submitted));
+        open_batch = {};
+        batch_open = false;
+        ++next_batch;
+
+        retire();
+
+        return token;
+    }
+
+    // Blocks on the oldest batches until the ring has room
+    [[nodiscard]] static StagingRegion acquire_locked(const usize size, const usize granularity) {
+        auto region = acquire_staging(ring, size, granularity);
+
+        while (region.size == 0) {
+            (void)flush_locked();
+
+            context.device.logical.waitForFences(pending.front().fence, true, -1, context.dispatcher);
+            retire();
+
+            region = acquire_staging(ring, size, granularity);
+        }
+
+        if (!batch_open) {
+            open();
+        }
+
+        open_batch.staging += region.consumed;
+
+        return region;
+    }
+
+    UploadScope record_upload() {
+        std::unique_lock lock{ upload_mutex };
+
+        if (!batch_open) {
+            open();
+        }
+
+        return { std::move(lock), open_batch };
+    }
+
+    UploadToken upload_buffer(const void* data, const usize size, const vk::Buffer dst, const usize offset) {
+        return upload_buffer(size, 1, dst, offset, [data](u8* mapped, const usize source, const usize bytes) {
+            std::memcpy(mapped, static_cast<const u8*>(data) + source, bytes);
+        });
+    }
+
+    UploadToken upload_buffer(const usize size, const usize granularity, const vk::Buffer dst, const usize offset, const UploadWriter& write) {
+        auto scope = record_upload();
+
+        for (usize written = 0; written < size;) {
+            const auto region = acquire_locked(size - written, granularity);
+
+            write(region.mapped, written, region.size);
+            (void)copy_buffer(ring.buffer.handle, dst, region.size, region.offset, offset + written);
+
+            written += region.size;
+        }
+
+        return scope.batch.token;
+    }
+
+    UploadToken upload_image(vk::Image image, const u32 width, const u32 height, const u32 texel_size, const UploadWriter& write) {
+        auto scope = record_upload();
+        const usize row = width * texel_size;
+
+        for (u32 y = 0; y < height;) {
+            const auto region = acquire_locked((height - y) * row, row);
+            const auto rows = static_cast<u32>(region.size / row);
+
+            write(region.mapped, y * row, region.size);
+            (void)copy_buffer_to_image(ring.buffer.handle, image, width, rows, region.offset, y);
+
+            y += rows;
+        }
+
+        return scope.batch.token;
+    }
+
+    UploadToken flush_uploads() {
+        std::lock_guard lock{ upload_mutex };
+
+        return flush_locked();
+    }
+
+    bool upload_complete(const UploadToken token) {
+        std::lock_guard lock{ upload_mutex };
+
+        retire();
+
+        return completed_batch >= token.batch;
+    }
+
+    void wait_upload(const UploadToken token) {
+        std::lock_guard lock{ upload_mutex };
+
+        if (batch_open && token.batch == open_batch.token.batch) {
+            (void)flush_locked();
+        }
+
+        for (const auto& batch : pending) {
+            if (batch.batch.token.batch == token.batch) {
+                context.device.logical.waitForFences(batch.fence, true, -1, context.dispatcher);
+                break;
+            }
+        }
+
+        retire();
+    }
+} // namespace tethys::api
\ No newline at end of file
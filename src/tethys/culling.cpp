@@ -0,0 +1,210 @@
+#include <tethys/culling.hpp>
+
+#include <glm/glm.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define TETHYS_CULLING_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define TETHYS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define TETHYS_TARGET_AVX2
+#endif
+
+namespace tethys::culling {
+    void resize(Spheres& spheres, const usize size) {
+        const auto padded = (size + lanes - 1) / lanes * lanes;
+
+        spheres.x.resize(padded);
+        spheres.y.resize(padded);
+        spheres.z.resize(padded);
+        spheres.radius.resize(padded);
+        spheres.size = size;
+    }
+
+    void write(Spheres& spheres, const usize index, const glm::vec4& sphere) {
+        spheres.x[index] = sphere.x;
+        spheres.y[index] = sphere.y;
+        spheres.z[index] = sphere.z;
+        spheres.radius[index] = sphere.w;
+    }
+
+    std::array<glm::vec4, 6> frustum_planes(const glm::mat4& projection_view) {
+        // GLM_FORCE_DEPTH_ZERO_TO_ONE puts the near plane at row 2 alone
+        const auto rows = glm::transpose(projection_view);
+
+        std::array planes{
+            rows[3] + rows[0],
+            rows[3] - rows[0],
+            rows[3] + rows[1],
+            rows[3] - rows[1],
+            rows[2],
+            rows[3] - rows[2]
+        };
+
+        for (auto& plane : planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        return planes;
+    }
+
+#if defined(TETHYS_CULLING_X86)
+    static void push_lanes(u32 bits, const usize first, const usize size, std::vector<u32>& visible) {
+        // Padding lanes past the end are never reported
+        if (first + lanes > size) {
+            bits &= (1u << (size - first)) - 1;
+        }
+
+        for (u32 lane = 0; bits; ++lane, bits >>= 1u) {
+            if (bits & 1u) {
+                visible.emplace_back(static_cast<u32>(first + lane));
+            }
+        }
+    }
+
+    [[nodiscard]] static bool has_avx2() {
+    #if defined(_MSC_VER)
+        std::array<int, 4> info{};
+
+        __cpuid(info.data(), 1);
+        const bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6u) == 0x6u;
+
+        __cpuidex(info.data(), 7, 0);
+        return os_saves_ymm && (info[1] & (1 << 5));
+    #else
+        return __builtin_cpu_supports("avx2");
+    #endif
+    }
+
+    TETHYS_TARGET_AVX2 static void cull_avx2(const Spheres& spheres, const std::array<glm::vec4, 6>& planes, const glm::vec3& eye, const f32 max_distance, std::vector<u32>& visible) {
+        __m256 wide_planes[6][4];
+
+        for (usize i = 0; i < planes.size(); ++i) {
+            for (usize j = 0; j < 4; ++j) {
+                wide_planes[i][j] = _mm256_set1_ps(planes[i][j]);
+            }
+        }
+
+        const auto eye_x = _mm256_set1_ps(eye.x);
+        const auto eye_y = _mm256_set1_ps(eye.y);
+        const auto eye_z = _mm256_set1_ps(eye.z);
+        const auto range = _mm256_set1_ps(max_distance);
+        const auto all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (usize i = 0; i < spheres.size; i += 8) {
+            const auto x = _mm256_loadu_ps(spheres.x.data() + i);
+            const auto y = _mm256_loadu_ps(spheres.y.data() + i);
+            const auto z = _mm256_loadu_ps(spheres.z.data() + i);
+            const auto radius = _mm256_loadu_ps(spheres.radius.data() + i);
+            const auto neg_radius = _mm256_sub_ps(_mm256_setzero_ps(), radius);
+
+            auto mask = all;
+
+            for (const auto& plane : wide_planes) {
+                auto distance = _mm256_add_ps(_mm256_mul_ps(x, plane[0]), plane[3]);
+                distance = _mm256_add_ps(_mm256_mul_ps(y, plane[1]), distance);
+                distance = _mm256_add_ps(_mm256_mul_ps(z, plane[2]), distance);
+
+                mask = _mm256_and_ps(mask, _mm256_cmp_ps(distance, neg_radius, _CMP_GT_OQ));
+            }
+
+            const auto dx = _mm256_sub_ps(x, eye_x);
+            const auto dy = _mm256_sub_ps(y, eye_y);
+            const auto dz = _mm256_sub_ps(z, eye_z);
+            const auto length2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            const auto reach = _mm256_add_ps(range, radius);
+
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(length2, _mm256_mul_ps(reach, reach), _CMP_LT_OQ));
+
+            push_lanes(static_cast<u32>(_mm256_movemask_ps(mask)), i, spheres.size, visible);
+        }
+    }
+
+    // SSE2 is part of x86-64, four spheres per step
+    static void cull_sse(const Spheres& spheres, const std::array<glm::vec4, 6>& planes, const glm::vec3& eye, const f32 max_distance, std::vector<u32>& visible) {
+        __m128 wide_planes[6][4];
+
+        for (usize i = 0; i < planes.size(); ++i) {
+            for (usize j = 0; j < 4; ++j) {
+                wide_planes[i][j] = _mm_set1_ps(planes[i][j]);
+            }
+        }
+
+        const auto eye_x = _mm_set1_ps(eye.x);
+        const auto eye_y = _mm_set1_ps(eye.y);
+        const auto eye_z = _mm_set1_ps(eye.z);
+        const auto range = _mm_set1_ps(max_distance);
+
+        for (usize i = 0; i < spheres.size; i += 8) {
+            u32 bits = 0;
+
+            for (usize half = 0; half < 8; half += 4) {
+                const auto x = _mm_loadu_ps(spheres.x.data() + i + half);
+                const auto y = _mm_loadu_ps(spheres.y.data() + i + half);
+                const auto z = _mm_loadu_ps(spheres.z.data() + i + half);
+                const auto radius = _mm_loadu_ps(spheres.radius.data() + i + half);
+                const auto neg_radius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+                auto mask = _mm_cmpeq_ps(radius, radius);
+
+                for (const auto& plane : wide_planes) {
+                    auto distance = _mm_add_ps(_mm_mul_ps(x, plane[0]), plane[3]);
+                    distance = _mm_add_ps(_mm_mul_ps(y, plane[1]), distance);
+                    distance = _mm_add_ps(_mm_mul_ps(z, plane[2]), distance);
+
+                    mask = _mm_and_ps(mask, _mm_cmpgt_ps(distance, neg_radius));
+                }
+
+                const auto dx = _mm_sub_ps(x, eye_x);
+                const auto dy = _mm_sub_ps(y, eye_y);
+                const auto dz = _mm_sub_ps(z, eye_z);
+                const auto length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                const auto reach = _mm_add_ps(range, radius);
+
+                mask = _mm_and_ps(mask, _mm_cmplt_ps(length2, _mm_mul_ps(reach, reach)));
+
+                bits |= static_cast<u32>(_mm_movemask_ps(mask)) << half;
+            }
+
+            push_lanes(bits, i, spheres.size, visible);
+        }
+    }
+#else
+    static void cull_scalar(const Spheres& spheres, const std::array<glm::vec4, 6>& planes, const glm::vec3& eye, const f32 max_distance, std::vector<u32>& visible) {
+        for (usize i = 0; i < spheres.size; ++i) {
+            const glm::vec3 center{ spheres.x[i], spheres.y[i], spheres.z[i] };
+            const auto radius = spheres.radius[i];
+
+            bool inside = glm::dot(center - eye, center - eye) < (max_distance + radius) * (max_distance + radius);
+
+            for (const auto& plane : planes) {
+                inside = inside && glm::dot(glm::vec3(plane), center) + plane.w > -radius;
+            }
+
+            if (inside) {
+                visible.emplace_back(static_cast<u32>(i));
+            }
+        }
+    }
+#endif
+
+    void cull(const Spheres& spheres, const std::array<glm::vec4, 6>& planes, const glm::vec3& eye, const f32 max_distance, std::vector<u32>& visible) {
+#if defined(TETHYS_CULLING_X86)
+        static const bool avx2 = has_avx2();
+
+        if (avx2) {
+            cull_avx2(spheres, planes, eye, max_distance, visible);
+        } else {
+            cull_sse(spheres, planes, eye, max_distance, visible);
+        }
+#else
+        cull_scalar(spheres, planes, eye, max_distance, visible);
+#endif
+    }
+} // namespace tethys::culling
@@ -0,0 +1,228 @@
+#include <tethys/logger.hpp>
+#include <tethys/jobs.hpp>
+
+#include <condition_variable>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+namespace tethys::jobs {
+    struct Job {
+        std::function<void()> function{};
+        Counter* counter{};
+    };
+
+    // The owner pushes and pops at the back, thieves take from the front
+    struct WorkQueue {
+        std::mutex lock{};
+        std::deque<Job> jobs{};
+    };
+
+    static struct Scheduler {
+        std::vector<std::unique_ptr<WorkQueue>> queues{};
+        std::vector<std::thread> workers{};
+
+        // Guards sleeping, both idle workers and jobs::wait callers block on signal
+        std::mutex sleep_lock{};
+        std::condition_variable signal{};
+
+        std::atomic<usize> queued{};
+        std::atomic<u32> next_queue{};
+        std::atomic<bool> running{};
+
+        // Only a fallback, static destruction order against other users of the scheduler is unspecified
+        ~Scheduler() {
+            shutdown();
+        }
+    } scheduler;
+
+    // Index of the queue owned by the current thread, -1 outside of the workers
+    static thread_local i32 worker_index = -1;
+
+    [[nodiscard]] static bool pop(const usize index, Job& job) {
+        auto& queue = *scheduler.queues[index];
+        std::lock_guard<std::mutex> guard(queue.lock);
+
+        if (queue.jobs.empty()) {
+            return false;
+        }
+
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+        --scheduler.queued;
+
+        return true;
+    }
+
+    [[nodiscard]] static bool steal(const usize index, Job& job) {
+        auto& queue = *scheduler.queues[index];
+        std::lock_guard<std::mutex> guard(queue.lock);
+
+        if (queue.jobs.empty()) {
+            return false;
+        }
+
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        --scheduler.queued;
+
+        return true;
+    }
+
+    [[nodiscard]] static bool take(Job& job) {
+        const auto count = scheduler.queues.size();
+
+        if (worker_index >= 0 && pop(worker_index, job)) {
+            return true;
+        }
+
+        const usize start = worker_index >= 0 ? worker_index + 1 : 0;
+
+        for (usize i = 0; i < count; ++i) {
+            if (steal((start + i) % count, job)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static void execute(Job& job) {
+        job.function();
+
+        if (job.counter->pending.fetch_sub(1) == 1) {
+            {
+                std::lock_guard<std::mutex> guard(scheduler.sleep_lock);
+            }
+
+            scheduler.signal.notify_all();
+        }
+    }
+
+    static void worker_main(const i32 index) {
+        worker_index = index;
+
+        while (scheduler.running) {
+            Job job{};
+
+            if (take(job)) {
+                execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(scheduler.sleep_lock);
+            scheduler.signal.wait(lock, []() {
+                return !scheduler.running || scheduler.queued > 0;
+            });
+        }
+    }
+
+    void initialise(const u32 count) {
+        const auto workers = count != 0 ? count : std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+        scheduler.running = true;
+        scheduler.queues.reserve(workers);
+        scheduler.workers.reserve(workers);
+
+        for (u32 i = 0; i < workers; ++i) {
+            scheduler.queues.emplace_back(std::make_unique<WorkQueue>());
+        }
+
+        for (u32 i = 0; i < workers; ++i) {
+            scheduler.workers.emplace_back(worker_main, static_cast<i32>(i));
+        }
+
+        logger::info("Job system initialised with {} workers", workers);
+    }
+
+    void shutdown() {
+        if (scheduler.workers.empty()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(scheduler.sleep_lock);
+            scheduler.running = false;
+        }
+
+        scheduler.signal.notify_all();
+
+        for (auto& worker : scheduler.workers) {
+            worker.join();
+        }
+
+        scheduler.workers.clear();
+
+        // No counter is left pending
+        Job job{};
+
+        while (take(job)) {
+            execute(job);
+        }
+
+        scheduler.queues.clear();
+    }
+
+    void submit(std::function<void()> function, Counter& counter) {
+        // Before initialise there are no queues, the job runs on the caller
+        if (scheduler.queues.empty()) {
+            function();
+            return;
+        }
+
+        ++counter.pending;
+
+        const auto index = worker_index >= 0 ?
+            static_cast<u32>(worker_index) :
+            scheduler.next_queue++ % static_cast<u32>(scheduler.queues.size());
+
+        {
+            auto& queue = *scheduler.queues[index];
+            std::lock_guard<std::mutex> guard(queue.lock);
+
+            queue.jobs.emplace_back(Job{ std::move(function), &counter });
+            ++scheduler.queued;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(scheduler.sleep_lock);
+        }
+
+        scheduler.signal.notify_one();
+    }
+
+    void parallel_for(const usize count, const usize grain, const std::function<void(usize, usize)>& function, Counter& counter) {
+        const auto chunk = std::max<usize>(grain, 1);
+
+        for (usize first = 0; first < count; first += chunk) {
+            const auto last = std::min(first + chunk, count);
+
+            submit([function, first, last]() {
+                function(first, last);
+            }, counter);
+        }
+    }
+
+    void wait(Counter& counter) {
+        while (counter.pending != 0) {
+            Job job{};
+
+            if (take(job)) {
+                execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(scheduler.sleep_lock);
+            scheduler.signal.wait(lock, [&counter]() {
+                return counter.pending == 0 || scheduler.queued > 0;
+            });
+        }
+    }
+
+    u32 worker_count() {
+        return scheduler.workers.size();
+    }
+} // namespace tethys::jobs
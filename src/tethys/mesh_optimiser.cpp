@@ -0,0 +1,826 @@
+#include <tethys/mesh_optimiser.hpp>
+
+#include <glm/glm.hpp>
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <cmath>
+
+namespace tethys::optimise {
+    // Scoring constants from Forsyth's article, the cache is simulated as a 32 entry LRU
+    constexpr usize forsyth_cache = 32;
+    constexpr f32 cache_decay_power = 1.5f;
+    constexpr f32 last_triangle_score = 0.75f;
+    constexpr f32 valence_boost_scale = 2.0f;
+    constexpr f32 valence_boost_power = 0.5f;
+
+    struct VertexHash {
+        [[nodiscard]] usize operator ()(const Vertex* vertex) const {
+            const auto bytes = reinterpret_cast<const u8*>(vertex);
+            u64 hash = 14695981039346656037ull;
+
+            for (usize i = 0; i < sizeof(Vertex); ++i) {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+
+            return static_cast<usize>(hash);
+        }
+
+        [[nodiscard]] usize operator ()(const Vertex& vertex) const {
+            return (*this)(&vertex);
+        }
+    };
+
+    struct VertexEqual {
+        [[nodiscard]] bool operator ()(const Vertex* lhs, const Vertex* rhs) const {
+            return std::memcmp(lhs, rhs, sizeof(Vertex)) == 0;
+        }
+
+        [[nodiscard]] bool operator ()(const Vertex& lhs, const Vertex& rhs) const {
+            return (*this)(&lhs, &rhs);
+        }
+    };
+
+    // Sum of squared distances to a set of planes, weighted by triangle area, as a symmetric 4x4 matrix
+    struct Quadric {
+        f64 xx{}, yy{}, zz{}, dd{};
+        f64 xy{}, xz{}, xd{}, yz{}, yd{}, zd{};
+        f64 weight{};
+    };
+
+    struct Collapse {
+        u32 from{};
+        u32 to{};
+        f64 cost{};
+    };
+
+    static void add_plane(Quadric& quadric, const glm::vec3& normal, const f32 distance, const f32 weight) {
+        const f64 a = normal.x, b = normal.y, c = normal.z, d = distance;
+
+        quadric.xx += weight * a * a;
+        quadric.yy += weight * b * b;
+        quadric.zz += weight * c * c;
+        quadric.dd += weight * d * d;
+        quadric.xy += weight * a * b;
+        quadric.xz += weight * a * c;
+        quadric.xd += weight * a * d;
+        quadric.yz += weight * b * c;
+        quadric.yd += weight * b * d;
+        quadric.zd += weight * c * d;
+        quadric.weight += weight;
+    }
+
+    static void add_quadric(Quadric& quadric, const Quadric& other) {
+        quadric.xx += other.xx;
+        quadric.yy += other.yy;
+        quadric.zz += other.zz;
+        quadric.dd += other.dd;
+        quadric.xy += other.xy;
+        quadric.xz += other.xz;
+        quadric.xd += other.xd;
+        quadric.yz += other.yz;
+        quadric.yd += other.yd;
+        quadric.zd += other.zd;
+        quadric.weight += other.weight;
+    }
+
+    // Mean squared distance of the point to the quadric's planes
+    [[nodiscard]] static f64 quadric_error(const Quadric& quadric, const glm::vec3& point) {
+        const f64 x = point.x, y = point.y, z = point.z;
+        const auto error =
+            quadric.xx * x * x + quadric.yy * y * y + quadric.zz * z * z + quadric.dd +
+            2.0 * (quadric.xy * x * y + quadric.xz * x * z + quadric.yz * y * z) +
+            2.0 * (quadric.xd * x + quadric.yd * y + quadric.zd * z);
+
+        return quadric.weight == 0.0 ? 0.0 : std::max(error, 0.0) / quadric.weight;
+    }
+
+    [[nodiscard]] static f32 vertex_score(const i32 cache_position, const u32 remaining) {
+        if (remaining == 0) {
+            return -1.0f;
+        }
+
+        f32 score = 0.0f;
+
+        if (cache_position >= 0) {
+            // The last triangle's vertices get a fixed score so it isn't immediately reused
+            score = cache_position < 3 ?
+                last_triangle_score :
+                std::pow(1.0f - static_cast<f32>(cache_position - 3) / (forsyth_cache - 3), cache_decay_power);
+        }
+
+        // Vertices with few triangles left are finished first, so they leave the working set sooner
+        return score + valence_boost_scale * std::pow(static_cast<f32>(remaining), -valence_boost_power);
+    }
+
+    void weld(VertexData& data) {
+        auto& geometry = data.geometry;
+        std::unordered_map<const Vertex*, u32, VertexHash, VertexEqual> unique{};
+        std::vector<Vertex> welded{};
+        std::vector<u32> remap(geometry.size());
+
+        unique.reserve(geometry.size());
+        welded.reserve(geometry.size());
+
+        for (usize i = 0; i < geometry.size(); ++i) {
+            const auto [it, inserted] = unique.try_emplace(&geometry[i], static_cast<u32>(welded.size()));
+
+            if (inserted) {
+                welded.emplace_back(geometry[i]);
+            }
+
+            remap[i] = it->second;
+        }
+
+        for (auto& index : data.indices) {
+            index = remap[index];
+        }
+
+        geometry = std::move(welded);
+    }
+
+    void vertex_cache(std::vector<u32>& indices, const usize vertex_count) {
+        const auto triangle_count = indices.size() / 3;
+
+        if (triangle_count == 0) {
+            return;
+        }
+
+        // Triangles using each vertex, the first remaining[v] entries of a vertex's list are the ones not yet emitted
+        std::vector<u32> remaining(vertex_count, 0);
+        std::vector<u32> offsets(vertex_count + 1, 0);
+        std::vector<u32> adjacency(indices.size());
+
+        for (const auto index : indices) {
+            ++remaining[index];
+        }
+
+        for (usize i = 0; i < vertex_count; ++i) {
+            offsets[i + 1] = offsets[i] + remaining[i];
+        }
+
+        std::vector<u32> fill(offsets.begin(), offsets.end() - 1);
+
+        for (usize i = 0; i < indices.size(); ++i) {
+            adjacency[fill[indices[i]]++] = static_cast<u32>(i / 3);
+        }
+
+        std::vector<i32> cache_position(vertex_count, -1);
+        std::vector<f32> scores(vertex_count);
+        std::vector<f32> triangle_scores(triangle_count, 0.0f);
+        std::vector<u8> emitted(triangle_count, 0);
+
+        for (usize i = 0; i < vertex_count; ++i) {
+            scores[i] = vertex_score(-1, remaining[i]);
+        }
+
+        for (usize i = 0; i < indices.size(); ++i) {
+            triangle_scores[i / 3] += scores[indices[i]];
+        }
+
+        std::vector<u32> cache{};
+        std::vector<u32> next_cache{};
+        std::vector<u32> result{};
+
+        cache.reserve(forsyth_cache + 3);
+        next_cache.reserve(forsyth_cache + 3);
+        result.reserve(indices.size());
+
+        usize cursor = 0;
+        i64 best = -1;
+
+        while (result.size() < indices.size()) {
+            // Nothing in the cache has triangles left, continue with the next triangle in the input order
+            if (best < 0) {
+                while (emitted[cursor]) {
+                    ++cursor;
+                }
+
+                best = static_cast<i64>(cursor);
+            }
+
+            const auto triangle = static_cast<u32>(best);
+            emitted[triangle] = 1;
+            next_cache.clear();
+
+            for (usize i = 0; i < 3; ++i) {
+                const auto vertex = indices[triangle * 3 + i];
+                auto* live = &adjacency[offsets[vertex]];
+
+                result.emplace_back(vertex);
+                next_cache.emplace_back(vertex);
+
+                for (u32 j = 0; j < remaining[vertex]; ++j) {
+                    if (live[j] == triangle) {
+                        std::swap(live[j], live[remaining[vertex] - 1]);
+                        break;
+                    }
+                }
+
+                --remaining[vertex];
+            }
+
+            for (const auto vertex : cache) {
+                if (std::find(next_cache.begin(), next_cache.begin() + 3, vertex) == next_cache.begin() + 3) {
+                    next_cache.emplace_back(vertex);
+                }
+            }
+
+            // Entries past the cache size were just evicted, their scores drop too
+            for (usize i = 0; i < next_cache.size(); ++i) {
+                const auto vertex = next_cache[i];
+                cache_position[vertex] = i < forsyth_cache ? static_cast<i32>(i) : -1;
+
+                const auto score = vertex_score(cache_position[vertex], remaining[vertex]);
+                const auto delta = score - scores[vertex];
+                scores[vertex] = score;
+
+                for (u32 j = 0; j < remaining[vertex]; ++j) {
+                    triangle_scores[adjacency[offsets[vertex] + j]] += delta;
+                }
+            }
+
+            next_cache.resize(std::min<usize>(next_cache.size(), forsyth_cache));
+            std::swap(cache, next_cache);
+
+            best = -1;
+            f32 best_score = -1.0f;
+
+            for (const auto vertex : cache) {
+                for (u32 j = 0; j < remaining[vertex]; ++j) {
+                    const auto candidate = adjacency[offsets[vertex] + j];
+
+                    if (triangle_scores[candidate] > best_score) {
+                        best_score = triangle_scores[candidate];
+                        best = candidate;
+                    }
+                }
+            }
+        }
+
+        indices = std::move(result);
+    }
+
+    void overdraw(VertexData& data, const f32 threshold) {
+        auto& indices = data.indices;
+        const auto& geometry = data.geometry;
+        const auto triangle_count = indices.size() / 3;
+
+        if (triangle_count == 0) {
+            return;
+        }
+
+        // Triangles missing all three vertices start over anyway, reordering there costs little. One only becomes
+        // a cluster boundary when the cluster before it is within threshold of the whole mesh
+        const auto limit = acmr(indices, geometry.size()) * threshold;
+        std::vector<u32> timestamps(geometry.size(), 0);
+        std::vector<usize> clusters{ 0 };
+        u32 time = cache_size + 1;
+        usize cluster_misses = 0;
+
+        for (usize i = 0; i < triangle_count; ++i) {
+            usize misses = 0;
+
+            for (usize j = 0; j < 3; ++j) {
+                const auto vertex = indices[i * 3 + j];
+
+                if (time - timestamps[vertex] > cache_size) {
+                    timestamps[vertex] = time++;
+                    ++misses;
+                }
+            }
+
+            const auto cluster_triangles = i - clusters.back();
+
+            if (misses == 3 && cluster_triangles != 0 && cluster_misses <= limit * cluster_triangles) {
+                clusters.emplace_back(i);
+                cluster_misses = 0;
+            }
+
+            cluster_misses += misses;
+        }
+
+        clusters.emplace_back(triangle_count);
+
+        auto mesh_centroid = glm::vec3(0.0f);
+
+        for (const auto& vertex : geometry) {
+            mesh_centroid += vertex.pos;
+        }
+
+        mesh_centroid /= static_cast<f32>(geometry.size());
+
+        // Clusters facing away from the centroid are on the outside of the mesh and occlude the rest
+        std::vector<std::pair<f32, usize>> order(clusters.size() - 1);
+
+        for (usize i = 0; i < order.size(); ++i) {
+            auto centroid = glm::vec3(0.0f);
+            auto normal = glm::vec3(0.0f);
+            f32 area = 0.0f;
+
+            for (usize j = clusters[i]; j < clusters[i + 1]; ++j) {
+                const auto& a = geometry[indices[j * 3 + 0]].pos;
+                const auto& b = geometry[indices[j * 3 + 1]].pos;
+                const auto& c = geometry[indices[j * 3 + 2]].pos;
+                const auto face = glm::cross(b - a, c - a);
+                const auto face_area = glm::length(face);
+
+                centroid += (a + b + c) / 3.0f * face_area;
+                normal += face;
+                area += face_area;
+            }
+
+            const auto length = glm::length(normal);
+            const auto key = area == 0.0f || length == 0.0f ? 0.0f : glm::dot(centroid / area - mesh_centroid, normal / length);
+
+            order[i] = { -key, i };
+        }
+
+        std::stable_sort(order.begin(), order.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+
+        std::vector<u32> result{};
+        result.reserve(indices.size());
+
+        for (const auto& [key, cluster] : order) {
+            result.insert(result.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + clusters[cluster + 1] * 3);
+        }
+
+        indices = std::move(result);
+    }
+
+    void vertex_fetch(VertexData& data) {
+        std::vector<u32> remap(data.geometry.size(), ~0u);
+        std::vector<Vertex> reordered{};
+
+        reordered.reserve(data.geometry.size());
+
+        for (auto& index : data.indices) {
+            if (remap[index] == ~0u) {
+                remap[index] = static_cast<u32>(reordered.size());
+                reordered.emplace_back(data.geometry[index]);
+            }
+
+            index = remap[index];
+        }
+
+        data.geometry = std::move(reordered);
+    }
+
+    std::vector<u32> simplify(const std::vector<Vertex>& vertices, const std::vector<u32>& source, const usize target, const f32 target_error, f32& error) {
+        std::vector<u32> indices = source;
+        const auto vertex_count = vertices.size();
+        const auto max_cost = static_cast<f64>(target_error) * target_error;
+        f64 reached = 0.0;
+
+        // Vertices sharing a position with another vertex lie on an attribute seam
+        std::vector<u8> locked(vertex_count, 0);
+        std::unordered_map<Vertex, u32, VertexHash, VertexEqual> positions{};
+
+        positions.reserve(vertex_count);
+
+        for (usize i = 0; i < vertex_count; ++i) {
+            Vertex key{};
+            key.pos = vertices[i].pos;
+
+            const auto [it, inserted] = positions.try_emplace(key, static_cast<u32>(i));
+
+            if (!inserted) {
+                locked[i] = 1;
+                locked[it->second] = 1;
+            }
+        }
+
+        // Edges used by a single triangle are on a border
+        std::vector<u64> edges{};
+        edges.reserve(indices.size());
+
+        for (usize i = 0; i < indices.size(); i += 3) {
+            for (usize j = 0; j < 3; ++j) {
+                const auto a = indices[i + j];
+                const auto b = indices[i + (j + 1) % 3];
+
+                edges.emplace_back(static_cast<u64>(std::min(a, b)) << 32u | std::max(a, b));
+            }
+        }
+
+        std::sort(edges.begin(), edges.end());
+
+        for (usize i = 0; i < edges.size();) {
+            usize count = 1;
+
+            while (i + count < edges.size() && edges[i + count] == edges[i]) {
+                ++count;
+            }
+
+            if (count == 1) {
+                locked[edges[i] >> 32u] = 1;
+                locked[edges[i] & 0xffffffffu] = 1;
+            }
+
+            i += count;
+        }
+
+        std::vector<Quadric> quadrics(vertex_count);
+
+        for (usize i = 0; i < indices.size(); i += 3) {
+            const auto& a = vertices[indices[i + 0]].pos;
+            const auto& b = vertices[indices[i + 1]].pos;
+            const auto& c = vertices[indices[i + 2]].pos;
+            const auto normal = glm::cross(b - a, c - a);
+            const auto area = glm::length(normal);
+
+            if (area == 0.0f) {
+                continue;
+            }
+
+            const auto unit = normal / area;
+
+            for (usize j = 0; j < 3; ++j) {
+                add_plane(quadrics[indices[i + j]], unit, -glm::dot(unit, a), area);
+            }
+        }
+
+        std::vector<u32> remap(vertex_count);
+        std::vector<u8> touched(vertex_count);
+        std::vector<u32> offsets(vertex_count + 1);
+        std::vector<u32> adjacency{};
+        std::vector<Collapse> collapses{};
+
+        // Every pass collapses a set of independent edges cheapest first, then rewrites the indices
+        while (indices.size() > target) {
+            edges.clear();
+
+            for (usize i = 0; i < indices.size(); i += 3) {
+                for (usize j = 0; j < 3; ++j) {
+                    const auto a = indices[i + j];
+                    const auto b = indices[i + (j + 1) % 3];
+
+                    edges.emplace_back(static_cast<u64>(std::min(a, b)) << 32u | std::max(a, b));
+                }
+            }
+
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+            collapses.clear();
+
+            for (const auto edge : edges) {
+                const auto a = static_cast<u32>(edge >> 32u);
+                const auto b = static_cast<u32>(edge & 0xffffffffu);
+
+                if (locked[a] && locked[b]) {
+                    continue;
+                }
+
+                Quadric merged = quadrics[a];
+                add_quadric(merged, quadrics[b]);
+
+                const auto a_to_b = locked[a] ? std::numeric_limits<f64>::max() : quadric_error(merged, vertices[b].pos);
+                const auto b_to_a = locked[b] ? std::numeric_limits<f64>::max() : quadric_error(merged, vertices[a].pos);
+
+                collapses.push_back(a_to_b <= b_to_a ? Collapse{ a, b, a_to_b } : Collapse{ b, a, b_to_a });
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.cost < rhs.cost;
+            });
+
+            std::fill(offsets.begin(), offsets.end(), 0);
+
+            for (const auto index : indices) {
+                ++offsets[index + 1];
+            }
+
+            for (usize i = 0; i < vertex_count; ++i) {
+                offsets[i + 1] += offsets[i];
+            }
+
+            adjacency.resize(indices.size());
+            std::vector<u32> fill(offsets.begin(), offsets.end() - 1);
+
+            for (usize i = 0; i < indices.size(); ++i) {
+                adjacency[fill[indices[i]]++] = static_cast<u32>(i / 3);
+            }
+
+            for (usize i = 0; i < vertex_count; ++i) {
+                remap[i] = static_cast<u32>(i);
+            }
+
+            std::fill(touched.begin(), touched.end(), 0);
+
+            auto triangles = indices.size() / 3;
+            usize collapsed = 0;
+
+            for (const auto& collapse : collapses) {
+                if (collapse.cost > max_cost || triangles * 3 <= target) {
+                    break;
+                }
+
+                if (touched[collapse.from] || touched[collapse.to]) {
+                    continue;
+                }
+
+                // Triangles around from that keep their area must not flip
+                bool flips = false;
+                usize removed = 0;
+
+                for (u32 i = offsets[collapse.from]; i < offsets[collapse.from + 1]; ++i) {
+                    const auto triangle = &indices[adjacency[i] * 3];
+
+                    if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+                        ++removed;
+                        continue;
+                    }
+
+                    glm::vec3 before[3];
+                    glm::vec3 after[3];
+
+                    for (usize j = 0; j < 3; ++j) {
+                        before[j] = vertices[triangle[j]].pos;
+                        after[j] = triangle[j] == collapse.from ? vertices[collapse.to].pos : before[j];
+                    }
+
+                    const auto normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    const auto normal_after = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+                    if (glm::dot(normal_before, normal_after) <= 0.0f) {
+                        flips = true;
+                        break;
+                    }
+                }
+
+                if (flips) {
+                    continue;
+                }
+
+                remap[collapse.from] = collapse.to;
+                add_quadric(quadrics[collapse.to], quadrics[collapse.from]);
+                reached = std::max(reached, collapse.cost);
+                triangles -= removed;
+                ++collapsed;
+
+                // The whole neighbourhood is frozen for the rest of the pass, so the flip tests above stay exact
+                for (u32 i = offsets[collapse.from]; i < offsets[collapse.from + 1]; ++i) {
+                    for (usize j = 0; j < 3; ++j) {
+                        touched[indices[adjacency[i] * 3 + j]] = 1;
+                    }
+                }
+            }
+
+            if (collapsed == 0) {
+                break;
+            }
+
+            usize write = 0;
+
+            for (usize i = 0; i < indices.size(); i += 3) {
+                const auto a = remap[indices[i + 0]];
+                const auto b = remap[indices[i + 1]];
+                const auto c = remap[indices[i + 2]];
+
+                if (a != b && b != c && a != c) {
+                    indices[write++] = a;
+                    indices[write++] = b;
+                    indices[write++] = c;
+                }
+            }
+
+            indices.resize(write);
+        }
+
+        error = static_cast<f32>(std::sqrt(reached));
+
+        return indices;
+    }
+
+    void lods(VertexData& data) {
+        const auto full = data.indices.size();
+
+        data.lods.assign(1, MeshLod{ 0, static_cast<u32>(full), 0.0f });
+
+        if (full == 0 || full % 3 != 0) {
+            return;
+        }
+
+        auto min = data.geometry[0].pos;
+        auto max = min;
+
+        for (const auto& vertex : data.geometry) {
+            min = glm::min(min, vertex.pos);
+            max = glm::max(max, vertex.pos);
+        }
+
+        const auto target_error = glm::length(max - min) * 0.5f * max_lod_error;
+        std::vector<u32> previous = data.indices;
+
+        while (data.lods.size() < max_lods) {
+            const auto target = static_cast<usize>(previous.size() / 3 * lod_reduction) * 3;
+
+            if (target < min_lod_triangles * 3) {
+                break;
+            }
+
+            f32 error{};
+            auto level = simplify(data.geometry, previous, target, target_error, error);
+
+            // Stalled on locked vertices or the error limit, further levels would look the same
+            if (level.size() > previous.size() * 3 / 4) {
+                break;
+            }
+
+            vertex_cache(level, data.geometry.size());
+
+            // Each level is simplified from the one before it, so the errors add up
+            data.lods.push_back(MeshLod{ static_cast<u32>(data.indices.size()), static_cast<u32>(level.size()), data.lods.back().error + error });
+            data.indices.insert(data.indices.end(), level.begin(), level.end());
+            previous = std::move(level);
+        }
+    }
+
+    // Sphere around the box of the meshlet's vertices, and the normal cone the way meshoptimizer computes it: the axis is
+    // the average triangle normal, the apex is moved back along it until every triangle's plane is in front of it
+    [[nodiscard]] static Meshlet meshlet_bounds(const std::vector<Vertex>& vertices, const u32* indices, const usize count) {
+        auto min = vertices[indices[0]].pos;
+        auto max = min;
+
+        for (usize i = 0; i < count; ++i) {
+            min = glm::min(min, vertices[indices[i]].pos);
+            max = glm::max(max, vertices[indices[i]].pos);
+        }
+
+        const auto center = (min + max) * 0.5f;
+        f32 radius = 0.0f;
+
+        for (usize i = 0; i < count; ++i) {
+            radius = std::max(radius, glm::length(vertices[indices[i]].pos - center));
+        }
+
+        std::vector<glm::vec3> normals{};
+        std::vector<glm::vec3> corners{};
+        glm::vec3 axis(0.0f);
+
+        for (usize i = 0; i < count; i += 3) {
+            const auto& a = vertices[indices[i]].pos;
+            const auto normal = glm::cross(vertices[indices[i + 1]].pos - a, vertices[indices[i + 2]].pos - a);
+            const auto area = glm::length(normal);
+
+            if (area > 0.0f) {
+                normals.push_back(normal / area);
+                corners.push_back(a);
+                axis += normal / area;
+            }
+        }
+
+        Meshlet meshlet{}; {
+            meshlet.sphere = glm::vec4(center, radius);
+            // A cutoff of 1 never culls
+            meshlet.cone_apex = glm::vec4(center, 1.0f);
+            meshlet.cone_axis = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+        }
+
+        if (normals.empty() || glm::length(axis) == 0.0f) {
+            return meshlet;
+        }
+
+        axis /= glm::length(axis);
+
+        f32 min_dot = 1.0f;
+
+        for (const auto& normal : normals) {
+            min_dot = std::min(min_dot, glm::dot(normal, axis));
+        }
+
+        // Wider than about 84 degrees the cone rejects next to nothing
+        if (min_dot <= 0.1f) {
+            return meshlet;
+        }
+
+        f32 max_t = 0.0f;
+
+        for (usize i = 0; i < normals.size(); ++i) {
+            max_t = std::max(max_t, glm::dot(center - corners[i], normals[i]) / glm::dot(axis, normals[i]));
+        }
+
+        meshlet.cone_apex = glm::vec4(center - axis * max_t, std::sqrt(1.0f - min_dot * min_dot));
+        meshlet.cone_axis = glm::vec4(axis, 0.0f);
+
+        return meshlet;
+    }
+
+    void meshlets(VertexData& data) {
+        const auto full = data.lods.empty() ? data.indices.size() : data.lods[0].index_count;
+
+        data.meshlets.clear();
+
+        if (full == 0 || full % 3 != 0) {
+            return;
+        }
+
+        std::vector<u32> indices{};
+        indices.reserve(full + full / meshlet_triangles + 3);
+
+        // A vertex is part of the open meshlet when its stamp is the meshlet's number
+        std::vector<u32> stamps(data.geometry.size(), ~0u);
+        usize first = 0;
+        usize unique = 0;
+
+        const auto close = [&data, &indices, &first, &unique]() {
+            if ((indices.size() - first) / 3 % 2 == 1) {
+                indices.insert(indices.end(), 3, indices.back());
+            }
+
+            auto meshlet = meshlet_bounds(data.geometry, indices.data() + first, indices.size() - first);
+            meshlet.index_offset = first;
+            meshlet.index_count = indices.size() - first;
+
+            data.meshlets.push_back(meshlet);
+            first = indices.size();
+            unique = 0;
+        };
+
+        for (usize i = 0; i < full; i += 3) {
+            const auto a = data.indices[i];
+            const auto b = data.indices[i + 1];
+            const auto c = data.indices[i + 2];
+
+            const auto added = [&]() {
+                const auto stamp = static_cast<u32>(data.meshlets.size());
+
+                return
+                    static_cast<usize>(stamps[a] != stamp) +
+                    static_cast<usize>(stamps[b] != stamp && b != a) +
+                    static_cast<usize>(stamps[c] != stamp && c != a && c != b);
+            };
+
+            if (unique + added() > meshlet_vertices || (indices.size() - first) / 3 == meshlet_triangles) {
+                close();
+            }
+
+            unique += added();
+
+            for (const auto index : { a, b, c }) {
+                stamps[index] = data.meshlets.size();
+                indices.push_back(index);
+            }
+        }
+
+        close();
+
+        const auto growth = static_cast<u32>(indices.size() - full);
+
+        indices.insert(indices.end(), data.indices.begin() + full, data.indices.end());
+        data.indices = std::move(indices);
+
+        if (!data.lods.empty()) {
+            data.lods[0].index_count += growth;
+
+            for (usize i = 1; i < data.lods.size(); ++i) {
+                data.lods[i].index_offset += growth;
+            }
+        }
+    }
+
+    f32 acmr(const std::vector<u32>& indices, const usize vertex_count) {
+        if (indices.size() < 3) {
+            return 0.0f;
+        }
+
+        // A vertex is in the FIFO if fewer than cache_size misses happened since it was last loaded
+        std::vector<u32> timestamps(vertex_count, 0);
+        u32 time = cache_size + 1;
+        usize misses = 0;
+
+        for (const auto index : indices) {
+            if (time - timestamps[index] > cache_size) {
+                timestamps[index] = time++;
+                ++misses;
+            }
+        }
+
+        return static_cast<f32>(misses) / static_cast<f32>(indices.size() / 3);
+    }
+
+    Stats mesh(VertexData& data) {
+        Stats stats{}; {
+            stats.triangles = data.indices.size() / 3;
+            stats.vertices_before = data.geometry.size();
+            stats.acmr_before = acmr(data.indices, data.geometry.size());
+        }
+
+        if (!data.indices.empty() && data.indices.size() % 3 == 0) {
+            weld(data);
+            vertex_cache(data.indices, data.geometry.size());
+            overdraw(data);
+            vertex_fetch(data);
+        }
+
+        stats.vertices_after = data.geometry.size();
+        stats.acmr_after = acmr(data.indices, data.geometry.size());
+
+        return stats;
+    }
+} // namespace tethys::optimise
@@ -1,6 +1,10 @@
 #include <tethys/renderer/renderer.hpp>
+#include <tethys/mesh_optimiser.hpp>
 #include <tethys/constants.hpp>
+#include <tethys/logger.hpp>
 #include <tethys/model.hpp>
+#include <tethys/tmesh.hpp>
+#include <tethys/jobs.hpp>
 
 #include <assimp/postprocess.h>
 #include <assimp/Importer.hpp>
@@ -9,37 +13,40 @@
 #include <vulkan/vulkan.hpp>
 
 #include <unordered_map>
+#include <array>
 
 namespace tethys {
     static std::unordered_map<std::string, Texture> loaded_textures;
 
-    [[nodiscard]] static Texture& try_load_texture(const aiMaterial* material, const aiTextureType type, const std::string& model_path) {
+    // Albedo, metallic and normal, in the order ModelImport::texture_paths stores them
+    constexpr std::array model_texture_types{ aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_HEIGHT };
+
+    [[nodiscard]] static Texture& default_texture(const aiTextureType type) {
+        switch (type) {
+            case aiTextureType_DIFFUSE:
+                return texture::get<texture::white>();
+            case aiTextureType_HEIGHT:
+                return texture::get<texture::green>();
+            default:
+                return texture::get<texture::black>();
+        }
+    }
+
+    [[nodiscard]] static std::string texture_path(const aiMaterial* material, const aiTextureType type, const std::string& model_path) {
         if (!material->GetTextureCount(type)) {
-            switch (type) {
-                case aiTextureType_DIFFUSE:
-                    return texture::get<texture::white>();
-                case aiTextureType_HEIGHT:
-                    return texture::get<texture::green>();
-                default:
-                    return texture::get<texture::black>();
-            }
+            return {};
         }
 
         aiString str;
         material->GetTexture(type, 0, &str);
-        std::string path = model_path + "/" + str.C_Str();
 
-        if (loaded_textures.find(path) != loaded_textures.end()) {
-            return loaded_textures[path];
-        }
-
-        return loaded_textures[path] = renderer::upload_texture(path.c_str(), type == aiTextureType_DIFFUSE ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm);
+        return model_path + "/" + str.C_Str();
     }
 
-    static Model::SubMesh load_mesh(const aiScene* scene, const aiMesh* mesh, const std::string& model_path) {
-        Model::SubMesh sub_mesh{};
-        std::vector<Vertex> geometry{};
-        std::vector<u32> indices{};
+    [[nodiscard]] static VertexData convert_mesh(const aiMesh* mesh) {
+        VertexData data{};
+        auto& geometry = data.geometry;
+        auto& indices = data.indices;
 
         geometry.reserve(mesh->mNumVertices);
         for (usize i = 0; i < mesh->mNumVertices; ++i) {
@@ -78,29 +85,86 @@ namespace tethys {
             }
         }
 
-        auto& material = scene->mMaterials[mesh->mMaterialIndex];
-
-        sub_mesh.mesh = renderer::write_geometry(geometry, indices);
-        sub_mesh.albedo = try_load_texture(material, aiTextureType_DIFFUSE, model_path);
-        sub_mesh.metallic = try_load_texture(material, aiTextureType_SPECULAR, model_path);
-        sub_mesh.normal = try_load_texture(material, aiTextureType_HEIGHT, model_path);
-
-        return sub_mesh;
+        return data;
     }
 
-    static void process_node(const aiScene* scene, const aiNode* node, std::vector<Model::SubMesh>& meshes, const std::string& model_path) {
+    // Meshes in node order, which is the order submeshes are stored in
+    static void collect_meshes(const aiScene* scene, const aiNode* node, std::vector<const aiMesh*>& meshes) {
         for (usize i = 0; i < node->mNumMeshes; i++) {
-            auto mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.emplace_back(load_mesh(scene, mesh, model_path));
+            meshes.emplace_back(scene->mMeshes[node->mMeshes[i]]);
         }
 
         for (usize i = 0; i < node->mNumChildren; i++) {
-            process_node(scene, node->mChildren[i], meshes, model_path);
+            collect_meshes(scene, node->mChildren[i], meshes);
         }
     }
 
-    Model load_model(const std::string& path) {
-        Model model;
+    // Adds path to the textures to decode unless it is already requested, or loaded and skip_loaded is set
+    static void request_texture(ModelImport& result, std::unordered_map<std::string, usize>& requested, const std::string& path, const usize slot, const bool skip_loaded) {
+        if (path.empty() || requested.find(path) != requested.end()) {
+            return;
+        }
+
+        if (skip_loaded && loaded_textures.find(path) != loaded_textures.end()) {
+            return;
+        }
+
+        requested[path] = result.textures.size();
+        result.textures.push_back({ path, model_texture_types[slot] == aiTextureType_DIFFUSE ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm, {} });
+    }
+
+    static void decode_textures(ModelImport& result, jobs::Counter& counter) {
+        for (auto& request : result.textures) {
+            jobs::submit([&request]() {
+                request.image = decode_image(request.path.c_str());
+            }, counter);
+        }
+    }
+
+    static void upload_textures(ModelImport& result) {
+        for (auto& request : result.textures) {
+            // Loaded by another import while this one was being decoded
+            if (loaded_textures.find(request.path) == loaded_textures.end()) {
+                logger::info("Loading texture: " + request.path);
+
+                loaded_textures[request.path] = renderer::upload_texture(request.image.pixels.get(), request.image.width, request.image.height, request.format);
+            }
+
+            free_image(request.image);
+        }
+    }
+
+    static void assign_textures(Model::SubMesh& sub_mesh, const std::array<std::string, 3>& paths) {
+        sub_mesh.albedo = paths[0].empty() ? default_texture(model_texture_types[0]) : loaded_textures[paths[0]];
+        sub_mesh.metallic = paths[1].empty() ? default_texture(model_texture_types[1]) : loaded_textures[paths[1]];
+        sub_mesh.normal = paths[2].empty() ? default_texture(model_texture_types[2]) : loaded_textures[paths[2]];
+    }
+
+    // ACMR over every mesh, weighted by triangle count
+    static void log_optimisation(const std::string& path, const std::vector<optimise::Stats>& stats) {
+        usize triangles = 0;
+        usize vertices_before = 0;
+        usize vertices_after = 0;
+        f32 misses_before = 0.0f;
+        f32 misses_after = 0.0f;
+
+        for (const auto& mesh : stats) {
+            triangles += mesh.triangles;
+            vertices_before += mesh.vertices_before;
+            vertices_after += mesh.vertices_after;
+            misses_before += mesh.acmr_before * mesh.triangles;
+            misses_after += mesh.acmr_after * mesh.triangles;
+        }
+
+        if (triangles == 0) {
+            return;
+        }
+
+        logger::info("Optimised {}: {} -> {} vertices, ACMR {} -> {}", path, vertices_before, vertices_after, misses_before / triangles, misses_after / triangles);
+    }
+
+    ModelImport import_model(const std::string& path, const bool load_textures, const bool skip_loaded, const bool decode) {
+        ModelImport result{};
         Assimp::Importer importer;
 
         auto scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
@@ -109,82 +173,161 @@ namespace tethys {
             throw std::runtime_error("Failed to load model");
         }
 
-        process_node(scene, scene->mRootNode, model.submeshes, path.substr(0, path.find_last_of('/')));
+        std::vector<const aiMesh*> meshes{};
+        collect_meshes(scene, scene->mRootNode, meshes);
 
-        return model;
+        const auto model_path = path.substr(0, path.find_last_of('/'));
+        std::unordered_map<std::string, usize> requested{};
+
+        result.texture_paths.resize(load_textures ? meshes.size() : 0);
+
+        for (usize i = 0; i < result.texture_paths.size(); ++i) {
+            const auto material = scene->mMaterials[meshes[i]->mMaterialIndex];
+
+            for (usize j = 0; j < model_texture_types.size(); ++j) {
+                result.texture_paths[i][j] = texture_path(material, model_texture_types[j], model_path);
+                request_texture(result, requested, result.texture_paths[i][j], j, skip_loaded);
+            }
+        }
+
+        result.meshes.resize(meshes.size());
+        std::vector<optimise::Stats> stats(meshes.size());
+        jobs::Counter counter{};
+
+        // Assimp output is an unindexed triangle soup, welding, reordering, simplification and clustering happen with the conversion
+        jobs::parallel_for(meshes.size(), 1, [&meshes, &result, &stats](const usize first, const usize last) {
+            for (usize i = first; i < last; ++i) {
+                result.meshes[i] = convert_mesh(meshes[i]);
+                stats[i] = optimise::mesh(result.meshes[i]);
+                optimise::lods(result.meshes[i]);
+                optimise::meshlets(result.meshes[i]);
+            }
+        }, counter);
+
+        if (decode) {
+            decode_textures(result, counter);
+        }
+
+        jobs::wait(counter);
+
+        log_optimisation(path, stats);
+
+        return result;
     }
 
-    static Model::SubMesh load_mesh_pbr(const aiMesh* mesh) {
-        Model::SubMesh sub_mesh{};
-        std::vector<Vertex> geometry{};
-        std::vector<u32> indices{};
+    // Geometry is copied from the mapped file straight into staging memory
+    static void write_baked(Model& model, ModelImport& result) {
+        const auto& file = result.baked;
+
+        for (usize i = 0; i < file.header->submesh_count; ++i) {
+            const auto& baked = file.submeshes[i];
+
+            Model::SubMesh sub_mesh{};
+            sub_mesh.mesh = renderer::write_geometry(
+                file.vertices + baked.vertex_offset,
+                baked.vertex_count,
+                file.indices + baked.index_offset,
+                baked.index_count,
+                baked.lods,
+                baked.lod_count,
+                file.meshlets + baked.meshlet_offset,
+                baked.meshlet_count);
+
+            if (!result.texture_paths.empty()) {
+                assign_textures(sub_mesh, result.texture_paths[i]);
+            }
 
-        geometry.reserve(mesh->mNumVertices);
-        for (usize i = 0; i < mesh->mNumVertices; ++i) {
-            Vertex vertex{};
+            model.submeshes.emplace_back(sub_mesh);
+        }
+    }
 
-            vertex.pos.x = mesh->mVertices[i].x;
-            vertex.pos.y = mesh->mVertices[i].y;
-            vertex.pos.z = mesh->mVertices[i].z;
+    Model finish_import(ModelImport& result) {
+        Model model;
 
-            vertex.norms.x = mesh->mNormals[i].x;
-            vertex.norms.y = mesh->mNormals[i].y;
-            vertex.norms.z = mesh->mNormals[i].z;
+        upload_textures(result);
 
-            if (mesh->mTextureCoords[0]) {
-                vertex.uvs.x = mesh->mTextureCoords[0][i].x;
-                vertex.uvs.y = mesh->mTextureCoords[0][i].y;
+        if (result.baked.header) {
+            model.submeshes.reserve(result.baked.header->submesh_count);
+
+            try {
+                write_baked(model, result);
+            } catch (...) {
+                tmesh::close(result.baked);
+                throw;
             }
 
-            vertex.tangent.x = mesh->mTangents[i].x;
-            vertex.tangent.y = mesh->mTangents[i].y;
-            vertex.tangent.z = mesh->mTangents[i].z;
+            tmesh::close(result.baked);
 
-            vertex.bitangent.x = mesh->mBitangents[i].x;
-            vertex.bitangent.y = mesh->mBitangents[i].y;
-            vertex.bitangent.z = mesh->mBitangents[i].z;
+            return model;
+        }
 
-            geometry.emplace_back(vertex);
+        model.submeshes.reserve(result.meshes.size());
+
+        for (usize i = 0; i < result.meshes.size(); ++i) {
+            Model::SubMesh sub_mesh{};
+            sub_mesh.mesh = renderer::write_geometry(result.meshes[i]);
+
+            if (!result.texture_paths.empty()) {
+                assign_textures(sub_mesh, result.texture_paths[i]);
+            }
+
+            model.submeshes.emplace_back(sub_mesh);
         }
 
-        indices.reserve(mesh->mNumFaces * 3);
+        return model;
+    }
 
-        for (usize i = 0; i < mesh->mNumFaces; i++) {
-            auto& face = mesh->mFaces[i];
-            for (usize j = 0; j < face.mNumIndices; j++) {
-                indices.emplace_back(face.mIndices[j]);
+    // Validates the baked file and decodes its textures, the file stays mapped until finish_import
+    [[nodiscard]] static ModelImport import_baked(const std::string& path, const bool load_textures, const bool skip_loaded) {
+        ModelImport result{};
+        result.baked = tmesh::open(tmesh::baked_path(path));
+
+        const auto& file = result.baked;
+        const auto model_path = path.substr(0, path.find_last_of('/'));
+        std::unordered_map<std::string, usize> requested{};
+
+        result.texture_paths.resize(load_textures ? file.header->submesh_count : 0);
+
+        for (usize i = 0; i < result.texture_paths.size(); ++i) {
+            for (usize j = 0; j < model_texture_types.size(); ++j) {
+                const auto name = file.submeshes[i].textures[j];
+
+                if (name != tmesh::no_texture) {
+                    result.texture_paths[i][j] = model_path + "/" + (file.strings + name);
+                    request_texture(result, requested, result.texture_paths[i][j], j, skip_loaded);
+                }
             }
         }
 
-        sub_mesh.mesh = renderer::write_geometry(geometry, indices);
+        jobs::Counter counter{};
+        decode_textures(result, counter);
+        jobs::wait(counter);
 
-        return sub_mesh;
+        return result;
     }
 
-    static void process_node_pbr(const aiScene* scene, const aiNode* node, std::vector<Model::SubMesh>& meshes) {
-        for (usize i = 0; i < node->mNumMeshes; i++) {
-            auto mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.emplace_back(load_mesh_pbr(mesh));
+    ModelImport import_any(const std::string& path, const bool load_textures, const bool skip_loaded) {
+        if (tmesh::up_to_date(path)) {
+            try {
+                return import_baked(path, load_textures, skip_loaded);
+            } catch (const std::runtime_error& error) {
+                logger::warning("{}, importing {} instead", error.what(), path);
+            }
         }
 
-        for (usize i = 0; i < node->mNumChildren; i++) {
-            process_node_pbr(scene, node->mChildren[i], meshes);
-        }
+        return import_model(path, load_textures, skip_loaded);
     }
 
-    [[nodiscard]] Model load_model_pbr(const std::string& path) {
-        Model model;
-        Assimp::Importer importer;
-
-        auto scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+    Model load_model(const std::string& path) {
+        auto result = import_any(path, true, true);
 
-        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-            throw std::runtime_error("Failed to load model");
-        }
+        return finish_import(result);
+    }
 
-        process_node_pbr(scene, scene->mRootNode, model.submeshes);
+    [[nodiscard]] Model load_model_pbr(const std::string& path) {
+        auto result = import_any(path, false, true);
 
-        return model;
+        return finish_import(result);
     }
 
     Model load_model(const VertexData& data, const char* albedo, const char* metallic, const char* normal) {
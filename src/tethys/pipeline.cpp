@@ -23,31 +23,63 @@ namespace tethys {
             return set_layouts[layout::minimal];
         }
 
+        template <>
+        vk::DescriptorSetLayout& get<layout::cull>() {
+            return set_layouts[layout::cull];
+        }
+
+        template <>
+        vk::DescriptorSetLayout& get<layout::depth_reduce>() {
+            return set_layouts[layout::depth_reduce];
+        }
+
+        template <>
+        vk::DescriptorSetLayout& get<layout::deferred>() {
+            return set_layouts[layout::deferred];
+        }
+
+        template <>
+        vk::DescriptorSetLayout& get<layout::visibility>() {
+            return set_layouts[layout::visibility];
+        }
+
         void load() {
-            set_layouts.resize(2);
+            set_layouts.resize(6);
 
             /* Minimal set layout */ {
-                std::array<vk::DescriptorSetLayoutBinding, 3> layout_bindings{}; {
+                std::array<vk::DescriptorSetLayoutBinding, 5> layout_bindings{}; {
                     layout_bindings[0].descriptorCount = 1;
                     layout_bindings[0].descriptorType = vk::DescriptorType::eUniformBuffer;
                     layout_bindings[0].binding = binding::camera;
-                    layout_bindings[0].stageFlags = vk::ShaderStageFlagBits::eVertex;
+                    layout_bindings[0].stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eCompute;
 
                     layout_bindings[1].descriptorCount = 1;
                     layout_bindings[1].descriptorType = vk::DescriptorType::eStorageBuffer;
                     layout_bindings[1].binding = binding::transform;
-                    layout_bindings[1].stageFlags = vk::ShaderStageFlagBits::eVertex;
-
-                    layout_bindings[2].descriptorCount = 1024;
-                    layout_bindings[2].descriptorType = vk::DescriptorType::eCombinedImageSampler;
-                    layout_bindings[2].binding = binding::texture;
-                    layout_bindings[2].stageFlags = vk::ShaderStageFlagBits::eFragment;
+                    layout_bindings[1].stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[2].descriptorCount = 1;
+                    layout_bindings[2].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[2].binding = binding::draw;
+                    layout_bindings[2].stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[3].descriptorCount = 1;
+                    layout_bindings[3].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[3].binding = binding::instances;
+                    layout_bindings[3].stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[4].descriptorCount = 1024;
+                    layout_bindings[4].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+                    layout_bindings[4].binding = binding::texture;
+                    layout_bindings[4].stageFlags = vk::ShaderStageFlagBits::eFragment;
                 }
 
-                std::array<vk::DescriptorBindingFlags, 3> binding_flags{}; {
+                std::array<vk::DescriptorBindingFlags, 5> binding_flags{}; {
                     binding_flags[0] = {};
                     binding_flags[1] = {};
-                    binding_flags[2] = vk::DescriptorBindingFlagBits::eVariableDescriptorCount | vk::DescriptorBindingFlagBits::ePartiallyBound;
+                    binding_flags[2] = {};
+                    binding_flags[3] = {};
+                    binding_flags[4] = vk::DescriptorBindingFlagBits::eVariableDescriptorCount | vk::DescriptorBindingFlagBits::ePartiallyBound;
                 }
 
                 vk::DescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{}; {
@@ -65,17 +97,31 @@ namespace tethys {
             }
 
             /* Generic set layout */ {
-                std::array<vk::DescriptorSetLayoutBinding, 2> layout_bindings{}; {
+                std::array<vk::DescriptorSetLayoutBinding, 5> layout_bindings{}; {
                     layout_bindings[0].descriptorCount = 1;
                     layout_bindings[0].descriptorType = vk::DescriptorType::eStorageBuffer;
                     layout_bindings[0].binding = binding::point_light;
-                    layout_bindings[0].stageFlags = vk::ShaderStageFlagBits::eFragment;
+                    layout_bindings[0].stageFlags = vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute;
 
                     layout_bindings[1].descriptorCount = 1;
                     layout_bindings[1].descriptorType = vk::DescriptorType::eStorageBuffer;
                     layout_bindings[1].binding = binding::directional_light;
                     layout_bindings[1].stageFlags = vk::ShaderStageFlagBits::eFragment;
 
+                    layout_bindings[2].descriptorCount = 1;
+                    layout_bindings[2].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[2].binding = binding::light_clusters;
+                    layout_bindings[2].stageFlags = vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[3].descriptorCount = 1;
+                    layout_bindings[3].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[3].binding = binding::light_indices;
+                    layout_bindings[3].stageFlags = vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[4].descriptorCount = 1;
+                    layout_bindings[4].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[4].binding = binding::light_stats;
+                    layout_bindings[4].stageFlags = vk::ShaderStageFlagBits::eCompute;
                 }
 
                 vk::DescriptorSetLayoutCreateInfo set_layout_create_info{}; {
@@ -85,6 +131,166 @@ namespace tethys {
 
                 layout::get<layout::generic>() = context.device.logical.createDescriptorSetLayout(set_layout_create_info, nullptr, context.dispatcher);
             }
+
+            /* Cull set layout */ {
+                std::array<vk::DescriptorSetLayoutBinding, 12> layout_bindings{}; {
+                    layout_bindings[0].descriptorCount = 1;
+                    layout_bindings[0].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[0].binding = binding::cull_data;
+                    layout_bindings[0].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[1].descriptorCount = 1;
+                    layout_bindings[1].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[1].binding = binding::visible_commands;
+                    layout_bindings[1].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[2].descriptorCount = 1;
+                    layout_bindings[2].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[2].binding = binding::visibility;
+                    layout_bindings[2].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[3].descriptorCount = 1;
+                    layout_bindings[3].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[3].binding = binding::cull_stats;
+                    layout_bindings[3].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[4].descriptorCount = 1;
+                    layout_bindings[4].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+                    layout_bindings[4].binding = binding::depth_pyramid;
+                    layout_bindings[4].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[5].descriptorCount = 1;
+                    layout_bindings[5].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[5].binding = binding::meshlets;
+                    layout_bindings[5].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[6].descriptorCount = 1;
+                    layout_bindings[6].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[6].binding = binding::geometry_indices;
+                    layout_bindings[6].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[7].descriptorCount = 1;
+                    layout_bindings[7].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[7].binding = binding::meshlet_work;
+                    layout_bindings[7].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[8].descriptorCount = 1;
+                    layout_bindings[8].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[8].binding = binding::meshlet_dispatch;
+                    layout_bindings[8].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[9].descriptorCount = 1;
+                    layout_bindings[9].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[9].binding = binding::command_batches;
+                    layout_bindings[9].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[10].descriptorCount = 1;
+                    layout_bindings[10].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[10].binding = binding::compacted_commands;
+                    layout_bindings[10].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[11].descriptorCount = 1;
+                    layout_bindings[11].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[11].binding = binding::draw_counts;
+                    layout_bindings[11].stageFlags = vk::ShaderStageFlagBits::eCompute;
+                }
+
+                vk::DescriptorSetLayoutCreateInfo set_layout_create_info{}; {
+                    set_layout_create_info.bindingCount = layout_bindings.size();
+                    set_layout_create_info.pBindings = layout_bindings.data();
+                }
+
+                layout::get<layout::cull>() = context.device.logical.createDescriptorSetLayout(set_layout_create_info, nullptr, context.dispatcher);
+            }
+
+            /* Depth reduce set layout */ {
+                std::array<vk::DescriptorSetLayoutBinding, 2> layout_bindings{}; {
+                    layout_bindings[0].descriptorCount = 1;
+                    layout_bindings[0].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+                    layout_bindings[0].binding = binding::reduce_source;
+                    layout_bindings[0].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[1].descriptorCount = 1;
+                    layout_bindings[1].descriptorType = vk::DescriptorType::eStorageImage;
+                    layout_bindings[1].binding = binding::reduce_target;
+                    layout_bindings[1].stageFlags = vk::ShaderStageFlagBits::eCompute;
+                }
+
+                vk::DescriptorSetLayoutCreateInfo set_layout_create_info{}; {
+                    set_layout_create_info.bindingCount = layout_bindings.size();
+                    set_layout_create_info.pBindings = layout_bindings.data();
+                }
+
+                layout::get<layout::depth_reduce>() = context.device.logical.createDescriptorSetLayout(set_layout_create_info, nullptr, context.dispatcher);
+            }
+
+            /* Deferred lighting set layout */ {
+                std::array<vk::DescriptorSetLayoutBinding, 4> layout_bindings{}; {
+                    layout_bindings[0].descriptorCount = 1;
+                    layout_bindings[0].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+                    layout_bindings[0].binding = binding::gbuffer_albedo;
+                    layout_bindings[0].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[1].descriptorCount = 1;
+                    layout_bindings[1].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+                    layout_bindings[1].binding = binding::gbuffer_normal;
+                    layout_bindings[1].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[2].descriptorCount = 1;
+                    layout_bindings[2].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+                    layout_bindings[2].binding = binding::gbuffer_depth;
+                    layout_bindings[2].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[3].descriptorCount = 1;
+                    layout_bindings[3].descriptorType = vk::DescriptorType::eStorageImage;
+                    layout_bindings[3].binding = binding::lit;
+                    layout_bindings[3].stageFlags = vk::ShaderStageFlagBits::eCompute;
+                }
+
+                vk::DescriptorSetLayoutCreateInfo set_layout_create_info{}; {
+                    set_layout_create_info.bindingCount = layout_bindings.size();
+                    set_layout_create_info.pBindings = layout_bindings.data();
+                }
+
+                layout::get<layout::deferred>() = context.device.logical.createDescriptorSetLayout(set_layout_create_info, nullptr, context.dispatcher);
+            }
+
+            /* Visibility buffer set layout */ {
+                std::array<vk::DescriptorSetLayoutBinding, 5> layout_bindings{}; {
+                    // The visibility pass maps its instances to triangle IDs with it
+                    layout_bindings[0].descriptorCount = 1;
+                    layout_bindings[0].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[0].binding = binding::visibility_draws;
+                    layout_bindings[0].stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[1].descriptorCount = 1;
+                    layout_bindings[1].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+                    layout_bindings[1].binding = binding::visibility_ids;
+                    layout_bindings[1].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[2].descriptorCount = 1;
+                    layout_bindings[2].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[2].binding = binding::visibility_vertices;
+                    layout_bindings[2].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[3].descriptorCount = 1;
+                    layout_bindings[3].descriptorType = vk::DescriptorType::eStorageBuffer;
+                    layout_bindings[3].binding = binding::visibility_indices;
+                    layout_bindings[3].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+                    layout_bindings[4].descriptorCount = 1;
+                    layout_bindings[4].descriptorType = vk::DescriptorType::eStorageImage;
+                    layout_bindings[4].binding = binding::visibility_lit;
+                    layout_bindings[4].stageFlags = vk::ShaderStageFlagBits::eCompute;
+                }
+
+                vk::DescriptorSetLayoutCreateInfo set_layout_create_info{}; {
+                    set_layout_create_info.bindingCount = layout_bindings.size();
+                    set_layout_create_info.pBindings = layout_bindings.data();
+                }
+
+                layout::get<layout::visibility>() = context.device.logical.createDescriptorSetLayout(set_layout_create_info, nullptr, context.dispatcher);
+            }
         }
     } // namespace tethys::layout
 
@@ -125,18 +331,38 @@ namespace tethys {
         }
         pipeline.layout = context.device.logical.createPipelineLayout(layout_create_info, nullptr, context.dispatcher);
 
-        std::array<vk::ShaderModule, 2> modules{}; {
-            modules[0] = load_module(info.vertex);
-            modules[1] = load_module(info.fragment);
+        std::vector<vk::ShaderModule> modules{}; {
+            modules.emplace_back(load_module(info.vertex));
+
+            if (!info.fragment.empty()) {
+                modules.emplace_back(load_module(info.fragment));
+            }
+        }
+
+        // constant_id = 0 in the vertex shaders, selects how the attributes are decoded
+        const vk::Bool32 packed_vertices = info.packed_vertices;
+
+        vk::SpecializationMapEntry specialization_entry{}; {
+            specialization_entry.constantID = 0;
+            specialization_entry.offset = 0;
+            specialization_entry.size = sizeof(vk::Bool32);
+        }
+
+        vk::SpecializationInfo specialization_info{}; {
+            specialization_info.mapEntryCount = 1;
+            specialization_info.pMapEntries = &specialization_entry;
+            specialization_info.dataSize = sizeof(vk::Bool32);
+            specialization_info.pData = &packed_vertices;
         }
 
         std::array<vk::PipelineShaderStageCreateInfo, 2> stages{}; {
             stages[0].pName = "main";
             stages[0].module = modules[0];
             stages[0].stage = vk::ShaderStageFlagBits::eVertex;
+            stages[0].pSpecializationInfo = &specialization_info;
 
             stages[1].pName = "main";
-            stages[1].module = modules[1];
+            stages[1].module = modules.back();
             stages[1].stage = vk::ShaderStageFlagBits::eFragment;
         }
 
@@ -147,7 +373,11 @@ namespace tethys {
 
         vk::VertexInputBindingDescription vertex_binding{}; {
             vertex_binding.binding = 0;
-            vertex_binding.stride = sizeof(Vertex);
+            if (info.packed_vertices) {
+                vertex_binding.stride = info.position_only ? sizeof(PackedVertex::pos) : sizeof(PackedVertex);
+            } else {
+                vertex_binding.stride = info.position_only ? sizeof(glm::vec3) : sizeof(Vertex);
+            }
             vertex_binding.inputRate = vk::VertexInputRate::eVertex;
         }
 
@@ -178,11 +408,30 @@ namespace tethys {
             vertex_attributes[4].offset = offsetof(Vertex, bitangent);
         }
 
+        if (info.packed_vertices) {
+            vertex_attributes[0].format = vk::Format::eR16G16B16A16Unorm;
+            vertex_attributes[0].offset = offsetof(PackedVertex, pos);
+
+            vertex_attributes[1].format = vk::Format::eR16G16Snorm;
+            vertex_attributes[1].offset = offsetof(PackedVertex, norms);
+
+            vertex_attributes[2].format = vk::Format::eR16G16Sfloat;
+            vertex_attributes[2].offset = offsetof(PackedVertex, uvs);
+
+            vertex_attributes[3].format = vk::Format::eR16G16Snorm;
+            vertex_attributes[3].offset = offsetof(PackedVertex, tangent);
+
+            // There is no bitangent, the location still needs a source. The shaders rebuild it from the normal and tangent
+            vertex_attributes[4].format = vk::Format::eR16G16Snorm;
+            vertex_attributes[4].offset = offsetof(PackedVertex, tangent);
+        }
+
         vk::PipelineVertexInputStateCreateInfo vertex_input_info{}; {
             vertex_input_info.pVertexBindingDescriptions = &vertex_binding;
             vertex_input_info.vertexBindingDescriptionCount = 1;
             vertex_input_info.pVertexAttributeDescriptions = vertex_attributes.data();
-            vertex_input_info.vertexAttributeDescriptionCount = vertex_attributes.size();
+            // The position is the first attribute at offset 0, so it lines up with the position-only stream too
+            vertex_input_info.vertexAttributeDescriptionCount = info.position_only ? 1 : vertex_attributes.size();
         }
 
         vk::PipelineInputAssemblyStateCreateInfo input_assembly{}; {
@@ -218,18 +467,18 @@ namespace tethys {
 
         vk::PipelineMultisampleStateCreateInfo multisampling_state_info{}; {
             multisampling_state_info.alphaToCoverageEnable = false;
-            multisampling_state_info.sampleShadingEnable = true;
+            multisampling_state_info.sampleShadingEnable = info.sample_shading && info.samples != vk::SampleCountFlagBits::e1;
             multisampling_state_info.alphaToOneEnable = false;
             multisampling_state_info.rasterizationSamples = info.samples;
-            multisampling_state_info.minSampleShading = 0.2f;
+            multisampling_state_info.minSampleShading = 1.0f;
             multisampling_state_info.pSampleMask = nullptr;
         }
 
         vk::PipelineDepthStencilStateCreateInfo depth_stencil_info{}; {
             depth_stencil_info.stencilTestEnable = false;
             depth_stencil_info.depthTestEnable = true;
-            depth_stencil_info.depthWriteEnable = true;
-            depth_stencil_info.depthCompareOp = vk::CompareOp::eLessOrEqual;
+            depth_stencil_info.depthWriteEnable = info.depth_write;
+            depth_stencil_info.depthCompareOp = info.depth_compare;
             depth_stencil_info.depthBoundsTestEnable = false;
             depth_stencil_info.minDepthBounds = 0.0f;
             depth_stencil_info.maxDepthBounds = 1.0f;
@@ -239,12 +488,14 @@ namespace tethys {
         }
 
         vk::PipelineColorBlendAttachmentState color_blend_attachment{}; {
-            color_blend_attachment.blendEnable = true;
-            color_blend_attachment.colorWriteMask =
-                vk::ColorComponentFlagBits::eR |
-                vk::ColorComponentFlagBits::eG |
-                vk::ColorComponentFlagBits::eB |
-                vk::ColorComponentFlagBits::eA;
+            color_blend_attachment.blendEnable = info.blending && info.color_attachments == 1;
+            if (!info.fragment.empty()) {
+                color_blend_attachment.colorWriteMask =
+                    vk::ColorComponentFlagBits::eR |
+                    vk::ColorComponentFlagBits::eG |
+                    vk::ColorComponentFlagBits::eB |
+                    vk::ColorComponentFlagBits::eA;
+            }
             color_blend_attachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
             color_blend_attachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
             color_blend_attachment.colorBlendOp = vk::BlendOp::eAdd;
@@ -253,9 +504,11 @@ namespace tethys {
             color_blend_attachment.alphaBlendOp = vk::BlendOp::eAdd;
         }
 
+        const std::vector<vk::PipelineColorBlendAttachmentState> color_blend_attachments(info.color_attachments, color_blend_attachment);
+
         vk::PipelineColorBlendStateCreateInfo color_blend_info{}; {
-            color_blend_info.attachmentCount = 1;
-            color_blend_info.pAttachments = &color_blend_attachment;
+            color_blend_info.attachmentCount = color_blend_attachments.size();
+            color_blend_info.pAttachments = color_blend_attachments.data();
             color_blend_info.logicOp = vk::LogicOp::eCopy;
             color_blend_info.logicOpEnable = false;
             color_blend_info.blendConstants[0] = 0.0f;
@@ -265,7 +518,7 @@ namespace tethys {
         }
 
         vk::GraphicsPipelineCreateInfo pipeline_info{}; {
-            pipeline_info.stageCount = stages.size();
+            pipeline_info.stageCount = modules.size();
             pipeline_info.pStages = stages.data();
             pipeline_info.pVertexInputState = &vertex_input_info;
             pipeline_info.pInputAssemblyState = &input_assembly;
@@ -292,4 +545,55 @@ namespace tethys {
 
         return pipeline;
     }
+
+    Pipeline make_compute_pipeline(const Pipeline::ComputeCreateInfo& info) {
+        Pipeline pipeline{};
+
+        vk::PipelineLayoutCreateInfo layout_create_info{}; {
+            if (info.push_constants.size != 0) {
+                layout_create_info.pushConstantRangeCount = 1;
+                layout_create_info.pPushConstantRanges = &info.push_constants;
+            }
+            if (!info.layouts.empty()) {
+                layout_create_info.setLayoutCount = info.layouts.size();
+                layout_create_info.pSetLayouts = info.layouts.data();
+            }
+        }
+        pipeline.layout = context.device.logical.createPipelineLayout(layout_create_info, nullptr, context.dispatcher);
+
+        auto module = load_module(info.compute);
+
+        const vk::Bool32 packed_vertices = info.packed_vertices;
+
+        vk::SpecializationMapEntry specialization_entry{}; {
+            specialization_entry.constantID = 0;
+            specialization_entry.offset = 0;
+            specialization_entry.size = sizeof(vk::Bool32);
+        }
+
+        vk::SpecializationInfo specialization_info{}; {
+            specialization_info.mapEntryCount = 1;
+            specialization_info.pMapEntries = &specialization_entry;
+            specialization_info.dataSize = sizeof(vk::Bool32);
+            specialization_info.pData = &packed_vertices;
+        }
+
+        vk::ComputePipelineCreateInfo pipeline_info{}; {
+            pipeline_info.stage.pName = "main";
+            pipeline_info.stage.module = module;
+            pipeline_info.stage.stage = vk::ShaderStageFlagBits::eCompute;
+            pipeline_info.stage.pSpecializationInfo = &specialization_info;
+            pipeline_info.layout = pipeline.layout;
+            pipeline_info.basePipelineHandle = nullptr;
+            pipeline_info.basePipelineIndex = -1;
+        }
+
+        pipeline.handle = context.device.logical.createComputePipeline(nullptr, pipeline_info, nullptr, context.dispatcher);
+
+        logger::info("Compute pipeline successfully created");
+
+        context.device.logical.destroyShaderModule(module, nullptr, context.dispatcher);
+
+        return pipeline;
+    }
 } // namespace tethys
\ No newline at end of file
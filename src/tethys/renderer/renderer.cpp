@@ -1,21 +1,26 @@
 #include <tethys/api/command_buffer.hpp>
+#include <tethys/api/command_pool.hpp>
 #include <tethys/api/descriptor_set.hpp>
+#include <tethys/api/geometry_buffer.hpp>
 #include <tethys/renderer/renderer.hpp>
 #include <tethys/directional_light.hpp>
-#include <tethys/api/vertex_buffer.hpp>
 #include <tethys/api/static_buffer.hpp>
+#include <tethys/api/upload.hpp>
 #include <tethys/api/render_target.hpp>
-#include <tethys/api/index_buffer.hpp>
 #include <tethys/api/render_pass.hpp>
 #include <tethys/api/framebuffer.hpp>
 #include <tethys/api/sampler.hpp>
 #include <tethys/point_light.hpp>
 #include <tethys/render_data.hpp>
+#include <tethys/draw_data.hpp>
 #include <tethys/api/context.hpp>
 #include <tethys/api/buffer.hpp>
 #include <tethys/constants.hpp>
 #include <tethys/pipeline.hpp>
 #include <tethys/texture.hpp>
+#include <tethys/culling.hpp>
+#include <tethys/jobs.hpp>
+#include <tethys/logger.hpp>
 #include <tethys/model.hpp>
 #include <tethys/types.hpp>
 
@@ -24,7 +29,18 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <condition_variable>
+#include <unordered_map>
+#include <stdexcept>
+#include <numeric>
 #include <vector>
+#include <tuple>
+#include <thread>
+#include <deque>
 #include <stack>
 #include <mutex>
 
@@ -33,7 +49,31 @@ namespace tethys {
         static auto& context = api::context;
 
         static vk::RenderPass offscreen_render_pass{};
+        // Second pass of two-phase occlusion culling, continues on top of the first one
+        static vk::RenderPass resume_render_pass{};
         static vk::Framebuffer offscreen_framebuffer{};
+        // Sample count of the offscreen target and of every pipeline drawing to it
+        static vk::SampleCountFlagBits samples{};
+        static bool sample_shading{};
+        // Post-process pass from offscreen.color into offscreen.aa, which is then copied to the swapchain instead
+        static bool fxaa{};
+        static api::SingleDescriptorSet fxaa_set{};
+
+        // Deferred path: draws fill the G-buffer, deferred_lighting shades it into gbuffer.lit in 16x16 tiles
+        static bool deferred_shading{};
+        static api::GBuffer gbuffer{};
+        static vk::RenderPass gbuffer_render_pass{};
+        static vk::Framebuffer gbuffer_framebuffer{};
+        static api::SingleDescriptorSet deferred_set{};
+
+        // Visibility buffer path: draws only write a triangle ID, visibility_resolve rebuilds every pixel's triangle
+        // from the geometry arena and shades it with the clustered lights into visibility_target.lit
+        static bool visibility_shading{};
+        static api::VisibilityBuffer visibility_target{};
+        static vk::RenderPass visibility_render_pass{};
+        static vk::Framebuffer visibility_framebuffer{};
+        static api::DescriptorSet visibility_set{};
+        static std::array<vk::Buffer, api::frames_in_flight> bound_vertices{};
 
         static std::vector<vk::Semaphore> image_available{};
         static std::vector<vk::Semaphore> render_finished{};
@@ -41,45 +81,583 @@ namespace tethys {
 
         static std::vector<vk::CommandBuffer> command_buffers{};
 
+        // One pool per recording worker, pools must not be used from two threads at once
+        static std::vector<vk::CommandPool> worker_pools{};
+        // Indexed by [worker][image_index]
+        static std::vector<std::vector<vk::CommandBuffer>> secondary_buffers{};
+        static std::vector<std::vector<vk::CommandBuffer>> prepass_buffers{};
+        // Minimum number of indirect commands per worker before recording is split across threads. Batches are cut
+        // every max_batch_commands commands so the command list can be sliced evenly between workers
+        constexpr usize commands_per_worker = 1024;
+        constexpr u32 max_batch_commands = 256;
+        // Secondary buffers recorded for the last frame, 0 when it was recorded inline
+        static u32 recording_workers{};
+
         static u32 image_index{};
         static u32 current_frame{};
 
         static api::Offscreen offscreen{};
 
+        // Every mesh lives in this arena so all draws share a single vertex/index buffer bind
+        static api::GeometryBuffer geometry_arena{};
+
         // Part of set 0
         static api::Buffer<Camera> camera_buffer{};
         static api::Buffer<glm::mat4> transform_buffer{};
+        static api::Buffer<DrawData> draw_buffer{};
+        // Draw index of every visible instance, one section per culling phase
+        static api::Buffer<u32> instance_buffer{};
         // Part of set 1
         static api::Buffer<PointLight> point_light_buffer{};
         static api::Buffer<DirectionalLight> directional_light_buffer{};
+        // Written by the light clustering pass, never touched by the CPU
+        static std::array<api::StaticBuffer, api::frames_in_flight> light_cluster_buffers{};
+        static std::array<api::StaticBuffer, api::frames_in_flight> light_index_buffers{};
+        // Counted by the light list passes, cleared by the host before each frame
+        static api::Buffer<LightStats> light_stats_buffer{};
+        static LightStats last_light_stats{};
+
+        // Culling pass: reads cull_buffer, adds every surviving draw as an instance of its group's command in
+        // visible_buffer and writes its draw index to the group's instance slots. Both hold one section per culling phase
+        static api::Buffer<CullData> cull_buffer{};
+        static api::Buffer<VkDrawIndexedIndirectCommand> visible_buffer{};
+        static api::Buffer<CullStats> cull_stats_buffer{};
+        // Shared by all frames in flight, each frame reads what the previous one left
+        static api::SingleBuffer<u32> visibility_buffer{};
+        static bool reset_visibility{};
+        static CullStats last_stats{};
+
+        // Meshlet pass: the culling pass hands it full detail draws through meshlet_work_buffer and allocates their
+        // scratch slots from meshlet_dispatch_buffer, frame N owns the Nth meshlet_scratch slots of the index arena
+        static bool meshlet_culling{};
+        static u32 meshlet_scratch{};
+        static api::Buffer<MeshletWork> meshlet_work_buffer{};
+        static api::Buffer<MeshletDispatch> meshlet_dispatch_buffer{};
+        // Arena buffers the cull set of each frame points at, they are replaced when the arena grows
+        static std::array<vk::Buffer, api::frames_in_flight> bound_indices{};
+        static std::array<vk::Buffer, api::frames_in_flight> bound_meshlets{};
 
         static api::DescriptorSet generic_set{};
         static api::DescriptorSet minimal_set{};
+        static api::DescriptorSet cull_set{};
+        // One per pyramid level, each reads the level above it
+        static std::vector<api::SingleDescriptorSet> depth_reduce_sets{};
 
         static Pipeline minimal;
         static Pipeline generic;
         static Pipeline pbr;
+        static Pipeline cull;
+        static Pipeline meshlet_cull;
+        static Pipeline compact;
+        static Pipeline depth_resolve;
+        static Pipeline depth_reduce;
+        static Pipeline light_cluster;
+        static Pipeline depth_only;
+        static Pipeline gbuffer_lit;
+        static Pipeline gbuffer_unlit;
+        static Pipeline deferred_lighting;
+        static Pipeline visibility_ids;
+        static Pipeline visibility_resolve;
+        static Pipeline fxaa_filter;
+
+        // Depth-only pass over the position stream, colour pipelines then test with eEqual and don't write depth
+        static bool depth_prepass{};
+        // The geometry arena stores PackedVertex, pipelines read it with the packed attribute layout
+        static bool packed_vertices{};
+
+        // Level of detail selection, by the culling pass or cpu_cull_pass. draw_lods is the level each draw used
+        // last frame on the CPU path, the GPU path keeps it in the visibility buffer
+        static bool lod_enabled{};
+        static f32 lod_threshold{};
+        static f32 lod_hysteresis{};
+        static std::vector<u32> draw_lods{};
+
+        // One fragment invocation query per frame in flight, bit N set once frame N has written its query
+        static vk::QueryPool statistics_pool{};
+        static u32 statistics_written{};
+        static u64 last_fragment_invocations{};
+
+        struct CullConstants {
+            std::array<glm::vec4, 6> planes{};
+            u32 draw_count{};
+            u32 command_count{};
+            u32 slot_count{};
+            u32 phase{};
+            u32 occlusion{};
+            // A level is usable when error * scale * lod_scale <= distance, (1 - lod_hysteresis) when coarser than last frame
+            f32 lod_scale{};
+            f32 lod_hysteresis{};
+            // Only read by the compaction pass
+            u32 batch_count{};
+        };
+
+        // Fragment push constants of the lit pipelines, also pushed to the light clustering pass
+        struct LightingConstants {
+            u32 point_lights_count{};
+            u32 directional_lights_count{};
+            f32 near{};
+            f32 far{};
+            glm::vec2 tile_size{};
+        };
+
+        static LightingConstants lighting{};
+
+        struct VisibilityConstants {
+            LightingConstants lighting{};
+            u32 draw_count{};
+        };
+
+        constexpr u32 cull_group_size = 64;
+        constexpr u32 light_cluster_group_size = 64;
+        constexpr u32 reduce_group_size = 8;
+        constexpr u32 deferred_tile_size = 16;
+        constexpr u32 resolve_group_size = 8;
+        constexpr u32 fxaa_group_size = 8;
+
+        static bool occlusion_culling{};
+
+        // CPU culling path, world space spheres follow draw_list order. They are rebuilt when draw_list is, otherwise
+        // only the draws of instances in dirty_spheres are moved. instance_draws lists the draws of every instance,
+        // those of instance i start at instance_draw_offsets[i]
+        static bool cpu_culling{};
+        static f32 draw_distance{};
+        static culling::Spheres world_spheres{};
+        static bool spheres_stale{};
+        static std::vector<u32> dirty_spheres{};
+        static std::vector<u32> instance_draw_offsets{};
+        static std::vector<u32> instance_draws{};
+        static std::vector<u32> visible_draws{};
+        static std::vector<VkDrawIndexedIndirectCommand> visible_list{};
+        static std::vector<u32> instance_list{};
+        // Commands with visible instances per batch, parallel to draw_batches. They are moved to the front of the batch
+        static std::vector<u32> visible_counts{};
+
+        // Static batch pieces are gathered in chunks of up to this many vertices, small enough to cull well. A piece larger
+        // than this gets a chunk of its own, each chunk's index type follows its own vertex count like any mesh
+        constexpr usize static_chunk_vertices = 1u << 14u;
+
+        // Consecutive draws of the same mesh with the same pipeline are drawn as one instanced command per level of
+        // detail, their DrawData stays per draw so materials may differ
+        static bool instancing{};
+
+        struct InstanceGroup {
+            u32 first{};
+            u32 count{};
+        };
+
+        // Consecutive indirect commands sharing a pipeline and index type, issued with a single drawIndexedIndirect.
+        // A batch is closed once it holds max_batch_commands commands
+        struct DrawBatch {
+            Pipeline pipeline{};
+            u32 sets{};
+            bool short_indices{};
+            u32 first{};
+            u32 count{};
+        };
+
+        // 64-bit draw sort key: | pipeline: 4 | descriptor sets: 3 | index type: 1 | mesh: 32 | material: 24 |
+        // Ties are broken by the full depth of the draw, kept next to the key so it can be replaced on its own.
+        // Mesh outranks material so every draw of a mesh is contiguous and can be instanced whatever its material.
+        // State outranks depth on purpose: draws are only front to back within a run of the same pipeline, mesh and
+        // material, so the binds and instanced commands stay few. Scenes bound by overdraw should use the depth pre-pass
+        namespace sort_key {
+            constexpr inline u64 pipeline_shift = 60;
+            constexpr inline u64 sets_shift = 57;
+            constexpr inline u64 index_type_shift = 56;
+            constexpr inline u64 mesh_shift = 24;
+            constexpr inline u64 material_shift = 0;
+        } // namespace tethys::renderer::sort_key
+
+        // draw is the item's index in draw_list as of the last build_draws
+        struct SortItem {
+            u64 key{};
+            u32 depth{};
+            u32 command{};
+            u32 submesh{};
+            u32 draw{};
+        };
+
+        // Sorted draw list, rebuilt when instances are added or removed and when a depth re-sort changes the order.
+        // command_list holds the commands of both culling phases with instanceCount = 0, the culling
+        // passes count the instances in
+        static std::vector<SortItem> sort_items{};
+        static std::vector<DrawData> draw_list{};
+        static std::vector<VkDrawIndexedIndirectCommand> command_list{};
+        static u32 command_count{};
+        static u32 instance_slots{};
+        static std::vector<CullData> cull_list{};
+        static std::vector<DrawBatch> draw_batches{};
+
+        // Depth only breaks ties between draws of the same pipeline, mesh and material, which share an instanced command
+        // whatever their order. It is re-keyed only when draws are issued one by one, at most every depth_sort_interval
+        // frames and only if the camera moved since the last time
+        constexpr u32 depth_sort_interval = 30;
+        static u32 frames_since_depth_sort{};
+        static glm::vec4 depth_sort_position{};
+
+        struct CommandBatch {
+            u32 batch{};
+            u32 first{};
+        };
+
+        // Compaction pass, with VK_KHR_draw_indirect_count on the GPU culling path: the commands that drew anything are
+        // moved to the front of their batch in compacted_buffer and counted into draw_count_buffer, one section per
+        // culling phase in both. command_batch_list maps every command of a phase to its batch
+        static bool compaction{};
+        static std::vector<CommandBatch> command_batch_list{};
+        static api::Buffer<CommandBatch> command_batch_buffer{};
+        static api::Buffer<VkDrawIndexedIndirectCommand> compacted_buffer{};
+        static api::Buffer<u32> draw_count_buffer{};
+
+        // Retained scene, handles index straight into these
+        static std::vector<Model> models{};
+        static std::vector<u32> model_generation{};
+        static std::vector<u32> free_models{};
+        static std::vector<DrawCommand> instances{};
+        static std::vector<u8> instance_alive{};
+        static std::vector<u32> instance_generation{};
+        static std::vector<u32> free_instances{};
+
+        // Lights are uploaded densely, removing one moves the last light into its place. Handles go through a slot
+        // that follows the light around
+        struct LightSlots {
+            std::vector<u32> dense{};
+            std::vector<u32> slot{};
+            std::vector<u32> generation{};
+            std::vector<u32> free{};
+        };
+
+        static std::vector<PointLight> point_lights{};
+        static LightSlots point_light_slots{};
+        static std::vector<DirectionalLight> directional_lights{};
+        static LightSlots directional_light_slots{};
+
+        // Bit N set means frame in flight N has yet to receive the change
+        constexpr u32 all_frames = (1u << api::frames_in_flight) - 1;
+        // Set in instance_dirty while the instance is queued in dirty_spheres
+        constexpr u32 sphere_dirty = 1u << 31u;
+        static std::vector<u32> instance_dirty{};
+        static std::array<std::vector<u32>, api::frames_in_flight> dirty_transforms{};
+        static u32 stale_draws{};
+        static u32 stale_point_lights{};
+        static u32 stale_directional_lights{};
+        static bool scene_changed{};
 
         static std::vector<Texture> builtin_textures{};
         static std::vector<vk::DescriptorImageInfo> texture_descriptors{};
+        // Sets still in use by a frame in flight are rewritten when that frame comes around again
+        static u32 stale_textures{};
+
+        // Assets requested through the async API. The loader thread does the CPU work, draw() records the uploads
+        // and swaps the result in once they have completed
+        struct AsyncLoad {
+            enum class Kind {
+                model,
+                texture
+            };
+
+            Kind kind{};
+            std::string path{};
+            vk::Format format{};
+            // Model handle or texture descriptor slot the result replaces, models removed meanwhile drop the result
+            usize target{};
+            u32 generation{};
+            ModelImport model{};
+            ImageData image{};
+            bool failed{};
+        };
+
+        struct Loader {
+            std::thread thread{};
+            std::mutex mutex{};
+            std::condition_variable condition{};
+            std::deque<AsyncLoad> requests{};
+            std::vector<AsyncLoad> decoded{};
+            bool stop{};
+
+            ~Loader() {
+                if (!thread.joinable()) {
+                    return;
+                }
+
+                {
+                    std::lock_guard lock{ mutex };
+                    stop = true;
+                }
+
+                condition.notify_one();
+                thread.join();
+            }
+        };
+
+        // Recorded into an upload batch that has not retired yet
+        struct StreamedAsset {
+            AsyncLoad::Kind kind{};
+            usize target{};
+            u32 generation{};
+            api::UploadToken upload{};
+            Model model{};
+            Texture texture{};
+        };
+
+        static Loader loader{};
+        static std::vector<StreamedAsset> streamed_assets{};
+
+        static u32 register_texture(const Texture& texture) {
+            texture_descriptors.emplace_back(texture.info(api::SamplerType::eDefault));
+            stale_textures = all_frames;
+
+            return static_cast<u32>(texture_descriptors.size() - 1);
+        }
 
         static void update_textures() {
+            if (!(stale_textures & 1u << current_frame)) {
+                return;
+            }
+
+            stale_textures &= ~(1u << current_frame);
+
             api::UpdateImageInfo info{}; {
                 info.image = texture_descriptors.data();
                 info.size = texture_descriptors.size();
                 info.type = vk::DescriptorType::eCombinedImageSampler;
                 info.binding = binding::texture;
             }
-            minimal_set.update(info);
+            minimal_set[current_frame].update(info);
+        }
+
+        static void loader_main() {
+            while (true) {
+                AsyncLoad load{};
+
+                {
+                    std::unique_lock lock{ loader.mutex };
+                    loader.condition.wait(lock, []() {
+                        return loader.stop || !loader.requests.empty();
+                    });
+
+                    if (loader.stop) {
+                        return;
+                    }
+
+                    load = std::move(loader.requests.front());
+                    loader.requests.pop_front();
+                }
+
+                try {
+                    if (load.kind == AsyncLoad::Kind::model) {
+                        load.model = import_any(load.path, true, false);
+                    } else {
+                        load.image = decode_image(load.path.c_str());
+                        load.failed = !load.image.pixels;
+                    }
+                } catch (const std::exception& error) {
+                    logger::warning("Failed to load {}: {}", load.path, error.what());
+                    load.failed = true;
+                }
+
+                std::lock_guard lock{ loader.mutex };
+                loader.decoded.emplace_back(std::move(load));
+            }
+        }
+
+        static void request_load(AsyncLoad&& load) {
+            {
+                std::lock_guard lock{ loader.mutex };
+
+                if (!loader.thread.joinable()) {
+                    loader.thread = std::thread(loader_main);
+                }
+
+                loader.requests.emplace_back(std::move(load));
+            }
+
+            loader.condition.notify_one();
+        }
+
+        // Called once per frame after its fence, assets only change between frames
+        static void update_streaming() {
+            std::vector<AsyncLoad> decoded{};
+
+            {
+                std::lock_guard lock{ loader.mutex };
+                decoded.swap(loader.decoded);
+            }
+
+            for (auto& load : decoded) {
+                if (load.failed) {
+                    continue;
+                }
+
+                StreamedAsset asset{}; {
+                    asset.kind = load.kind;
+                    asset.target = load.target;
+                    asset.generation = load.generation;
+                }
+
+                try {
+                    if (load.kind == AsyncLoad::Kind::model) {
+                        asset.model = finish_import(load.model);
+                    } else {
+                        asset.texture = load_texture(load.image.pixels.get(), load.image.width, load.image.height, 4, load.format);
+                        free_image(load.image);
+                    }
+                } catch (const std::exception& error) {
+                    logger::warning("Failed to upload {}: {}", load.path, error.what());
+                    continue;
+                }
+
+                asset.upload = api::flush_uploads();
+                streamed_assets.emplace_back(std::move(asset));
+            }
+
+            for (auto it = streamed_assets.begin(); it != streamed_assets.end();) {
+                if (!api::upload_complete(it->upload)) {
+                    ++it;
+                    continue;
+                }
+
+                if (it->kind == AsyncLoad::Kind::model) {
+                    if (model_generation[it->target] == it->generation) {
+                        models[it->target] = std::move(it->model);
+                        scene_changed = true;
+                    }
+                } else {
+                    texture_descriptors[it->target] = it->texture.info(api::SamplerType::eDefault);
+                    stale_textures = all_frames;
+                }
+
+                it = streamed_assets.erase(it);
+            }
+
+            update_textures();
         }
 
-        void initialise() {
-            offscreen = api::make_offscreen_target();
+        void initialise(const Settings& settings) {
+            const auto software = context.device.physical.getProperties(context.dispatcher).deviceType == vk::PhysicalDeviceType::eCpu;
+
+            if (settings.culling == Culling::automatic) {
+                cpu_culling = software;
+            } else {
+                cpu_culling = settings.culling == Culling::cpu;
+            }
+
+            draw_distance = settings.draw_distance;
+            occlusion_culling = !cpu_culling && settings.occlusion_culling;
+            deferred_shading = settings.shading == Shading::deferred;
+            visibility_shading = settings.shading == Shading::visibility && context.device.primitive_id;
+
+            if (settings.shading == Shading::visibility && !visibility_shading) {
+                logger::warning("The visibility buffer needs gl_PrimitiveID in fragment shaders, using forward shading");
+            }
+
+            logger::info("{} shading", deferred_shading ? "Deferred" : visibility_shading ? "Visibility buffer" : "Forward");
+
+            // Both targets are single sampled, the pyramid and the pre-pass work on the forward depth
+            const auto single_sampled = deferred_shading || visibility_shading;
+
+            // Fragment cost grows with every sample, software rasterizers pay the most for it
+            const auto requested = single_sampled ? 1u : settings.samples == 0 ? software ? 1u : 4u : settings.samples;
+            const auto supported = std::min(static_cast<u32>(context.device.samples), 8u);
+
+            u32 sample_count = 1;
+            while (sample_count * 2 <= requested && sample_count * 2 <= supported) {
+                sample_count *= 2;
+            }
+
+            if (sample_count != requested) {
+                logger::warning("{} samples requested, using {}", requested, sample_count);
+            }
+
+            samples = static_cast<vk::SampleCountFlagBits>(sample_count);
+            sample_shading = settings.sample_shading && sample_count > 1;
+            fxaa = settings.fxaa;
+            logger::info("{}x MSAA, sample shading {}, FXAA {}", sample_count, sample_shading ? "on" : "off", fxaa ? "on" : "off");
+
+            if (single_sampled && occlusion_culling) {
+                logger::warning("Occlusion culling is only supported with forward shading, disabled");
+                occlusion_culling = false;
+            }
+
+            logger::info("Culling on the {}, occlusion culling {}", cpu_culling ? "CPU" : "GPU", occlusion_culling ? "on" : "off");
+
+            depth_prepass = settings.depth_prepass && !single_sampled;
+
+            if (settings.depth_prepass && single_sampled) {
+                logger::warning("The depth pre-pass is only supported with forward shading, disabled");
+            }
+
+            packed_vertices = settings.packed_vertices;
+            logger::info("Depth pre-pass {}", depth_prepass ? "on" : "off");
+
+            lod_enabled = settings.lod;
+            lod_threshold = settings.lod_threshold;
+            lod_hysteresis = settings.lod_hysteresis;
+            logger::info("Level of detail {}", lod_enabled ? "on" : "off");
+
+            meshlet_culling = settings.meshlet_culling && !cpu_culling && !visibility_shading;
+            meshlet_scratch = settings.meshlet_scratch;
+
+            if (settings.meshlet_culling && cpu_culling) {
+                logger::warning("Meshlet culling needs GPU culling, disabled");
+            }
+
+            // The CPU path compacts its commands on the host
+            compaction = !cpu_culling && context.device.draw_indirect_count;
+
+            // Triangle IDs are counted from the draw's own index range, not from the compacted scratch slots
+            if (settings.meshlet_culling && visibility_shading) {
+                logger::warning("Meshlet culling is not supported with the visibility buffer, disabled");
+            }
+
+            logger::info("Meshlet culling {}", meshlet_culling ? "on" : "off");
+
+            instancing = settings.instancing;
+            logger::info("Instancing {}", instancing ? "on" : "off");
+
+            offscreen = api::make_offscreen_target(samples, fxaa);
             offscreen_render_pass = api::make_offscreen_render_pass(offscreen);
+            resume_render_pass = api::make_offscreen_render_pass(offscreen, true);
             offscreen_framebuffer = api::make_offscreen_framebuffer(offscreen, offscreen_render_pass);
 
+            if (deferred_shading) {
+                gbuffer = api::make_gbuffer_target();
+                gbuffer_render_pass = api::make_gbuffer_render_pass(gbuffer);
+                gbuffer_framebuffer = api::make_gbuffer_framebuffer(gbuffer, gbuffer_render_pass);
+            }
+
+            if (visibility_shading) {
+                visibility_target = api::make_visibility_target();
+                visibility_render_pass = api::make_visibility_render_pass(visibility_target);
+                visibility_framebuffer = api::make_visibility_framebuffer(visibility_target, visibility_render_pass);
+            }
+
             command_buffers = api::make_rendering_command_buffers();
 
+            // Slices are bound to pools, not threads, so any job thread may record any slice
+            const auto workers = jobs::worker_count() + 1;
+
+            worker_pools.reserve(workers);
+            secondary_buffers.reserve(workers);
+            prepass_buffers.reserve(workers);
+
+            for (u32 i = 0; i < workers; ++i) {
+                secondary_buffers.emplace_back(api::make_secondary_command_buffers(worker_pools.emplace_back(api::make_command_pool())));
+                prepass_buffers.emplace_back(api::make_secondary_command_buffers(worker_pools.back()));
+            }
+
+            if (context.device.pipeline_statistics) {
+                vk::QueryPoolCreateInfo query_pool_info{}; {
+                    query_pool_info.queryType = vk::QueryType::ePipelineStatistics;
+                    query_pool_info.queryCount = api::frames_in_flight;
+                    query_pool_info.pipelineStatistics = vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+                }
+
+                statistics_pool = context.device.logical.createQueryPool(query_pool_info, nullptr, context.dispatcher);
+            }
+
+            geometry_arena = api::make_geometry_buffer(1u << 18u, 1u << 20u, packed_vertices, meshlet_culling ? api::frames_in_flight * meshlet_scratch : 0);
+
             vk::SemaphoreCreateInfo semaphore_create_info{};
 
             image_available.reserve(api::frames_in_flight);
@@ -99,20 +677,19 @@ namespace tethys {
                 minimal_info.fragment = "shaders/minimal.frag.spv";
                 minimal_info.subpass_idx = 0;
                 minimal_info.render_pass = offscreen_render_pass;
-                minimal_info.samples = context.device.samples;
+                minimal_info.samples = samples;
+                minimal_info.sample_shading = sample_shading;
                 minimal_info.cull = vk::CullModeFlagBits::eNone;
+                minimal_info.depth_write = !depth_prepass;
+                minimal_info.depth_compare = depth_prepass ? vk::CompareOp::eEqual : vk::CompareOp::eLessOrEqual;
                 minimal_info.dynamic_states = {
                     vk::DynamicState::eViewport,
                     vk::DynamicState::eScissor
                 };
+                minimal_info.packed_vertices = packed_vertices;
                 minimal_info.layouts = {
                     layout::get<layout::minimal>()
                 };
-                minimal_info.push_constants = {
-                    vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
-                    0,
-                    sizeof(u32) * 2
-                };
             }
             minimal = make_pipeline(minimal_info);
 
@@ -121,20 +698,24 @@ namespace tethys {
                 generic_info.fragment = "shaders/generic.frag.spv";
                 generic_info.subpass_idx = 0;
                 generic_info.render_pass = offscreen_render_pass;
-                generic_info.samples = context.device.samples;
+                generic_info.samples = samples;
+                generic_info.sample_shading = sample_shading;
                 generic_info.cull = vk::CullModeFlagBits::eNone;
+                generic_info.depth_write = !depth_prepass;
+                generic_info.depth_compare = depth_prepass ? vk::CompareOp::eEqual : vk::CompareOp::eLessOrEqual;
                 generic_info.dynamic_states = {
                     vk::DynamicState::eViewport,
                     vk::DynamicState::eScissor
                 };
+                generic_info.packed_vertices = packed_vertices;
                 generic_info.layouts = {
                     layout::get<layout::minimal>(),
                     layout::get<layout::generic>()
                 };
                 generic_info.push_constants = {
-                    vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
+                    vk::ShaderStageFlagBits::eFragment,
                     0,
-                    sizeof(u32) * 6
+                    sizeof(LightingConstants)
                 };
             }
             generic = make_pipeline(generic_info);
@@ -144,33 +725,260 @@ namespace tethys {
                 pbr_info.fragment = "shaders/pbr.frag.spv";
                 pbr_info.subpass_idx = 0;
                 pbr_info.render_pass = offscreen_render_pass;
-                pbr_info.samples = context.device.samples;
+                pbr_info.samples = samples;
+                pbr_info.sample_shading = sample_shading;
                 pbr_info.cull = vk::CullModeFlagBits::eNone;
+                pbr_info.depth_write = !depth_prepass;
+                pbr_info.depth_compare = depth_prepass ? vk::CompareOp::eEqual : vk::CompareOp::eLessOrEqual;
                 pbr_info.dynamic_states = {
                     vk::DynamicState::eViewport,
                     vk::DynamicState::eScissor
                 };
+                pbr_info.packed_vertices = packed_vertices;
                 pbr_info.layouts = {
                     layout::get<layout::minimal>(),
                     layout::get<layout::generic>()
                 };
                 pbr_info.push_constants = {
-                    vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
+                    vk::ShaderStageFlagBits::eFragment,
                     0,
-                    sizeof(u32) * 8
+                    sizeof(LightingConstants)
                 };
             }
             pbr = make_pipeline(pbr_info);
 
+            Pipeline::CreateInfo depth_only_info{}; {
+                depth_only_info.vertex = "shaders/depth.vert.spv";
+                depth_only_info.subpass_idx = 0;
+                depth_only_info.render_pass = offscreen_render_pass;
+                depth_only_info.samples = samples;
+                depth_only_info.cull = vk::CullModeFlagBits::eNone;
+                depth_only_info.dynamic_states = {
+                    vk::DynamicState::eViewport,
+                    vk::DynamicState::eScissor
+                };
+                depth_only_info.packed_vertices = packed_vertices;
+                depth_only_info.layouts = {
+                    layout::get<layout::minimal>()
+                };
+                depth_only_info.position_only = true;
+            }
+            depth_only = make_pipeline(depth_only_info);
+
+            if (deferred_shading) {
+                Pipeline::CreateInfo gbuffer_lit_info{}; {
+                    gbuffer_lit_info.vertex = "shaders/pbr.vert.spv";
+                    gbuffer_lit_info.fragment = "shaders/gbuffer.frag.spv";
+                    gbuffer_lit_info.subpass_idx = 0;
+                    gbuffer_lit_info.render_pass = gbuffer_render_pass;
+                    gbuffer_lit_info.samples = vk::SampleCountFlagBits::e1;
+                    gbuffer_lit_info.cull = vk::CullModeFlagBits::eNone;
+                    gbuffer_lit_info.depth_write = true;
+                    gbuffer_lit_info.depth_compare = vk::CompareOp::eLessOrEqual;
+                    gbuffer_lit_info.color_attachments = 2;
+                    gbuffer_lit_info.dynamic_states = {
+                        vk::DynamicState::eViewport,
+                        vk::DynamicState::eScissor
+                    };
+                    gbuffer_lit_info.packed_vertices = packed_vertices;
+                    gbuffer_lit_info.layouts = {
+                        layout::get<layout::minimal>()
+                    };
+                }
+                gbuffer_lit = make_pipeline(gbuffer_lit_info);
+
+                Pipeline::CreateInfo gbuffer_unlit_info{}; {
+                    gbuffer_unlit_info.vertex = "shaders/minimal.vert.spv";
+                    gbuffer_unlit_info.fragment = "shaders/gbuffer_unlit.frag.spv";
+                    gbuffer_unlit_info.subpass_idx = 0;
+                    gbuffer_unlit_info.render_pass = gbuffer_render_pass;
+                    gbuffer_unlit_info.samples = vk::SampleCountFlagBits::e1;
+                    gbuffer_unlit_info.cull = vk::CullModeFlagBits::eNone;
+                    gbuffer_unlit_info.depth_write = true;
+                    gbuffer_unlit_info.depth_compare = vk::CompareOp::eLessOrEqual;
+                    gbuffer_unlit_info.color_attachments = 2;
+                    gbuffer_unlit_info.dynamic_states = {
+                        vk::DynamicState::eViewport,
+                        vk::DynamicState::eScissor
+                    };
+                    gbuffer_unlit_info.packed_vertices = packed_vertices;
+                    gbuffer_unlit_info.layouts = {
+                        layout::get<layout::minimal>()
+                    };
+                }
+                gbuffer_unlit = make_pipeline(gbuffer_unlit_info);
+
+                Pipeline::ComputeCreateInfo deferred_lighting_info{}; {
+                    deferred_lighting_info.compute = "shaders/deferred.comp.spv";
+                    deferred_lighting_info.layouts = {
+                        layout::get<layout::minimal>(),
+                        layout::get<layout::generic>(),
+                        layout::get<layout::deferred>()
+                    };
+                    deferred_lighting_info.push_constants = {
+                        vk::ShaderStageFlagBits::eCompute,
+                        0,
+                        sizeof(LightingConstants)
+                    };
+                }
+                deferred_lighting = make_compute_pipeline(deferred_lighting_info);
+            }
+
+            if (visibility_shading) {
+                Pipeline::CreateInfo visibility_ids_info{}; {
+                    visibility_ids_info.vertex = "shaders/visibility.vert.spv";
+                    visibility_ids_info.fragment = "shaders/visibility.frag.spv";
+                    visibility_ids_info.subpass_idx = 0;
+                    visibility_ids_info.render_pass = visibility_render_pass;
+                    visibility_ids_info.samples = vk::SampleCountFlagBits::e1;
+                    visibility_ids_info.cull = vk::CullModeFlagBits::eNone;
+                    visibility_ids_info.depth_write = true;
+                    visibility_ids_info.depth_compare = vk::CompareOp::eLessOrEqual;
+                    visibility_ids_info.blending = false;
+                    visibility_ids_info.dynamic_states = {
+                        vk::DynamicState::eViewport,
+                        vk::DynamicState::eScissor
+                    };
+                    visibility_ids_info.packed_vertices = packed_vertices;
+                    visibility_ids_info.position_only = true;
+                    visibility_ids_info.layouts = {
+                        layout::get<layout::minimal>(),
+                        layout::get<layout::generic>(),
+                        layout::get<layout::visibility>()
+                    };
+                }
+                visibility_ids = make_pipeline(visibility_ids_info);
+
+                Pipeline::ComputeCreateInfo visibility_resolve_info{}; {
+                    visibility_resolve_info.compute = "shaders/visibility.comp.spv";
+                    visibility_resolve_info.packed_vertices = packed_vertices;
+                    visibility_resolve_info.layouts = {
+                        layout::get<layout::minimal>(),
+                        layout::get<layout::generic>(),
+                        layout::get<layout::visibility>()
+                    };
+                    visibility_resolve_info.push_constants = {
+                        vk::ShaderStageFlagBits::eCompute,
+                        0,
+                        sizeof(VisibilityConstants)
+                    };
+                }
+                visibility_resolve = make_compute_pipeline(visibility_resolve_info);
+            }
+
+            Pipeline::ComputeCreateInfo cull_info{}; {
+                cull_info.compute = "shaders/cull.comp.spv";
+                cull_info.layouts = {
+                    layout::get<layout::minimal>(),
+                    layout::get<layout::cull>()
+                };
+                cull_info.push_constants = {
+                    vk::ShaderStageFlagBits::eCompute,
+                    0,
+                    sizeof(CullConstants)
+                };
+            }
+            cull = make_compute_pipeline(cull_info);
+
+            Pipeline::ComputeCreateInfo meshlet_cull_info{}; {
+                meshlet_cull_info.compute = "shaders/meshlet.comp.spv";
+                meshlet_cull_info.layouts = {
+                    layout::get<layout::minimal>(),
+                    layout::get<layout::cull>()
+                };
+                meshlet_cull_info.push_constants = {
+                    vk::ShaderStageFlagBits::eCompute,
+                    0,
+                    sizeof(CullConstants)
+                };
+            }
+            meshlet_cull = make_compute_pipeline(meshlet_cull_info);
+
+            if (compaction) {
+                Pipeline::ComputeCreateInfo compact_info{}; {
+                    compact_info.compute = "shaders/compact.comp.spv";
+                    compact_info.layouts = {
+                        layout::get<layout::minimal>(),
+                        layout::get<layout::cull>()
+                    };
+                    compact_info.push_constants = {
+                        vk::ShaderStageFlagBits::eCompute,
+                        0,
+                        sizeof(CullConstants)
+                    };
+                }
+                compact = make_compute_pipeline(compact_info);
+            }
+
+            // A single sampled depth buffer is copied into the pyramid as is
+            Pipeline::ComputeCreateInfo depth_resolve_info{}; {
+                depth_resolve_info.compute = samples == vk::SampleCountFlagBits::e1 ? "shaders/depth_copy.comp.spv" : "shaders/depth_resolve.comp.spv";
+                depth_resolve_info.layouts = {
+                    layout::get<layout::depth_reduce>()
+                };
+            }
+            depth_resolve = make_compute_pipeline(depth_resolve_info);
+
+            Pipeline::ComputeCreateInfo depth_reduce_info{}; {
+                depth_reduce_info.compute = "shaders/depth_reduce.comp.spv";
+                depth_reduce_info.layouts = {
+                    layout::get<layout::depth_reduce>()
+                };
+            }
+            depth_reduce = make_compute_pipeline(depth_reduce_info);
+
+            // Same source and target bindings as the pyramid reduction
+            if (fxaa) {
+                Pipeline::ComputeCreateInfo fxaa_info{}; {
+                    fxaa_info.compute = "shaders/fxaa.comp.spv";
+                    fxaa_info.layouts = {
+                        layout::get<layout::depth_reduce>()
+                    };
+                }
+                fxaa_filter = make_compute_pipeline(fxaa_info);
+            }
+
+            Pipeline::ComputeCreateInfo light_cluster_info{}; {
+                light_cluster_info.compute = "shaders/light_cluster.comp.spv";
+                light_cluster_info.layouts = {
+                    layout::get<layout::minimal>(),
+                    layout::get<layout::generic>()
+                };
+                light_cluster_info.push_constants = {
+                    vk::ShaderStageFlagBits::eCompute,
+                    0,
+                    sizeof(LightingConstants)
+                };
+            }
+            light_cluster = make_compute_pipeline(light_cluster_info);
+
             camera_buffer.create(vk::BufferUsageFlagBits::eUniformBuffer);
             transform_buffer.create(vk::BufferUsageFlagBits::eStorageBuffer);
+            draw_buffer.create(vk::BufferUsageFlagBits::eStorageBuffer);
+            instance_buffer.create(vk::BufferUsageFlagBits::eStorageBuffer);
+            cull_buffer.create(vk::BufferUsageFlagBits::eStorageBuffer);
+            visible_buffer.create(vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+            cull_stats_buffer.create(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst);
+            visibility_buffer.create(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst);
+            meshlet_work_buffer.create(vk::BufferUsageFlagBits::eStorageBuffer);
+            meshlet_dispatch_buffer.create(vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+            command_batch_buffer.create(vk::BufferUsageFlagBits::eStorageBuffer);
+            compacted_buffer.create(vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+            draw_count_buffer.create(vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst);
             point_light_buffer.create(vk::BufferUsageFlagBits::eStorageBuffer);
             directional_light_buffer.create(vk::BufferUsageFlagBits::eStorageBuffer);
+            light_stats_buffer.create(vk::BufferUsageFlagBits::eStorageBuffer);
+
+            for (u32 i = 0; i < api::frames_in_flight; ++i) {
+                light_cluster_buffers[i] = api::make_buffer(cluster::count * sizeof(u32), vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_GPU_ONLY, 0);
+                light_index_buffers[i] = api::make_buffer(cluster::count * cluster::max_lights * sizeof(u32), vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_GPU_ONLY, 0);
+            }
 
             generic_set.create(layout::get<layout::generic>());
             minimal_set.create(layout::get<layout::minimal>());
+            cull_set.create(layout::get<layout::cull>());
 
-            std::vector<api::UpdateBufferInfo> minimal_update(2); {
+            std::vector<api::UpdateBufferInfo> minimal_update(4); {
                 minimal_update[0].binding = binding::camera;
                 minimal_update[0].type = vk::DescriptorType::eUniformBuffer;
                 minimal_update[0].buffers = camera_buffer.info();
@@ -178,10 +986,18 @@ namespace tethys {
                 minimal_update[1].binding = binding::transform;
                 minimal_update[1].type = vk::DescriptorType::eStorageBuffer;
                 minimal_update[1].buffers = transform_buffer.info();
+
+                minimal_update[2].binding = binding::draw;
+                minimal_update[2].type = vk::DescriptorType::eStorageBuffer;
+                minimal_update[2].buffers = draw_buffer.info();
+
+                minimal_update[3].binding = binding::instances;
+                minimal_update[3].type = vk::DescriptorType::eStorageBuffer;
+                minimal_update[3].buffers = instance_buffer.info();
             }
             minimal_set.update(minimal_update);
 
-            std::vector<api::UpdateBufferInfo> generic_update(2); {
+            std::vector<api::UpdateBufferInfo> generic_update(5); {
                 generic_update[0].binding = binding::point_light;
                 generic_update[0].type = vk::DescriptorType::eStorageBuffer;
                 generic_update[0].buffers = point_light_buffer.info();
@@ -189,9 +1005,176 @@ namespace tethys {
                 generic_update[1].binding = binding::directional_light;
                 generic_update[1].type = vk::DescriptorType::eStorageBuffer;
                 generic_update[1].buffers = directional_light_buffer.info();
+
+                generic_update[2].binding = binding::light_clusters;
+                generic_update[2].type = vk::DescriptorType::eStorageBuffer;
+
+                generic_update[3].binding = binding::light_indices;
+                generic_update[3].type = vk::DescriptorType::eStorageBuffer;
+
+                generic_update[4].binding = binding::light_stats;
+                generic_update[4].type = vk::DescriptorType::eStorageBuffer;
+                generic_update[4].buffers = light_stats_buffer.info();
+
+                for (u32 i = 0; i < api::frames_in_flight; ++i) {
+                    generic_update[2].buffers[i] = vk::DescriptorBufferInfo{ light_cluster_buffers[i].handle, 0, VK_WHOLE_SIZE };
+                    generic_update[3].buffers[i] = vk::DescriptorBufferInfo{ light_index_buffers[i].handle, 0, VK_WHOLE_SIZE };
+                }
             }
             generic_set.update(generic_update);
 
+            std::vector<api::UpdateBufferInfo> cull_update(9); {
+                cull_update[0].binding = binding::cull_data;
+                cull_update[0].type = vk::DescriptorType::eStorageBuffer;
+                cull_update[0].buffers = cull_buffer.info();
+
+                cull_update[1].binding = binding::visible_commands;
+                cull_update[1].type = vk::DescriptorType::eStorageBuffer;
+                cull_update[1].buffers = visible_buffer.info();
+
+                cull_update[2].binding = binding::visibility;
+                cull_update[2].type = vk::DescriptorType::eStorageBuffer;
+                cull_update[2].buffers.fill(visibility_buffer.info());
+
+                cull_update[3].binding = binding::cull_stats;
+                cull_update[3].type = vk::DescriptorType::eStorageBuffer;
+                cull_update[3].buffers = cull_stats_buffer.info();
+
+                cull_update[4].binding = binding::meshlet_work;
+                cull_update[4].type = vk::DescriptorType::eStorageBuffer;
+                cull_update[4].buffers = meshlet_work_buffer.info();
+
+                cull_update[5].binding = binding::meshlet_dispatch;
+                cull_update[5].type = vk::DescriptorType::eStorageBuffer;
+                cull_update[5].buffers = meshlet_dispatch_buffer.info();
+
+                cull_update[6].binding = binding::command_batches;
+                cull_update[6].type = vk::DescriptorType::eStorageBuffer;
+                cull_update[6].buffers = command_batch_buffer.info();
+
+                cull_update[7].binding = binding::compacted_commands;
+                cull_update[7].type = vk::DescriptorType::eStorageBuffer;
+                cull_update[7].buffers = compacted_buffer.info();
+
+                cull_update[8].binding = binding::draw_counts;
+                cull_update[8].type = vk::DescriptorType::eStorageBuffer;
+                cull_update[8].buffers = draw_count_buffer.info();
+            }
+            cull_set.update(cull_update);
+
+            api::SingleUpdateImageInfo pyramid_info{}; {
+                pyramid_info.image.sampler = api::sampler_from_type(api::SamplerType::eNearest);
+                pyramid_info.image.imageView = offscreen.depth_pyramid.view;
+                pyramid_info.image.imageLayout = vk::ImageLayout::eGeneral;
+                pyramid_info.type = vk::DescriptorType::eCombinedImageSampler;
+                pyramid_info.binding = binding::depth_pyramid;
+            }
+            cull_set.update(pyramid_info);
+
+            depth_reduce_sets.resize(offscreen.depth_pyramid_levels.size());
+
+            for (usize i = 0; i < depth_reduce_sets.size(); ++i) {
+                auto& set = depth_reduce_sets[i];
+
+                api::SingleUpdateImageInfo source_info{}; {
+                    source_info.image.sampler = api::sampler_from_type(api::SamplerType::eNearest);
+                    source_info.image.imageView = i == 0 ? offscreen.depth.view : offscreen.depth_pyramid_levels[i - 1];
+                    source_info.image.imageLayout = i == 0 ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eGeneral;
+                    source_info.type = vk::DescriptorType::eCombinedImageSampler;
+                    source_info.binding = binding::reduce_source;
+                }
+
+                api::SingleUpdateImageInfo target_info{}; {
+                    target_info.image.imageView = offscreen.depth_pyramid_levels[i];
+                    target_info.image.imageLayout = vk::ImageLayout::eGeneral;
+                    target_info.type = vk::DescriptorType::eStorageImage;
+                    target_info.binding = binding::reduce_target;
+                }
+
+                set.create(layout::get<layout::depth_reduce>());
+                set.update(source_info);
+                set.update(target_info);
+            }
+
+            if (fxaa) {
+                api::SingleUpdateImageInfo source_info{}; {
+                    source_info.image.sampler = api::sampler_from_type(api::SamplerType::eLinear);
+                    source_info.image.imageView = offscreen.color.view;
+                    source_info.image.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+                    source_info.type = vk::DescriptorType::eCombinedImageSampler;
+                    source_info.binding = binding::reduce_source;
+                }
+
+                api::SingleUpdateImageInfo target_info{}; {
+                    target_info.image.imageView = offscreen.aa.view;
+                    target_info.image.imageLayout = vk::ImageLayout::eGeneral;
+                    target_info.type = vk::DescriptorType::eStorageImage;
+                    target_info.binding = binding::reduce_target;
+                }
+
+                fxaa_set.create(layout::get<layout::depth_reduce>());
+                fxaa_set.update(source_info);
+                fxaa_set.update(target_info);
+            }
+
+            if (deferred_shading) {
+                deferred_set.create(layout::get<layout::deferred>());
+
+                const std::array<std::pair<u32, const api::Image*>, 3> gbuffer_inputs{ {
+                    { binding::gbuffer_albedo, &gbuffer.albedo },
+                    { binding::gbuffer_normal, &gbuffer.normal },
+                    { binding::gbuffer_depth, &gbuffer.depth }
+                } };
+
+                for (const auto& [target, image] : gbuffer_inputs) {
+                    api::SingleUpdateImageInfo input_info{}; {
+                        input_info.image.sampler = api::sampler_from_type(api::SamplerType::eNearest);
+                        input_info.image.imageView = image->view;
+                        input_info.image.imageLayout = target == binding::gbuffer_depth ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eShaderReadOnlyOptimal;
+                        input_info.type = vk::DescriptorType::eCombinedImageSampler;
+                        input_info.binding = target;
+                    }
+                    deferred_set.update(input_info);
+                }
+
+                api::SingleUpdateImageInfo lit_info{}; {
+                    lit_info.image.imageView = gbuffer.lit.view;
+                    lit_info.image.imageLayout = vk::ImageLayout::eGeneral;
+                    lit_info.type = vk::DescriptorType::eStorageImage;
+                    lit_info.binding = binding::lit;
+                }
+                deferred_set.update(lit_info);
+            }
+
+            // Geometry arena bindings are filled in by update_geometry_bindings
+            if (visibility_shading) {
+                visibility_set.create(layout::get<layout::visibility>());
+
+                api::UpdateBufferInfo draws_info{}; {
+                    draws_info.binding = binding::visibility_draws;
+                    draws_info.type = vk::DescriptorType::eStorageBuffer;
+                    draws_info.buffers = cull_buffer.info();
+                }
+                visibility_set.update(draws_info);
+
+                api::SingleUpdateImageInfo ids_info{}; {
+                    ids_info.image.sampler = api::sampler_from_type(api::SamplerType::eNearest);
+                    ids_info.image.imageView = visibility_target.ids.view;
+                    ids_info.image.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+                    ids_info.type = vk::DescriptorType::eCombinedImageSampler;
+                    ids_info.binding = binding::visibility_ids;
+                }
+                visibility_set.update(ids_info);
+
+                api::SingleUpdateImageInfo lit_info{}; {
+                    lit_info.image.imageView = visibility_target.lit.view;
+                    lit_info.image.imageLayout = vk::ImageLayout::eGeneral;
+                    lit_info.type = vk::DescriptorType::eStorageImage;
+                    lit_info.binding = binding::visibility_lit;
+                }
+                visibility_set.update(lit_info);
+            }
+
             builtin_textures.reserve(3);
             texture_descriptors.reserve(3);
             builtin_textures.emplace_back(upload_texture(255, 255, 255, 255, vk::Format::eR8G8B8A8Srgb));
@@ -199,21 +1182,65 @@ namespace tethys {
             builtin_textures.emplace_back(upload_texture(0, 255, 0, 255, vk::Format::eR8G8B8A8Unorm));
         }
 
+        // Flat meshes still need a non-zero scale to quantise against
+        [[nodiscard]] static glm::vec3 position_extent(const Mesh& mesh) {
+            return glm::max(mesh.max - mesh.min, glm::vec3(1e-6f));
+        }
+
         Mesh write_geometry(const VertexData& data) {
-            return write_geometry(data.geometry, data.indices);
+            return write_geometry(
+                data.geometry.data(), data.geometry.size(),
+                data.indices.data(), data.indices.size(),
+                data.lods.data(), data.lods.size(),
+                data.meshlets.data(), data.meshlets.size());
         }
 
-        Mesh write_geometry(const std::vector<Vertex>& geometry, const std::vector<u32>& indices) {
+        Mesh write_geometry(const Vertex* geometry, const usize vertex_count, const u32* indices, const usize index_count, const MeshLod* lods, const usize lod_count, const Meshlet* meshlets, const usize meshlet_count) {
             Mesh mesh{}; {
-                mesh.vertex_count = geometry.size();
-                mesh.index_count = indices.size();
-                mesh.vbo = api::make_vertex_buffer(geometry);
-                mesh.ibo = api::make_index_buffer(indices);
+                mesh.vertex_count = vertex_count;
+                mesh.index_count = lod_count == 0 ? index_count : lods[0].index_count;
+                mesh.lod_count = lod_count == 0 ? 1 : std::min(lod_count, max_lods);
+                mesh.lods[0] = { 0, static_cast<u32>(mesh.index_count), 0.0f };
+                mesh.min = vertex_count == 0 ? glm::vec3(0.0f) : geometry[0].pos;
+                mesh.max = mesh.min;
+            }
+
+            for (usize i = 0; i < vertex_count; ++i) {
+                mesh.min = glm::min(mesh.min, geometry[i].pos);
+                mesh.max = glm::max(mesh.max, geometry[i].pos);
+            }
+
+            const auto range = api::append_geometry(geometry_arena, geometry, vertex_count, indices, index_count, mesh.min, position_extent(mesh));
+            mesh.vertex_offset = range.vertex_offset;
+            mesh.index_offset = range.index_offset;
+            mesh.short_indices = range.short_indices;
+
+            for (usize i = 1; i < mesh.lod_count; ++i) {
+                mesh.lods[i] = lods[i];
+            }
+
+            if (meshlet_culling && meshlet_count != 0) {
+                mesh.meshlet_offset = api::append_meshlets(geometry_arena, meshlets, meshlet_count);
+                mesh.meshlet_count = meshlet_count;
             }
 
+            // Centered on the box, radius taken from the vertices so it is tighter than the box diagonal
+            const auto center = (mesh.min + mesh.max) * 0.5f;
+            f32 radius = 0.0f;
+
+            for (usize i = 0; i < vertex_count; ++i) {
+                radius = std::max(radius, glm::length(geometry[i].pos - center));
+            }
+
+            mesh.sphere = glm::vec4(center, radius);
+
             return mesh;
         }
 
+        Mesh write_geometry(const std::vector<Vertex>& geometry, const std::vector<u32>& indices) {
+            return write_geometry(geometry.data(), geometry.size(), indices.data(), indices.size());
+        }
+
         Model upload_model(const std::string& path) {
             return load_model(path);
         }
@@ -232,9 +1259,51 @@ namespace tethys {
 
         Texture upload_texture(const char* path, const vk::Format color_space) {
             auto texture = load_texture(path, color_space);
+            texture.index = register_texture(texture);
 
-            texture_descriptors.emplace_back(texture.info(api::SamplerType::eDefault));
-            update_textures();
+            return texture;
+        }
+
+        Texture upload_texture(const u8* pixels, const u32 width, const u32 height, const vk::Format color_space) {
+            auto texture = load_texture(pixels, width, height, 4, color_space);
+            texture.index = register_texture(texture);
+
+            return texture;
+        }
+
+        Handle<Model> upload_model_async(const std::string& path) {
+            // A single empty level, collect_sort_items leaves it out of the draw lists until the model is swapped in
+            Model::SubMesh placeholder{}; {
+                placeholder.mesh.lod_count = 1;
+                placeholder.albedo = builtin_textures[texture::white];
+                placeholder.metallic = builtin_textures[texture::black];
+                placeholder.normal = builtin_textures[texture::green];
+            }
+
+            const auto handle = add_model(Model{ { placeholder } });
+
+            AsyncLoad load{}; {
+                load.kind = AsyncLoad::Kind::model;
+                load.path = path;
+                load.target = handle.index;
+                load.generation = handle.generation;
+            }
+            request_load(std::move(load));
+
+            return handle;
+        }
+
+        Texture upload_texture_async(const char* path, const vk::Format color_space, const u32 placeholder) {
+            auto texture = builtin_textures[placeholder];
+            texture.index = register_texture(texture);
+
+            AsyncLoad load{}; {
+                load.kind = AsyncLoad::Kind::texture;
+                load.path = path;
+                load.format = color_space;
+                load.target = texture.index;
+            }
+            request_load(std::move(load));
 
             return texture;
         }
@@ -244,45 +1313,432 @@ namespace tethys {
                 r, g, b, a
             };
             auto texture = load_texture(data, 1, 1, 4, color_space);
-
-            texture_descriptors.emplace_back(texture.info(api::SamplerType::eDefault));
-            update_textures();
+            texture.index = register_texture(texture);
 
             return texture;
         }
 
-        static void update_transforms(const RenderData& data) {
-            auto& current = transform_buffer[current_frame];
+        static void mark_transform(const usize index) {
+            for (u32 frame = 0; frame < api::frames_in_flight; ++frame) {
+                if (!(instance_dirty[index] & 1u << frame)) {
+                    dirty_transforms[frame].emplace_back(index);
+                }
+            }
+
+            if (cpu_culling && !(instance_dirty[index] & sphere_dirty)) {
+                dirty_spheres.emplace_back(index);
+            }
+
+            instance_dirty[index] = all_frames | sphere_dirty;
+        }
+
+        Handle<Model> add_model(const Model& model) {
+            if (!free_models.empty()) {
+                const auto index = free_models.back();
+                free_models.pop_back();
 
-            std::vector<glm::mat4> transforms;
-            transforms.reserve(data.draw_commands.size());
+                models[index] = model;
 
-            for (const auto& each : data.draw_commands) {
-                transforms.emplace_back(each.transform);
+                return { index, model_generation[index] };
             }
 
-            if (current.size() == transforms.size()) {
-                current.write(transforms);
-            } else {
-                current.write(transforms);
+            models.emplace_back(model);
+            model_generation.emplace_back(0);
 
-                api::SingleUpdateBufferInfo info{}; {
-                    info.buffer = current.info();
-                    info.type = vk::DescriptorType::eStorageBuffer;
-                    info.binding = binding::transform;
-                }
+            return { models.size() - 1, 0 };
+        }
 
-                minimal_set[current_frame].update(info);
+        void remove_model(const Handle<Model> handle) {
+            if (handle.index >= models.size() || model_generation[handle.index] != handle.generation) {
+                logger::warning("Model handle {} is stale, ignored", handle.index);
+                return;
             }
+
+            // The geometry stays in the arena, like the geometry of models replaced by a streamed result
+            models[handle.index] = {};
+            ++model_generation[handle.index];
+            free_models.emplace_back(handle.index);
+            scene_changed = true;
         }
 
-        static void update_camera(const Camera& camera) {
-            auto& current = camera_buffer[current_frame];
+        Handle<DrawCommand> add_instance(const DrawCommand& command) {
+            usize index{};
 
-            if (current.size() == 1) {
-                current.write(camera);
+            if (!free_instances.empty()) {
+                index = free_instances.back();
+                free_instances.pop_back();
+
+                instances[index] = command;
+                instance_alive[index] = true;
             } else {
-                current.write(camera);
+                index = instances.size();
+
+                instances.emplace_back(command);
+                instance_alive.emplace_back(true);
+                instance_generation.emplace_back(0);
+                instance_dirty.emplace_back(0);
+            }
+
+            mark_transform(index);
+            scene_changed = true;
+
+            return { index, instance_generation[index] };
+        }
+
+        [[nodiscard]] static bool live_instance(const Handle<DrawCommand> handle) {
+            if (handle.index < instances.size() && instance_alive[handle.index] && instance_generation[handle.index] == handle.generation) {
+                return true;
+            }
+
+            logger::warning("Instance handle {} is stale, ignored", handle.index);
+
+            return false;
+        }
+
+        void update_instance(const Handle<DrawCommand> handle, const glm::mat4& transform) {
+            if (!live_instance(handle)) {
+                return;
+            }
+
+            instances[handle.index].transform = transform;
+            mark_transform(handle.index);
+        }
+
+        void remove_instance(const Handle<DrawCommand> handle) {
+            if (!live_instance(handle)) {
+                return;
+            }
+
+            instance_alive[handle.index] = false;
+            ++instance_generation[handle.index];
+            free_instances.emplace_back(handle.index);
+            scene_changed = true;
+        }
+
+        // 10 bits per axis of a point normalised to [0, 1]
+        [[nodiscard]] static u32 morton_code(const glm::vec3& point) {
+            const auto spread = [](u32 value) {
+                value = (value | value << 16u) & 0x030000ffu;
+                value = (value | value << 8u) & 0x0300f00fu;
+                value = (value | value << 4u) & 0x030c30c3u;
+                value = (value | value << 2u) & 0x09249249u;
+
+                return value;
+            };
+
+            const auto scaled = glm::clamp(point, glm::vec3(0.0f), glm::vec3(1.0f)) * 1023.0f;
+
+            return spread(static_cast<u32>(scaled.x)) << 2u | spread(static_cast<u32>(scaled.y)) << 1u | spread(static_cast<u32>(scaled.z));
+        }
+
+        [[nodiscard]] static bool same_material(const Model::SubMesh& first, const Model::SubMesh& second) {
+            return
+                first.albedo.index == second.albedo.index &&
+                first.metallic.index == second.metallic.index &&
+                first.normal.index == second.normal.index &&
+                first.roughness.index == second.roughness.index &&
+                first.occlusion.index == second.occlusion.index;
+        }
+
+        Handle<DrawCommand> bake_static_batch(const std::vector<DrawCommand>& commands) {
+            // One submesh of one command, placed at vertex_offset and index_offset inside its chunk
+            struct Piece {
+                const DrawCommand* command{};
+                const Model::SubMesh* submesh{};
+                usize source{};
+                glm::vec3 center{};
+                u32 morton{};
+                usize chunk{};
+                usize vertex_offset{};
+                usize index_offset{};
+            };
+
+            struct Chunk {
+                usize first{};
+                VertexData data{};
+            };
+
+            if (commands.empty()) {
+                throw std::runtime_error("Static batch has no draws");
+            }
+
+            std::vector<Piece> pieces{};
+            std::vector<api::GeometryRead> reads{};
+            std::unordered_map<usize, usize> source_index{};
+            usize degenerate = 0;
+            glm::vec3 min{ std::numeric_limits<f32>::max() };
+            glm::vec3 max{ std::numeric_limits<f32>::lowest() };
+
+            for (const auto& command : commands) {
+                if (command.shader.handle != commands[0].shader.handle) {
+                    throw std::runtime_error("Static batch draws must share a pipeline");
+                }
+
+                if (command.model.index >= models.size() || model_generation[command.model.index] != command.model.generation) {
+                    throw std::runtime_error("Static batch draw refers to a removed model");
+                }
+
+                // Normals need the inverse of the transform, draws scaled flat on some axis have none
+                if (!std::isnormal(glm::determinant(glm::mat3(command.transform)))) {
+                    ++degenerate;
+                    continue;
+                }
+
+                for (const auto& submesh : models[command.model.index].submeshes) {
+                    const auto& mesh = submesh.mesh;
+
+                    // Placeholders of models still loading have no geometry of their own, their offsets belong to other meshes
+                    if (mesh.index_count == 0) {
+                        throw std::runtime_error("Static batch draw refers to a model that has not finished loading");
+                    }
+
+                    // Every mesh is read back from the arena once, only its full detail level is kept
+                    auto [it, inserted] = source_index.try_emplace(mesh.vertex_offset, reads.size());
+
+                    if (inserted) {
+                        api::GeometryRead read{}; {
+                            read.range.vertex_offset = mesh.vertex_offset;
+                            read.range.index_offset = mesh.index_offset;
+                            read.range.short_indices = mesh.short_indices;
+                            read.vertex_count = mesh.vertex_count;
+                            read.index_count = mesh.lods[0].index_count;
+                            read.min = mesh.min;
+                            read.extent = position_extent(mesh);
+                        }
+
+                        reads.emplace_back(read);
+                    }
+
+                    const auto center = glm::vec3(command.transform * glm::vec4(glm::vec3(mesh.sphere), 1.0f));
+                    min = glm::min(min, center);
+                    max = glm::max(max, center);
+
+                    pieces.emplace_back(Piece{ &command, &submesh, it->second, center });
+                }
+            }
+
+            if (degenerate > 0) {
+                logger::warning("{} static batch draws have a degenerate transform, left out", degenerate);
+            }
+
+            if (pieces.empty()) {
+                throw std::runtime_error("Static batch has no draws");
+            }
+
+            const auto sources = api::read_geometry(geometry_arena, reads);
+
+            // Materials stay apart, within a material pieces follow the Morton curve so each chunk is spatially compact
+            for (auto& piece : pieces) {
+                piece.morton = morton_code((piece.center - min) / glm::max(max - min, glm::vec3(1e-6f)));
+            }
+
+            std::stable_sort(pieces.begin(), pieces.end(), [](const Piece& lhs, const Piece& rhs) {
+                const auto& a = *lhs.submesh;
+                const auto& b = *rhs.submesh;
+
+                return
+                    std::tie(a.albedo.index, a.metallic.index, a.normal.index, a.roughness.index, a.occlusion.index, lhs.morton) <
+                    std::tie(b.albedo.index, b.metallic.index, b.normal.index, b.roughness.index, b.occlusion.index, rhs.morton);
+            });
+
+            std::vector<Chunk> chunks{};
+
+            for (usize i = 0; i < pieces.size(); ++i) {
+                auto& piece = pieces[i];
+                const auto& source = sources[piece.source];
+                const auto vertex_count = source.geometry.size();
+
+                const auto fits = !chunks.empty() &&
+                    same_material(*pieces[chunks.back().first].submesh, *piece.submesh) &&
+                    chunks.back().data.geometry.size() + vertex_count <= static_chunk_vertices;
+
+                if (!fits) {
+                    chunks.emplace_back(Chunk{ i });
+                }
+
+                auto& chunk = chunks.back();
+                piece.chunk = chunks.size() - 1;
+                piece.vertex_offset = chunk.data.geometry.size();
+                piece.index_offset = chunk.data.indices.size();
+
+                chunk.data.geometry.resize(chunk.data.geometry.size() + vertex_count);
+                chunk.data.indices.resize(chunk.data.indices.size() + source.indices.size());
+            }
+
+            // Pieces write disjoint ranges of their chunk
+            jobs::Counter counter{};
+
+            jobs::parallel_for(pieces.size(), 16, [&pieces, &sources, &chunks](const usize first, const usize last) {
+                for (usize i = first; i < last; ++i) {
+                    const auto& piece = pieces[i];
+                    const auto& source = sources[piece.source];
+                    auto& data = chunks[piece.chunk].data;
+
+                    const auto& transform = piece.command->transform;
+                    const auto basis = glm::mat3(transform);
+                    const auto normal_matrix = glm::transpose(glm::inverse(basis));
+
+                    for (usize j = 0; j < source.geometry.size(); ++j) {
+                        const auto& vertex = source.geometry[j];
+
+                        data.geometry[piece.vertex_offset + j] = Vertex{
+                            glm::vec3(transform * glm::vec4(vertex.pos, 1.0f)),
+                            glm::normalize(normal_matrix * vertex.norms),
+                            vertex.uvs,
+                            glm::normalize(basis * vertex.tangent),
+                            glm::normalize(basis * vertex.bitangent)
+                        };
+                    }
+
+                    for (usize j = 0; j < source.indices.size(); ++j) {
+                        data.indices[piece.index_offset + j] = static_cast<u32>(piece.vertex_offset + source.indices[j]);
+                    }
+                }
+            }, counter);
+
+            jobs::wait(counter);
+
+            Model batch{};
+            batch.submeshes.reserve(chunks.size());
+
+            for (const auto& chunk : chunks) {
+                auto submesh = *pieces[chunk.first].submesh;
+                submesh.mesh = write_geometry(chunk.data);
+                batch.submeshes.emplace_back(submesh);
+            }
+
+            logger::info("Baked {} draws into a static batch of {} chunks", pieces.size(), chunks.size());
+
+            return add_instance(DrawCommand{
+                .model = add_model(batch),
+                .transform = glm::mat4(1.0f),
+                .shader = commands[0].shader
+            });
+        }
+
+        template <typename Ty>
+        [[nodiscard]] static Handle<Ty> add_light(std::vector<Ty>& lights, LightSlots& slots, const Ty& light) {
+            usize slot{};
+
+            if (!slots.free.empty()) {
+                slot = slots.free.back();
+                slots.free.pop_back();
+            } else {
+                slot = slots.dense.size();
+
+                slots.dense.emplace_back(0);
+                slots.generation.emplace_back(0);
+            }
+
+            slots.dense[slot] = lights.size();
+            slots.slot.emplace_back(slot);
+            lights.emplace_back(light);
+
+            return { slot, slots.generation[slot] };
+        }
+
+        // The light a handle refers to, nullptr for stale handles
+        template <typename Ty>
+        [[nodiscard]] static Ty* find_light(std::vector<Ty>& lights, const LightSlots& slots, const Handle<Ty> handle) {
+            if (handle.index >= slots.dense.size() || slots.generation[handle.index] != handle.generation) {
+                logger::warning("Light handle {} is stale, ignored", handle.index);
+                return nullptr;
+            }
+
+            return &lights[slots.dense[handle.index]];
+        }
+
+        template <typename Ty>
+        [[nodiscard]] static bool remove_light(std::vector<Ty>& lights, LightSlots& slots, const Handle<Ty> handle) {
+            if (!find_light(lights, slots, handle)) {
+                return false;
+            }
+
+            const auto index = slots.dense[handle.index];
+            const auto last = slots.slot.back();
+
+            lights[index] = lights.back();
+            lights.pop_back();
+            slots.slot[index] = last;
+            slots.slot.pop_back();
+            slots.dense[last] = index;
+
+            ++slots.generation[handle.index];
+            slots.free.emplace_back(handle.index);
+
+            return true;
+        }
+
+        Handle<PointLight> add_point_light(const PointLight& light) {
+            stale_point_lights = all_frames;
+
+            return add_light(point_lights, point_light_slots, light);
+        }
+
+        void update_point_light(const Handle<PointLight> handle, const PointLight& light) {
+            if (auto* current = find_light(point_lights, point_light_slots, handle)) {
+                *current = light;
+                stale_point_lights = all_frames;
+            }
+        }
+
+        void remove_point_light(const Handle<PointLight> handle) {
+            if (remove_light(point_lights, point_light_slots, handle)) {
+                stale_point_lights = all_frames;
+            }
+        }
+
+        Handle<DirectionalLight> add_directional_light(const DirectionalLight& light) {
+            stale_directional_lights = all_frames;
+
+            return add_light(directional_lights, directional_light_slots, light);
+        }
+
+        void update_directional_light(const Handle<DirectionalLight> handle, const DirectionalLight& light) {
+            if (auto* current = find_light(directional_lights, directional_light_slots, handle)) {
+                *current = light;
+                stale_directional_lights = all_frames;
+            }
+        }
+
+        void remove_directional_light(const Handle<DirectionalLight> handle) {
+            if (remove_light(directional_lights, directional_light_slots, handle)) {
+                stale_directional_lights = all_frames;
+            }
+        }
+
+        // Only the transforms changed since this frame's buffer was last written are uploaded
+        static void update_transforms() {
+            auto& current = transform_buffer[current_frame];
+            auto& dirty = dirty_transforms[current_frame];
+
+            if (current.size() < instances.size()) {
+                current.resize(instances.size());
+
+                api::SingleUpdateBufferInfo info{}; {
+                    info.buffer = current.info();
+                    info.type = vk::DescriptorType::eStorageBuffer;
+                    info.binding = binding::transform;
+                }
+
+                minimal_set[current_frame].update(info);
+            }
+
+            for (const auto index : dirty) {
+                current.write(index, instances[index].transform);
+                instance_dirty[index] &= ~(1u << current_frame);
+            }
+
+            dirty.clear();
+        }
+
+        static void update_camera(const Camera& camera) {
+            auto& current = camera_buffer[current_frame];
+
+            if (current.size() == 1) {
+                current.write(camera);
+            } else {
+                current.write(camera);
 
                 api::SingleUpdateBufferInfo info{}; {
                     info.buffer = current.info();
@@ -290,120 +1746,1443 @@ namespace tethys {
                     info.binding = binding::camera;
                 }
 
-                minimal_set[current_frame].update(info);
+                minimal_set[current_frame].update(info);
+            }
+        }
+
+        static void update_point_lights() {
+            auto& current = point_light_buffer[current_frame];
+
+            if (point_lights.empty() || !(stale_point_lights & 1u << current_frame)) {
+                return;
+            }
+
+            stale_point_lights &= ~(1u << current_frame);
+
+            if (current.size() == point_lights.size()) {
+                current.write(point_lights);
+            } else {
+                current.write(point_lights);
+
+                api::SingleUpdateBufferInfo info{}; {
+                    info.buffer = current.info();
+                    info.type = vk::DescriptorType::eStorageBuffer;
+                    info.binding = binding::point_light;
+                }
+
+                generic_set[current_frame].update(info);
+            }
+        }
+
+        static void update_directional_lights() {
+            auto& current = directional_light_buffer[current_frame];
+
+            if (directional_lights.empty() || !(stale_directional_lights & 1u << current_frame)) {
+                return;
+            }
+
+            stale_directional_lights &= ~(1u << current_frame);
+
+            if (current.size() == directional_lights.size()) {
+                current.write(directional_lights);
+            } else {
+                current.write(directional_lights);
+
+                api::SingleUpdateBufferInfo info{}; {
+                    info.buffer = current.info();
+                    info.type = vk::DescriptorType::eStorageBuffer;
+                    info.binding = binding::directional_light;
+                }
+
+                generic_set[current_frame].update(info);
+            }
+        }
+
+        [[nodiscard]] static u64 pipeline_id(const Pipeline& pipeline) {
+            if (pipeline.handle == minimal.handle) {
+                return 0;
+            }
+
+            if (pipeline.handle == generic.handle) {
+                return 1;
+            }
+
+            if (pipeline.handle == pbr.handle) {
+                return 2;
+            }
+
+            return 0xf;
+        }
+
+        // Pipelines sharing a group have compatible layouts, their descriptor sets and push constants stay bound.
+        // Pipelines the renderer did not create get a group of their own, the draw pass binds no sets for them
+        [[nodiscard]] static u32 set_group(const Pipeline& pipeline) {
+            if (pipeline.handle == minimal.handle) {
+                return 0;
+            }
+
+            if (pipeline.handle == generic.handle || pipeline.handle == pbr.handle) {
+                return 1;
+            }
+
+            return 2;
+        }
+
+        [[nodiscard]] static u64 material_id(const Model::SubMesh& submesh) {
+            u64 hash = 14695981039346656037ull;
+
+            for (const auto index : { submesh.albedo.index, submesh.metallic.index, submesh.normal.index, submesh.roughness.index, submesh.occlusion.index }) {
+                hash = (hash ^ index) * 1099511628211ull;
+            }
+
+            return (hash ^ (hash >> 24u) ^ (hash >> 48u)) & 0xffffffu;
+        }
+
+        // Keeps draws of the same mesh next to each other so they can be instanced, collisions only split groups
+        [[nodiscard]] static u64 mesh_id(const Mesh& mesh) {
+            const auto hash = (static_cast<u64>(mesh.index_offset) * 0x9e3779b97f4a7c15ull) ^ static_cast<u64>(mesh.vertex_offset);
+
+            return (hash ^ (hash >> 32u)) & 0xffffffffu;
+        }
+
+        [[nodiscard]] static u32 depth_key(const f32 depth) {
+            // Non-negative floats compare the same as their bit patterns, so nearer draws get smaller keys
+            u32 depth_bits{};
+            std::memcpy(&depth_bits, &depth, sizeof(u32));
+
+            return depth_bits;
+        }
+
+        [[nodiscard]] static f32 instance_depth(const DrawCommand& draw, const Camera& camera) {
+            return glm::length(glm::vec3(draw.transform[3]) - glm::vec3(camera.pos));
+        }
+
+        [[nodiscard]] static u64 make_sort_key(const Pipeline& pipeline, const Model::SubMesh& submesh) {
+            return
+                pipeline_id(pipeline) << sort_key::pipeline_shift |
+                static_cast<u64>(set_group(pipeline)) << sort_key::sets_shift |
+                static_cast<u64>(submesh.mesh.short_indices) << sort_key::index_type_shift |
+                mesh_id(submesh.mesh) << sort_key::mesh_shift |
+                material_id(submesh) << sort_key::material_shift;
+        }
+
+        [[nodiscard]] static bool sort_before(const SortItem& first, const SortItem& second) {
+            return first.key < second.key || (first.key == second.key && first.depth < second.depth);
+        }
+
+        // Whether two consecutive sorted draws can share an instanced command. Draws split in meshlets are not
+        // instanced, the meshlet pass writes their command's index range
+        [[nodiscard]] static bool same_group(const DrawCommand& first, const Mesh& first_mesh, const DrawCommand& second, const Mesh& second_mesh) {
+            if (!instancing || (meshlet_culling && first_mesh.meshlet_count > 0)) {
+                return false;
+            }
+
+            return
+                first.shader.handle == second.shader.handle &&
+                first_mesh.index_offset == second_mesh.index_offset &&
+                first_mesh.vertex_offset == second_mesh.vertex_offset &&
+                first_mesh.short_indices == second_mesh.short_indices;
+        }
+
+        // LSD radix sort on depth then key, 8 bits per pass, passes where every item shares the same digit are skipped
+        static void radix_sort(std::vector<SortItem>& items) {
+            static std::vector<SortItem> scratch{};
+
+            if (items.size() < 2) {
+                return;
+            }
+
+            scratch.resize(items.size());
+
+            constexpr u32 depth_passes = sizeof(SortItem::depth);
+            constexpr u32 passes = depth_passes + sizeof(SortItem::key);
+
+            for (u32 pass = 0; pass < passes; ++pass) {
+                const auto digit = [pass](const SortItem& item) -> usize {
+                    if (pass < depth_passes) {
+                        return (item.depth >> (pass * 8u)) & 0xffu;
+                    }
+
+                    return (item.key >> ((pass - depth_passes) * 8u)) & 0xffu;
+                };
+
+                std::array<usize, 256> histogram{};
+
+                for (const auto& item : items) {
+                    ++histogram[digit(item)];
+                }
+
+                if (histogram[digit(items[0])] == items.size()) {
+                    continue;
+                }
+
+                usize offset = 0;
+                for (auto& count : histogram) {
+                    const auto current = count;
+                    count = offset;
+                    offset += current;
+                }
+
+                for (const auto& item : items) {
+                    scratch[histogram[digit(item)]++] = item;
+                }
+
+                items.swap(scratch);
+            }
+        }
+
+        // Keys of every live submesh, sorted
+        static void collect_sort_items(const Camera& camera) {
+            sort_items.clear();
+
+            for (usize i = 0; i < instances.size(); ++i) {
+                if (!instance_alive[i]) {
+                    continue;
+                }
+
+                auto& draw = instances[i];
+
+                // The model was removed, its slot may hold another one by now
+                if (model_generation[draw.model.index] != draw.model.generation) {
+                    continue;
+                }
+
+                auto& model = models[draw.model.index];
+                const auto depth = instance_depth(draw, camera);
+
+                for (usize j = 0; j < model.submeshes.size(); ++j) {
+                    // Placeholders of models still loading have nothing to draw
+                    if (model.submeshes[j].mesh.index_count == 0) {
+                        continue;
+                    }
+
+                    sort_items.emplace_back(SortItem{
+                        make_sort_key(draw.shader, model.submeshes[j]),
+                        depth_key(depth),
+                        static_cast<u32>(i),
+                        static_cast<u32>(j)
+                    });
+                }
+            }
+
+            radix_sort(sort_items);
+        }
+
+        // Replaces the depth of every item with this frame's distance, returns whether the draw order changed
+        [[nodiscard]] static bool rekey_depth(const Camera& camera) {
+            for (auto& item : sort_items) {
+                item.depth = depth_key(instance_depth(instances[item.command], camera));
+            }
+
+            const auto in_order = std::is_sorted(sort_items.begin(), sort_items.end(), sort_before);
+
+            if (in_order) {
+                return false;
+            }
+
+            radix_sort(sort_items);
+
+            return true;
+        }
+
+        // Rebuilds the draw, command and culling lists from sort_items
+        static void build_draws() {
+            static std::vector<InstanceGroup> groups{};
+
+            groups.clear();
+            draw_list.clear();
+            command_list.clear();
+            cull_list.clear();
+            draw_batches.clear();
+            instance_slots = 0;
+
+            draw_list.reserve(sort_items.size());
+            cull_list.reserve(sort_items.size());
+
+            const auto submesh_of = [](const SortItem& item) -> const Model::SubMesh& {
+                return models[instances[item.command].model.index].submeshes[item.submesh];
+            };
+
+            for (usize i = 0; i < sort_items.size(); ++i) {
+                auto& item = sort_items[i];
+                const auto& submesh = submesh_of(item);
+                item.draw = static_cast<u32>(i);
+
+                const auto min = packed_vertices ? submesh.mesh.min : glm::vec3(0.0f);
+                const auto extent = packed_vertices ? position_extent(submesh.mesh) : glm::vec3(1.0f);
+
+                draw_list.emplace_back(DrawData{
+                    item.command,
+                    submesh.albedo.index,
+                    submesh.metallic.index,
+                    submesh.normal.index,
+                    submesh.roughness.index,
+                    submesh.occlusion.index,
+                    { min.x, min.y, min.z },
+                    { extent.x, extent.y, extent.z }
+                });
+
+                if (i > 0) {
+                    const auto& previous = sort_items[i - 1];
+
+                    if (same_group(instances[previous.command], submesh_of(previous).mesh, instances[item.command], submesh.mesh)) {
+                        ++groups.back().count;
+                        continue;
+                    }
+                }
+
+                groups.emplace_back(InstanceGroup{ static_cast<u32>(i), 1 });
+            }
+
+            // Visibility buffer IDs, 0 is left for pixels nothing was drawn to
+            u64 triangle_ids = 1;
+
+            // One command per level of detail of every group, each with group.count instance slots
+            for (const auto& group : groups) {
+                const auto& draw = instances[sort_items[group.first].command];
+                const auto& mesh = submesh_of(sort_items[group.first]).mesh;
+                const auto first_command = static_cast<u32>(command_list.size());
+                // Every group gets at least one command, its cull entries point at it
+                const auto lod_count = lod_enabled ? std::max(mesh.lod_count, 1u) : 1u;
+
+                CullData cull{}; {
+                    cull.sphere = mesh.sphere;
+                    cull.command = first_command;
+                    cull.instance_slot = instance_slots;
+                    cull.lod_count = lod_count;
+                    cull.short_indices = mesh.short_indices;
+                    cull.meshlet_first = mesh.meshlet_offset;
+                    cull.meshlet_count = mesh.meshlet_count;
+                    cull.group_size = group.count;
+                    cull.vertex_offset = static_cast<i32>(mesh.vertex_offset);
+                    cull.lit = draw.shader.handle != minimal.handle;
+
+                    for (usize j = 0; j < cull.lod_count; ++j) {
+                        const auto& lod = mesh.lods[j];
+                        cull.lods[j] = { static_cast<u32>(mesh.index_offset + lod.index_offset), lod.index_count, lod.error };
+                    }
+                }
+
+                // Every level of detail gets its own IDs, they sit back to back after the full detail one
+                u32 triangles = 0;
+
+                if (visibility_shading) {
+                    const auto& coarsest = cull.lods[lod_count - 1];
+                    triangles = (coarsest.first_index + coarsest.index_count - cull.lods[0].first_index) / 3;
+                }
+
+                for (u32 j = 0; j < lod_count; ++j) {
+                    VkDrawIndexedIndirectCommand command{}; {
+                        command.indexCount = cull.lods[j].index_count;
+                        command.instanceCount = 0;
+                        command.firstIndex = cull.lods[j].first_index;
+                        command.vertexOffset = mesh.vertex_offset;
+                        command.firstInstance = instance_slots + j * group.count;
+                    }
+                    command_list.emplace_back(command);
+                }
+
+                instance_slots += lod_count * group.count;
+
+                if (!draw_batches.empty() &&
+                    draw_batches.back().pipeline.handle == draw.shader.handle &&
+                    draw_batches.back().short_indices == mesh.short_indices &&
+                    draw_batches.back().count < max_batch_commands) {
+                    draw_batches.back().count += lod_count;
+                } else {
+                    draw_batches.emplace_back(DrawBatch{ draw.shader, set_group(draw.shader), mesh.short_indices, first_command, lod_count });
+                }
+
+                for (u32 j = 0; j < group.count; ++j) {
+                    cull.triangle_base = static_cast<u32>(triangle_ids);
+                    triangle_ids += triangles;
+                    cull_list.emplace_back(cull);
+                }
+            }
+
+            // IDs past the limit would wrap and shade pixels with another triangle's data
+            if (visibility_shading && triangle_ids > std::numeric_limits<u32>::max()) {
+                throw std::runtime_error("Scene has more triangles than the visibility buffer can tell apart");
+            }
+
+            // Second phase commands point at their own section of the instance buffer
+            command_count = command_list.size();
+
+            for (u32 i = 0; i < command_count; ++i) {
+                auto command = command_list[i];
+                command.firstInstance += instance_slots;
+                command_list.emplace_back(command);
+            }
+
+            if (compaction) {
+                command_batch_list.clear();
+
+                for (u32 i = 0; i < draw_batches.size(); ++i) {
+                    command_batch_list.insert(command_batch_list.end(), draw_batches[i].count, CommandBatch{ i, draw_batches[i].first });
+                }
+            }
+
+            if (cpu_culling) {
+                instance_draw_offsets.assign(instances.size() + 1, 0);
+                instance_draws.resize(draw_list.size());
+
+                for (const auto& draw : draw_list) {
+                    ++instance_draw_offsets[draw.transform + 1];
+                }
+
+                std::partial_sum(instance_draw_offsets.begin(), instance_draw_offsets.end(), instance_draw_offsets.begin());
+
+                auto next = instance_draw_offsets;
+
+                for (u32 i = 0; i < draw_list.size(); ++i) {
+                    instance_draws[next[draw_list[i].transform]++] = i;
+                }
+            }
+        }
+
+        // The current frame's fence has already been waited on
+        static void wait_other_frames() {
+            for (u32 frame = 0; frame < api::frames_in_flight; ++frame) {
+                if (frame != current_frame && in_flight[frame]) {
+                    context.device.logical.waitForFences(in_flight[frame], true, -1, context.dispatcher);
+                }
+            }
+        }
+
+        [[nodiscard]] static bool depth_sort_due(const Camera& camera) {
+            if (instancing && !meshlet_culling) {
+                return false;
+            }
+
+            if (++frames_since_depth_sort < depth_sort_interval || camera.pos == depth_sort_position) {
+                return false;
+            }
+
+            frames_since_depth_sort = 0;
+            depth_sort_position = camera.pos;
+
+            return true;
+        }
+
+        // Moves the level of detail and occlusion visibility of every draw to its index in the new order, so a re-sort
+        // keeps LOD hysteresis and last frame's visibility. The other frames must be done with the visibility buffer
+        static void remap_draw_state() {
+            static std::vector<u32> scratch{};
+
+            scratch.resize(sort_items.size());
+
+            for (usize i = 0; i < sort_items.size(); ++i) {
+                scratch[i] = draw_lods[sort_items[i].draw];
+            }
+
+            draw_lods.swap(scratch);
+
+            if (cpu_culling) {
+                return;
+            }
+
+            wait_other_frames();
+
+            auto* visibility = static_cast<u32*>(visibility_buffer.buf());
+
+            for (usize i = 0; i < sort_items.size(); ++i) {
+                scratch[i] = visibility[sort_items[i].draw];
+            }
+
+            std::memcpy(visibility, scratch.data(), sort_items.size() * sizeof(u32));
+        }
+
+        static void update_draws(const Camera& camera) {
+            // The same draws in a new order, their state follows them
+            if (!scene_changed && depth_sort_due(camera) && rekey_depth(camera)) {
+                remap_draw_state();
+                build_draws();
+                spheres_stale = true;
+                stale_draws = all_frames;
+            }
+
+            if (scene_changed) {
+                collect_sort_items(camera);
+                build_draws();
+                scene_changed = false;
+                spheres_stale = true;
+                stale_draws = all_frames;
+                draw_lods.assign(draw_list.size(), 0);
+
+                // Draw indices changed meaning, everything is drawn in the first phase until culled again
+                // Shared by every frame, the others must be done with it before it is replaced. It grows by at least
+                // double so this stays rare
+                if (visibility_buffer.size() < draw_list.size()) {
+                    wait_other_frames();
+                    visibility_buffer.resize(draw_list.size());
+
+                    api::UpdateBufferInfo info{}; {
+                        info.buffers.fill(visibility_buffer.info());
+                        info.type = vk::DescriptorType::eStorageBuffer;
+                        info.binding = binding::visibility;
+                    }
+
+                    cull_set.update(info);
+                }
+
+                reset_visibility = true;
+            }
+
+            if (!(stale_draws & 1u << current_frame)) {
+                return;
+            }
+
+            stale_draws &= ~(1u << current_frame);
+
+            if (draw_list.empty()) {
+                return;
+            }
+
+            cull_buffer[current_frame].write(cull_list);
+            visible_buffer[current_frame].resize(command_list.size());
+            meshlet_work_buffer[current_frame].resize(2 * draw_list.size());
+
+            // Any of the culling buffers may have been reallocated above
+            std::vector<api::SingleUpdateBufferInfo> cull_update(3); {
+                cull_update[0].buffer = cull_buffer[current_frame].info();
+                cull_update[0].type = vk::DescriptorType::eStorageBuffer;
+                cull_update[0].binding = binding::cull_data;
+
+                cull_update[1].buffer = visible_buffer[current_frame].info();
+                cull_update[1].type = vk::DescriptorType::eStorageBuffer;
+                cull_update[1].binding = binding::visible_commands;
+
+                cull_update[2].buffer = meshlet_work_buffer[current_frame].info();
+                cull_update[2].type = vk::DescriptorType::eStorageBuffer;
+                cull_update[2].binding = binding::meshlet_work;
+            }
+            cull_set[current_frame].update(cull_update);
+
+            if (compaction) {
+                command_batch_buffer[current_frame].write(command_batch_list);
+                compacted_buffer[current_frame].resize(command_list.size());
+                draw_count_buffer[current_frame].resize(2 * draw_batches.size());
+
+                std::vector<api::SingleUpdateBufferInfo> compact_update(3); {
+                    compact_update[0].buffer = command_batch_buffer[current_frame].info();
+                    compact_update[0].type = vk::DescriptorType::eStorageBuffer;
+                    compact_update[0].binding = binding::command_batches;
+
+                    compact_update[1].buffer = compacted_buffer[current_frame].info();
+                    compact_update[1].type = vk::DescriptorType::eStorageBuffer;
+                    compact_update[1].binding = binding::compacted_commands;
+
+                    compact_update[2].buffer = draw_count_buffer[current_frame].info();
+                    compact_update[2].type = vk::DescriptorType::eStorageBuffer;
+                    compact_update[2].binding = binding::draw_counts;
+                }
+                cull_set[current_frame].update(compact_update);
+            }
+
+            if (visibility_shading) {
+                api::SingleUpdateBufferInfo visibility_update{}; {
+                    visibility_update.buffer = cull_buffer[current_frame].info();
+                    visibility_update.type = vk::DescriptorType::eStorageBuffer;
+                    visibility_update.binding = binding::visibility_draws;
+                }
+                visibility_set[current_frame].update(visibility_update);
+            }
+
+            draw_buffer[current_frame].write(draw_list);
+            instance_buffer[current_frame].resize(2 * instance_slots);
+
+            std::vector<api::SingleUpdateBufferInfo> minimal_update(2); {
+                minimal_update[0].buffer = draw_buffer[current_frame].info();
+                minimal_update[0].type = vk::DescriptorType::eStorageBuffer;
+                minimal_update[0].binding = binding::draw;
+
+                minimal_update[1].buffer = instance_buffer[current_frame].info();
+                minimal_update[1].type = vk::DescriptorType::eStorageBuffer;
+                minimal_update[1].binding = binding::instances;
+            }
+            minimal_set[current_frame].update(minimal_update);
+        }
+
+        // The meshlet pass and the visibility buffer resolve read the arena directly, growing it replaces the buffers
+        static void update_geometry_bindings() {
+            if (bound_indices[current_frame] == geometry_arena.indices.handle &&
+                bound_meshlets[current_frame] == geometry_arena.meshlets.handle &&
+                bound_vertices[current_frame] == geometry_arena.vertices.handle) {
+                return;
+            }
+
+            std::vector<api::SingleUpdateBufferInfo> geometry_update(2); {
+                geometry_update[0].buffer = vk::DescriptorBufferInfo{ geometry_arena.meshlets.handle, 0, VK_WHOLE_SIZE };
+                geometry_update[0].type = vk::DescriptorType::eStorageBuffer;
+                geometry_update[0].binding = binding::meshlets;
+
+                geometry_update[1].buffer = vk::DescriptorBufferInfo{ geometry_arena.indices.handle, 0, VK_WHOLE_SIZE };
+                geometry_update[1].type = vk::DescriptorType::eStorageBuffer;
+                geometry_update[1].binding = binding::geometry_indices;
+            }
+            cull_set[current_frame].update(geometry_update);
+
+            if (visibility_shading) {
+                std::vector<api::SingleUpdateBufferInfo> visibility_update(2); {
+                    visibility_update[0].buffer = vk::DescriptorBufferInfo{ geometry_arena.vertices.handle, 0, VK_WHOLE_SIZE };
+                    visibility_update[0].type = vk::DescriptorType::eStorageBuffer;
+                    visibility_update[0].binding = binding::visibility_vertices;
+
+                    visibility_update[1].buffer = vk::DescriptorBufferInfo{ geometry_arena.indices.handle, 0, VK_WHOLE_SIZE };
+                    visibility_update[1].type = vk::DescriptorType::eStorageBuffer;
+                    visibility_update[1].binding = binding::visibility_indices;
+                }
+                visibility_set[current_frame].update(visibility_update);
+            }
+
+            bound_indices[current_frame] = geometry_arena.indices.handle;
+            bound_meshlets[current_frame] = geometry_arena.meshlets.handle;
+            bound_vertices[current_frame] = geometry_arena.vertices.handle;
+        }
+
+        // Pixels per object space unit at distance 1, divided by the threshold so a usable level ends up below 1
+        [[nodiscard]] static f32 lod_scale(const Camera& camera) {
+            return std::abs(camera.projection[1][1]) * 0.5f * context.swapchain.extent.height / lod_threshold;
+        }
+
+        // Coarsest level whose error projects under the threshold, mirrors select_lod in cull.comp
+        [[nodiscard]] static u32 select_lod(const CullData& cull, const f32 distance, const f32 scale, const f32 pixels, const u32 previous) {
+            u32 lod = 0;
+
+            for (u32 i = 1; i < cull.lod_count; ++i) {
+                const auto limit = i > previous ? 1.0f - lod_hysteresis : 1.0f;
+
+                if (cull.lods[i].error * scale * pixels <= limit * distance) {
+                    lod = i;
+                }
+            }
+
+            return lod;
+        }
+
+        [[nodiscard]] static CullConstants cull_constants(const Camera& camera, const u32 phase) {
+            CullConstants constants{}; {
+                constants.planes = culling::frustum_planes(camera.projection * camera.view);
+                constants.draw_count = draw_list.size();
+                constants.command_count = command_count;
+                constants.slot_count = instance_slots;
+                constants.phase = phase;
+                constants.occlusion = occlusion_culling;
+                constants.lod_scale = lod_scale(camera);
+                constants.lod_hysteresis = lod_hysteresis;
+                constants.batch_count = draw_batches.size();
+            }
+
+            return constants;
+        }
+
+        // Tests every submesh sphere against the frustum, and in phase 1 against the depth pyramid.
+        // Survivors of each phase are counted into the commands of their own section of visible_buffer
+        static void cull_pass(const vk::CommandBuffer command_buffer, const Camera& camera, const u32 phase) {
+            if (command_list.empty()) {
+                return;
+            }
+
+            if (phase == 0) {
+                // Commands of both phases start out empty, the frame's previous use of the buffer has completed
+                visible_buffer[current_frame].write(command_list);
+                command_buffer.fillBuffer(cull_stats_buffer[current_frame].handle(), 0, VK_WHOLE_SIZE, 0, context.dispatcher);
+
+                if (compaction) {
+                    command_buffer.fillBuffer(draw_count_buffer[current_frame].handle(), 0, VK_WHOLE_SIZE, 0, context.dispatcher);
+                }
+
+                if (reset_visibility) {
+                    command_buffer.fillBuffer(visibility_buffer.handle(), 0, VK_WHOLE_SIZE, 1, context.dispatcher);
+                    reset_visibility = false;
+                }
+
+                vk::MemoryBarrier clear_barrier{}; {
+                    clear_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+                    clear_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+                }
+
+                command_buffer.pipelineBarrier(
+                    vk::PipelineStageFlagBits::eTransfer,
+                    vk::PipelineStageFlagBits::eComputeShader,
+                    vk::DependencyFlagBits{},
+                    clear_barrier,
+                    nullptr,
+                    nullptr,
+                    context.dispatcher);
+            }
+
+            // This frame's scratch slots are free again, its previous use has completed
+            if (phase == 0 && meshlet_culling) {
+                MeshletDispatch dispatch{}; {
+                    dispatch.scratch_base = current_frame * meshlet_scratch;
+                    dispatch.scratch_size = meshlet_scratch;
+
+                    for (auto& groups : dispatch.groups) {
+                        groups[1] = 1;
+                        groups[2] = 1;
+                    }
+                }
+                meshlet_dispatch_buffer[current_frame].write(dispatch);
+            }
+
+            const auto constants = cull_constants(camera, phase);
+
+            std::array sets{
+                minimal_set[current_frame].handle(),
+                cull_set[current_frame].handle()
+            };
+
+            command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, cull.handle, context.dispatcher);
+            command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, cull.layout, 0, sets, nullptr, context.dispatcher);
+            command_buffer.pushConstants<CullConstants>(cull.layout, vk::ShaderStageFlagBits::eCompute, 0, constants, context.dispatcher);
+            command_buffer.dispatch((constants.draw_count + cull_group_size - 1) / cull_group_size, 1, 1, context.dispatcher);
+
+            vk::MemoryBarrier cull_barrier{}; {
+                cull_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+                cull_barrier.dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+            }
+
+            command_buffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eComputeShader,
+                vk::DependencyFlagBits{},
+                cull_barrier,
+                nullptr,
+                nullptr,
+                context.dispatcher);
+        }
+
+        // Culls the meshlets of the draws the culling pass routed here in this phase and compacts the surviving triangles
+        // into each draw's scratch slots, one workgroup per draw
+        static void meshlet_pass(const vk::CommandBuffer command_buffer, const Camera& camera, const u32 phase) {
+            if (command_list.empty()) {
+                return;
+            }
+
+            const auto constants = cull_constants(camera, phase);
+
+            std::array sets{
+                minimal_set[current_frame].handle(),
+                cull_set[current_frame].handle()
+            };
+
+            command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, meshlet_cull.handle, context.dispatcher);
+            command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, meshlet_cull.layout, 0, sets, nullptr, context.dispatcher);
+            command_buffer.pushConstants<CullConstants>(meshlet_cull.layout, vk::ShaderStageFlagBits::eCompute, 0, constants, context.dispatcher);
+            command_buffer.dispatchIndirect(meshlet_dispatch_buffer[current_frame].handle(), offsetof(MeshletDispatch, groups) + phase * sizeof(MeshletDispatch::groups[0]), context.dispatcher);
+
+            vk::MemoryBarrier meshlet_barrier{}; {
+                meshlet_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+                meshlet_barrier.dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eShaderRead;
+            }
+
+            // The compaction pass reads the finished commands
+            command_buffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eComputeShader,
+                vk::DependencyFlagBits{},
+                meshlet_barrier,
+                nullptr,
+                nullptr,
+                context.dispatcher);
+        }
+
+        // Moves the commands of this phase that drew anything to the front of their batch and counts them, after the
+        // culling and meshlet passes of the phase are done with the commands
+        static void compact_pass(const vk::CommandBuffer command_buffer, const Camera& camera, const u32 phase) {
+            if (command_list.empty()) {
+                return;
+            }
+
+            const auto constants = cull_constants(camera, phase);
+
+            std::array sets{
+                minimal_set[current_frame].handle(),
+                cull_set[current_frame].handle()
+            };
+
+            command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, compact.handle, context.dispatcher);
+            command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, compact.layout, 0, sets, nullptr, context.dispatcher);
+            command_buffer.pushConstants<CullConstants>(compact.layout, vk::ShaderStageFlagBits::eCompute, 0, constants, context.dispatcher);
+            command_buffer.dispatch((command_count + cull_group_size - 1) / cull_group_size, 1, 1, context.dispatcher);
+
+            vk::MemoryBarrier compact_barrier{}; {
+                compact_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+                compact_barrier.dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead;
+            }
+
+            command_buffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eDrawIndirect,
+                vk::DependencyFlagBits{},
+                compact_barrier,
+                nullptr,
+                nullptr,
+                context.dispatcher);
+        }
+
+        // Resolves the depth of the first phase into mip 0, then halves it down to 1x1 keeping the farthest depth
+        static void build_depth_pyramid(const vk::CommandBuffer command_buffer) {
+            const auto levels = static_cast<u32>(offscreen.depth_pyramid_levels.size());
+
+            vk::ImageMemoryBarrier layout_barrier{}; {
+                layout_barrier.image = offscreen.depth_pyramid.handle;
+                layout_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                layout_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                layout_barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+                layout_barrier.subresourceRange.layerCount = 1;
+                layout_barrier.subresourceRange.baseArrayLayer = 0;
+                layout_barrier.subresourceRange.levelCount = levels;
+                layout_barrier.subresourceRange.baseMipLevel = 0;
+                layout_barrier.oldLayout = vk::ImageLayout::eUndefined;
+                layout_barrier.newLayout = vk::ImageLayout::eGeneral;
+                layout_barrier.srcAccessMask = {};
+                layout_barrier.dstAccessMask = vk::AccessFlagBits::eShaderWrite;
+            }
+
+            command_buffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::DependencyFlagBits{},
+                nullptr,
+                nullptr,
+                layout_barrier,
+                context.dispatcher);
+
+            vk::MemoryBarrier level_barrier{}; {
+                level_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+                level_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+            }
+
+            const auto width = context.swapchain.extent.width;
+            const auto height = context.swapchain.extent.height;
+
+            for (u32 level = 0; level < levels; ++level) {
+                const auto& pipeline = level == 0 ? depth_resolve : depth_reduce;
+                const auto level_width = std::max(1u, width >> level);
+                const auto level_height = std::max(1u, height >> level);
+
+                if (level != 0) {
+                    command_buffer.pipelineBarrier(
+                        vk::PipelineStageFlagBits::eComputeShader,
+                        vk::PipelineStageFlagBits::eComputeShader,
+                        vk::DependencyFlagBits{},
+                        level_barrier,
+                        nullptr,
+                        nullptr,
+                        context.dispatcher);
+                }
+
+                command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline.handle, context.dispatcher);
+                command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline.layout, 0, depth_reduce_sets[level].handle(), nullptr, context.dispatcher);
+                command_buffer.dispatch((level_width + reduce_group_size - 1) / reduce_group_size, (level_height + reduce_group_size - 1) / reduce_group_size, 1, context.dispatcher);
+            }
+
+            command_buffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::DependencyFlagBits{},
+                level_barrier,
+                nullptr,
+                nullptr,
+                context.dispatcher);
+        }
+
+        static void write_world_sphere(const usize i) {
+            const auto& transform = instances[draw_list[i].transform].transform;
+            const auto& sphere = cull_list[i].sphere;
+            const auto scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])) });
+
+            culling::write(world_spheres, i, glm::vec4(glm::vec3(transform * glm::vec4(glm::vec3(sphere), 1.0f)), sphere.w * scale));
+        }
+
+        // Every sphere after draw_list was rebuilt, only those of moved instances otherwise
+        static void update_world_spheres() {
+            if (spheres_stale) {
+                culling::resize(world_spheres, draw_list.size());
+
+                for (usize i = 0; i < draw_list.size(); ++i) {
+                    write_world_sphere(i);
+                }
+
+                spheres_stale = false;
+            } else {
+                for (const auto index : dirty_spheres) {
+                    // Instances added since the last rebuild have no draws yet
+                    if (index + 1 >= instance_draw_offsets.size()) {
+                        continue;
+                    }
+
+                    for (auto i = instance_draw_offsets[index]; i < instance_draw_offsets[index + 1]; ++i) {
+                        write_world_sphere(instance_draws[i]);
+                    }
+                }
+            }
+
+            for (const auto index : dirty_spheres) {
+                instance_dirty[index] &= ~sphere_dirty;
+            }
+
+            dirty_spheres.clear();
+        }
+
+        // Same output layout as the first phase of the compute pass
+        static void cpu_cull_pass(const Camera& camera) {
+            if (command_list.empty()) {
+                return;
+            }
+
+            update_world_spheres();
+
+            visible_draws.clear();
+            culling::cull(world_spheres, culling::frustum_planes(camera.projection * camera.view), glm::vec3(camera.pos), draw_distance, visible_draws);
+
+            visible_list.assign(command_list.begin(), command_list.begin() + command_count);
+            instance_list.resize(instance_slots);
+            last_stats = {};
+
+            for (const auto& entry : cull_list) {
+                last_stats.frustum_triangles += entry.lods[0].index_count / 3;
+            }
+
+            const auto pixels = lod_scale(camera);
+
+            for (const auto index : visible_draws) {
+                const auto& entry = cull_list[index];
+                last_stats.frustum_triangles -= entry.lods[0].index_count / 3;
+
+                if (entry.lod_count > 1) {
+                    const auto center = glm::vec3(world_spheres.x[index], world_spheres.y[index], world_spheres.z[index]);
+                    const auto radius = world_spheres.radius[index];
+                    const auto scale = entry.sphere.w > 0.0f ? radius / entry.sphere.w : 1.0f;
+                    const auto distance = glm::length(center - glm::vec3(camera.pos)) - radius;
+
+                    draw_lods[index] = select_lod(entry, distance, scale, pixels, draw_lods[index]);
+                }
+
+                const auto lod = draw_lods[index];
+                auto& command = visible_list[entry.command + lod];
+
+                last_stats.submitted_triangles += command.indexCount / 3;
+                instance_list[entry.instance_slot + lod * entry.group_size + command.instanceCount++] = index;
+            }
+
+            last_stats.frustum_draws = draw_list.size() - visible_draws.size();
+
+            // Same compaction the GPU path does with VK_KHR_draw_indirect_count, without the extension
+            visible_counts.assign(draw_batches.size(), 0);
+
+            for (usize i = 0; i < draw_batches.size(); ++i) {
+                const auto first = visible_list.begin() + draw_batches[i].first;
+                const auto last = std::stable_partition(first, first + draw_batches[i].count, [](const VkDrawIndexedIndirectCommand& command) {
+                    return command.instanceCount > 0;
+                });
+
+                visible_counts[i] = last - first;
             }
+
+            visible_buffer[current_frame].write(visible_list);
+            instance_buffer[current_frame].write(instance_list);
         }
 
-        static void update_point_lights(const std::vector<PointLight>& point_lights) {
-            auto& current = point_light_buffer[current_frame];
+        // Reported once when lights start being dropped, cluster::max_lights must grow if it persists. Overflowing
+        // deferred tiles drop nothing but shade far slower, they are reported the same way
+        static void read_light_stats() {
+            const auto previous = last_light_stats;
+            std::memcpy(&last_light_stats, light_stats_buffer[current_frame].buf(), sizeof(LightStats));
 
-            if (point_lights.empty()) {
-                return;
+            if (last_light_stats.overflow_clusters > 0 && previous.overflow_clusters == 0) {
+                logger::warning("{} light clusters are full, {} lights were left out", last_light_stats.overflow_clusters, last_light_stats.dropped_cluster_lights);
             }
 
-            if (current.size() == point_lights.size()) {
-                current.write(point_lights);
-            } else {
-                current.write(point_lights);
+            if (last_light_stats.overflow_tiles > 0 && previous.overflow_tiles == 0) {
+                logger::warning("{} deferred tiles overflowed their light list with up to {} lights, shaded against every light", last_light_stats.overflow_tiles, last_light_stats.peak_tile_lights);
+            }
+        }
 
-                api::SingleUpdateBufferInfo info{}; {
-                    info.buffer = current.info();
-                    info.type = vk::DescriptorType::eStorageBuffer;
-                    info.binding = binding::point_light;
-                }
+        static void update_lighting(const Camera& camera) {
+            // Planes of a zero-to-one right handed perspective projection
+            lighting.point_lights_count = point_lights.size();
+            lighting.directional_lights_count = directional_lights.size();
+            lighting.near = camera.projection[3][2] / camera.projection[2][2];
+            lighting.far = camera.projection[3][2] / (camera.projection[2][2] + 1.0f);
+            lighting.tile_size = glm::vec2(
+                static_cast<f32>(context.swapchain.extent.width) / cluster::x,
+                static_cast<f32>(context.swapchain.extent.height) / cluster::y);
+
+            // The frame's previous use of the counters has completed
+            light_stats_buffer[current_frame].write(LightStats{});
+        }
 
-                generic_set[current_frame].update(info);
+        // Bins point lights into the froxel grid, the lit fragment shaders only walk the lights of their cluster
+        static void light_cluster_pass(const vk::CommandBuffer command_buffer) {
+            std::array sets{
+                minimal_set[current_frame].handle(),
+                generic_set[current_frame].handle()
+            };
+
+            command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, light_cluster.handle, context.dispatcher);
+            command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, light_cluster.layout, 0, sets, nullptr, context.dispatcher);
+            command_buffer.pushConstants<LightingConstants>(light_cluster.layout, vk::ShaderStageFlagBits::eCompute, 0, lighting, context.dispatcher);
+            command_buffer.dispatch((cluster::count + light_cluster_group_size - 1) / light_cluster_group_size, 1, 1, context.dispatcher);
+
+            vk::MemoryBarrier cluster_barrier{}; {
+                cluster_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+                cluster_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
             }
+
+            command_buffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eFragmentShader,
+                vk::DependencyFlagBits{},
+                cluster_barrier,
+                nullptr,
+                nullptr,
+                context.dispatcher);
         }
 
-        static void update_directional_lights(const std::vector<DirectionalLight>& directional_lights) {
-            auto& current = directional_light_buffer[current_frame];
+        static void set_viewport(const vk::CommandBuffer command_buffer) {
+            vk::Viewport viewport{}; {
+                viewport.width = context.swapchain.extent.width;
+                viewport.height = -static_cast<float>(context.swapchain.extent.height);
+                viewport.x = 0;
+                viewport.y = context.swapchain.extent.height;
+                viewport.minDepth = 0.0f;
+                viewport.maxDepth = 1.0f;
+            }
+
+            vk::Rect2D scissor{}; {
+                scissor.extent = context.swapchain.extent;
+                scissor.offset = { { 0, 0 } };
+            }
 
-            if (directional_lights.empty()) {
+            command_buffer.setViewport(0, viewport, context.dispatcher);
+            command_buffer.setScissor(0, scissor, context.dispatcher);
+        }
+
+        // Issues the commands of batch i in the given culling phase. Compacted batches only draw their commands with
+        // visible instances, without compaction the GPU skips the empty ones
+        static void draw_batch(const vk::CommandBuffer command_buffer, const usize i, const u32 phase) {
+            const auto& batch = draw_batches[i];
+            const auto offset = (phase * command_count + batch.first) * sizeof(VkDrawIndexedIndirectCommand);
+
+            if (compaction) {
+                command_buffer.drawIndexedIndirectCountKHR(
+                    compacted_buffer[current_frame].handle(),
+                    offset,
+                    draw_count_buffer[current_frame].handle(),
+                    (phase * draw_batches.size() + i) * sizeof(u32),
+                    batch.count,
+                    sizeof(VkDrawIndexedIndirectCommand),
+                    context.dispatcher);
                 return;
             }
 
-            if (current.size() == directional_lights.size()) {
-                current.write(directional_lights);
-            } else {
-                current.write(directional_lights);
+            command_buffer.drawIndexedIndirect(
+                visible_buffer[current_frame].handle(),
+                offset,
+                cpu_culling ? visible_counts[i] : batch.count,
+                sizeof(VkDrawIndexedIndirectCommand),
+                context.dispatcher);
+        }
 
-                api::SingleUpdateBufferInfo info{}; {
-                    info.buffer = current.info();
-                    info.type = vk::DescriptorType::eStorageBuffer;
-                    info.binding = binding::directional_light;
+        // Both index types live in the same arena, only the type of the binding changes
+        static void bind_indices(const vk::CommandBuffer command_buffer, const DrawBatch& batch, u32& bound_index_type) {
+            if (static_cast<u32>(batch.short_indices) == bound_index_type) {
+                return;
+            }
+
+            command_buffer.bindIndexBuffer(
+                geometry_arena.indices.handle,
+                0,
+                batch.short_indices ? vk::IndexType::eUint16 : vk::IndexType::eUint32,
+                context.dispatcher);
+
+            bound_index_type = batch.short_indices;
+        }
+
+        // Depth of batches [first, last) with a single pipeline over the position stream
+        static void depth_prepass_pass(const vk::CommandBuffer command_buffer, const usize first, const usize last, const u32 phase) {
+            u32 bound_index_type = ~0u;
+
+            set_viewport(command_buffer);
+
+            command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, depth_only.handle, context.dispatcher);
+            command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, depth_only.layout, 0, minimal_set[current_frame].handle(), nullptr, context.dispatcher);
+            command_buffer.bindVertexBuffers(0, geometry_arena.positions.handle, static_cast<vk::DeviceSize>(0), context.dispatcher);
+
+            for (usize i = first; i < last; ++i) {
+                if (cpu_culling && visible_counts[i] == 0) {
+                    continue;
                 }
 
-                generic_set[current_frame].update(info);
+                bind_indices(command_buffer, draw_batches[i], bound_index_type);
+                draw_batch(command_buffer, i, phase);
             }
         }
 
-        static void final_draw_pass(const RenderData& data) {
-            auto& command_buffer = command_buffers[image_index];
+        // Triangle IDs of batches [first, last), like the pre-pass a single pipeline over the position stream
+        static void visibility_pass(const vk::CommandBuffer command_buffer, const usize first, const usize last, const u32 phase) {
+            u32 bound_index_type = ~0u;
 
-            for (usize i = 0; i < data.draw_commands.size(); ++i) {
-                auto& draw = data.draw_commands[i];
-                auto& model = draw.model;
+            set_viewport(command_buffer);
 
-                for (const auto& submesh : model.submeshes) {
-                    auto& vbo = submesh.mesh.vbo;
-                    auto& ibo = submesh.mesh.ibo;
-                    auto& index_count = submesh.mesh.index_count;
+            std::array sets{
+                minimal_set[current_frame].handle(),
+                generic_set[current_frame].handle(),
+                visibility_set[current_frame].handle()
+            };
 
-                    if (draw.shader.handle == generic.handle) {
-                        std::array sets{
-                            minimal_set[current_frame].handle(),
-                            generic_set[current_frame].handle()
-                        };
+            command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, visibility_ids.handle, context.dispatcher);
+            command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, visibility_ids.layout, 0, sets, nullptr, context.dispatcher);
+            command_buffer.bindVertexBuffers(0, geometry_arena.positions.handle, static_cast<vk::DeviceSize>(0), context.dispatcher);
 
-                        std::array indices{
-                            static_cast<u32>(i),
-                            static_cast<u32>(submesh.albedo.index),
-                            static_cast<u32>(submesh.metallic.index),
-                            static_cast<u32>(submesh.normal.index),
-                            static_cast<u32>(data.point_lights.size()),
-                            static_cast<u32>(data.directional_lights.size())
-                        };
+            for (usize i = first; i < last; ++i) {
+                if (cpu_culling && visible_counts[i] == 0) {
+                    continue;
+                }
 
-                        command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, generic.handle, context.dispatcher);
-                        command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, generic.layout, 0, sets, nullptr, context.dispatcher);
-                        command_buffer.pushConstants<u32>(generic.layout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, indices, context.dispatcher);
-                    } else if (draw.shader.handle == minimal.handle) {
-                        std::array indices{
-                            static_cast<u32>(i),
-                            static_cast<u32>(submesh.albedo.index)
-                        };
+                bind_indices(command_buffer, draw_batches[i], bound_index_type);
+                draw_batch(command_buffer, i, phase);
+            }
+        }
 
-                        command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, minimal.handle, context.dispatcher);
-                        command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, minimal.layout, 0, minimal_set[current_frame].handle(), nullptr, context.dispatcher);
-                        command_buffer.pushConstants<u32>(minimal.layout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, indices, context.dispatcher);
-                    } else if (draw.shader.handle == pbr.handle) {
+        // Records batches [first, last) of a culling phase, state is set from scratch so any slice can go to its own secondary buffer
+        static void final_draw_pass(const vk::CommandBuffer command_buffer, const usize first, const usize last, const u32 phase) {
+            vk::Pipeline bound_pipeline{};
+            u32 bound_sets = ~0u;
+            u32 bound_index_type = ~0u;
+
+            set_viewport(command_buffer);
+
+            command_buffer.bindVertexBuffers(0, geometry_arena.vertices.handle, static_cast<vk::DeviceSize>(0), context.dispatcher);
+
+            for (usize i = first; i < last; ++i) {
+                auto& batch = draw_batches[i];
+
+                if (cpu_culling && visible_counts[i] == 0) {
+                    continue;
+                }
+
+                // Lit pipelines all write the same G-buffer layout, the lighting pass shades them alike
+                const auto& pipeline = !deferred_shading ? batch.pipeline : batch.pipeline.handle == minimal.handle ? gbuffer_unlit : gbuffer_lit;
+
+                if (pipeline.handle != bound_pipeline) {
+                    command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.handle, context.dispatcher);
+                    bound_pipeline = pipeline.handle;
+                }
+
+                if (batch.sets != bound_sets) {
+                    if (deferred_shading) {
+                        command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.layout, 0, minimal_set[current_frame].handle(), nullptr, context.dispatcher);
+                    } else if (pipeline.handle == generic.handle || pipeline.handle == pbr.handle) {
                         std::array sets{
                             minimal_set[current_frame].handle(),
                             generic_set[current_frame].handle()
                         };
 
-                        std::array indices{
-                            static_cast<u32>(i),
-                            static_cast<u32>(submesh.albedo.index),
-                            static_cast<u32>(submesh.metallic.index),
-                            static_cast<u32>(submesh.normal.index),
-                            static_cast<u32>(submesh.roughness.index),
-                            static_cast<u32>(submesh.occlusion.index),
-                            static_cast<u32>(data.point_lights.size()),
-                            static_cast<u32>(data.directional_lights.size())
-                        };
-
-                        command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pbr.handle, context.dispatcher);
-                        command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pbr.layout, 0, sets, nullptr, context.dispatcher);
-                        command_buffer.pushConstants<u32>(pbr.layout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, indices, context.dispatcher);
+                        command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.layout, 0, sets, nullptr, context.dispatcher);
+                        command_buffer.pushConstants<LightingConstants>(pipeline.layout, vk::ShaderStageFlagBits::eFragment, 0, lighting, context.dispatcher);
+                    } else if (pipeline.handle == minimal.handle) {
+                        command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, minimal.layout, 0, minimal_set[current_frame].handle(), nullptr, context.dispatcher);
                     }
 
-                    command_buffer.bindIndexBuffer(ibo.buffer.handle, 0, vk::IndexType::eUint32, context.dispatcher);
-                    command_buffer.bindVertexBuffers(0, vbo.buffer.handle, static_cast<vk::DeviceSize>(0), context.dispatcher);
-                    command_buffer.drawIndexed(index_count, 1, 0, 0, 0, context.dispatcher);
+                    bound_sets = batch.sets;
+                }
+
+                bind_indices(command_buffer, batch, bound_index_type);
+                draw_batch(command_buffer, i, phase);
+            }
+        }
+
+        // Pre-pass followed by the colour pass, both inline
+        static void draw_inline(const vk::CommandBuffer command_buffer, const u32 phase) {
+            if (depth_prepass) {
+                depth_prepass_pass(command_buffer, 0, draw_batches.size(), phase);
+            }
+
+            if (visibility_shading) {
+                visibility_pass(command_buffer, 0, draw_batches.size(), phase);
+            } else {
+                final_draw_pass(command_buffer, 0, draw_batches.size(), phase);
+            }
+        }
+
+        // Render pass and framebuffer the draws go to with the selected shading
+        [[nodiscard]] static vk::RenderPass draw_render_pass() {
+            return deferred_shading ? gbuffer_render_pass : visibility_shading ? visibility_render_pass : offscreen_render_pass;
+        }
+
+        [[nodiscard]] static vk::Framebuffer draw_framebuffer() {
+            return deferred_shading ? gbuffer_framebuffer : visibility_shading ? visibility_framebuffer : offscreen_framebuffer;
+        }
+
+        // First batch starting at or after the given command
+        [[nodiscard]] static usize batch_at(const usize command) {
+            return std::partition_point(draw_batches.begin(), draw_batches.end(), [command](const DrawBatch& batch) {
+                return batch.first < command;
+            }) - draw_batches.begin();
+        }
+
+        // Splits the command list in contiguous slices of about the same number of commands, each recorded into a
+        // secondary buffer by its own job. Slices end on batch boundaries. With the pre-pass on, every slice's depth
+        // buffer comes before all colour buffers
+        [[nodiscard]] static std::vector<vk::CommandBuffer> record_secondary(const usize workers) {
+            std::vector<vk::CommandBuffer> secondaries(depth_prepass ? 2 * workers : workers);
+            jobs::Counter recording{};
+
+            const auto colour_offset = depth_prepass ? workers : 0;
+
+            for (usize i = 0; i < workers; ++i) {
+                const auto first = batch_at(i * command_count / workers);
+                const auto last = batch_at((i + 1) * command_count / workers);
+                const auto secondary = secondary_buffers[i][image_index];
+                const auto prepass = depth_prepass ? prepass_buffers[i][image_index] : vk::CommandBuffer{};
+
+                secondaries[colour_offset + i] = secondary;
+
+                if (prepass) {
+                    secondaries[i] = prepass;
                 }
+
+                jobs::submit([secondary, prepass, first, last]() {
+                    vk::CommandBufferInheritanceInfo inheritance_info{}; {
+                        inheritance_info.renderPass = draw_render_pass();
+                        inheritance_info.subpass = 0;
+                        inheritance_info.framebuffer = draw_framebuffer();
+
+                        if (statistics_pool) {
+                            inheritance_info.pipelineStatistics = vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+                        }
+                    }
+
+                    vk::CommandBufferBeginInfo begin_info{}; {
+                        begin_info.flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+                        begin_info.pInheritanceInfo = &inheritance_info;
+                    }
+
+                    if (prepass) {
+                        prepass.begin(begin_info, context.dispatcher);
+                        depth_prepass_pass(prepass, first, last, 0);
+                        prepass.end(context.dispatcher);
+                    }
+
+                    secondary.begin(begin_info, context.dispatcher);
+
+                    if (visibility_shading) {
+                        visibility_pass(secondary, first, last, 0);
+                    } else {
+                        final_draw_pass(secondary, first, last, 0);
+                    }
+
+                    secondary.end(context.dispatcher);
+                }, recording);
+            }
+
+            jobs::wait(recording);
+
+            return secondaries;
+        }
+
+        // Copies a lit target of the deferred or visibility buffer path, in the General layout, into the offscreen
+        // colour target and leaves that where the forward pass would, ready for copy_to_swapchain
+        static void blit_to_offscreen(const vk::CommandBuffer command_buffer, const api::Image& source) {
+            std::array<vk::ImageMemoryBarrier, 2> blit_barriers{}; {
+                blit_barriers[0].image = source.handle;
+                blit_barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                blit_barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                blit_barriers[0].subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+                blit_barriers[0].subresourceRange.layerCount = 1;
+                blit_barriers[0].subresourceRange.baseArrayLayer = 0;
+                blit_barriers[0].subresourceRange.levelCount = 1;
+                blit_barriers[0].subresourceRange.baseMipLevel = 0;
+                blit_barriers[0].oldLayout = vk::ImageLayout::eGeneral;
+                blit_barriers[0].newLayout = vk::ImageLayout::eTransferSrcOptimal;
+                blit_barriers[0].srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+                blit_barriers[0].dstAccessMask = vk::AccessFlagBits::eTransferRead;
+
+                // The previous frame's copy to the swapchain must be done reading it
+                blit_barriers[1] = blit_barriers[0];
+                blit_barriers[1].image = offscreen.color.handle;
+                blit_barriers[1].oldLayout = vk::ImageLayout::eUndefined;
+                blit_barriers[1].newLayout = vk::ImageLayout::eTransferDstOptimal;
+                blit_barriers[1].srcAccessMask = vk::AccessFlagBits::eTransferRead;
+                blit_barriers[1].dstAccessMask = vk::AccessFlagBits::eTransferWrite;
             }
+
+            command_buffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+                vk::PipelineStageFlagBits::eTransfer,
+                vk::DependencyFlagBits{},
+                nullptr,
+                nullptr,
+                blit_barriers,
+                context.dispatcher);
+
+            // Converts the float target to the sRGB offscreen format
+            vk::ImageBlit blit{}; {
+                blit.srcOffsets[1] = vk::Offset3D{ source.width, source.height, 1 };
+                blit.dstOffsets[1] = vk::Offset3D{ offscreen.color.width, offscreen.color.height, 1 };
+                blit.srcSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+                blit.srcSubresource.mipLevel = 0;
+                blit.srcSubresource.baseArrayLayer = 0;
+                blit.srcSubresource.layerCount = 1;
+                blit.dstSubresource = blit.srcSubresource;
+            }
+
+            command_buffer.blitImage(
+                source.handle, vk::ImageLayout::eTransferSrcOptimal,
+                offscreen.color.handle, vk::ImageLayout::eTransferDstOptimal,
+                blit, vk::Filter::eNearest, context.dispatcher);
+
+            vk::ImageMemoryBarrier copy_barrier = blit_barriers[1]; {
+                copy_barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+                copy_barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+                copy_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+                copy_barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+            }
+
+            command_buffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eTransfer,
+                vk::PipelineStageFlagBits::eTransfer,
+                vk::DependencyFlagBits{},
+                nullptr,
+                nullptr,
+                copy_barrier,
+                context.dispatcher);
+        }
+
+        // Moves a lit target to the General layout once the previous frame's blit is done reading it
+        static void prepare_lit_target(const vk::CommandBuffer command_buffer, const api::Image& target) {
+            vk::ImageMemoryBarrier lit_barrier{}; {
+                lit_barrier.image = target.handle;
+                lit_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                lit_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                lit_barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+                lit_barrier.subresourceRange.layerCount = 1;
+                lit_barrier.subresourceRange.baseArrayLayer = 0;
+                lit_barrier.subresourceRange.levelCount = 1;
+                lit_barrier.subresourceRange.baseMipLevel = 0;
+                lit_barrier.oldLayout = vk::ImageLayout::eUndefined;
+                lit_barrier.newLayout = vk::ImageLayout::eGeneral;
+                lit_barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
+                lit_barrier.dstAccessMask = vk::AccessFlagBits::eShaderWrite;
+            }
+
+            command_buffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eTransfer,
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::DependencyFlagBits{},
+                nullptr,
+                nullptr,
+                lit_barrier,
+                context.dispatcher);
+        }
+
+        // Shades the G-buffer one 16x16 tile per workgroup into gbuffer.lit
+        static void deferred_lighting_pass(const vk::CommandBuffer command_buffer) {
+            prepare_lit_target(command_buffer, gbuffer.lit);
+
+            std::array sets{
+                minimal_set[current_frame].handle(),
+                generic_set[current_frame].handle(),
+                deferred_set.handle()
+            };
+
+            command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, deferred_lighting.handle, context.dispatcher);
+            command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, deferred_lighting.layout, 0, sets, nullptr, context.dispatcher);
+            command_buffer.pushConstants<LightingConstants>(deferred_lighting.layout, vk::ShaderStageFlagBits::eCompute, 0, lighting, context.dispatcher);
+            command_buffer.dispatch(
+                (gbuffer.lit.width + deferred_tile_size - 1) / deferred_tile_size,
+                (gbuffer.lit.height + deferred_tile_size - 1) / deferred_tile_size,
+                1, context.dispatcher);
+
+            blit_to_offscreen(command_buffer, gbuffer.lit);
+        }
+
+        // Rebuilds and shades the triangle under every pixel of the visibility buffer into visibility_target.lit
+        static void visibility_resolve_pass(const vk::CommandBuffer command_buffer) {
+            prepare_lit_target(command_buffer, visibility_target.lit);
+
+            VisibilityConstants constants{}; {
+                constants.lighting = lighting;
+                constants.draw_count = draw_list.size();
+            }
+
+            std::array sets{
+                minimal_set[current_frame].handle(),
+                generic_set[current_frame].handle(),
+                visibility_set[current_frame].handle()
+            };
+
+            command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, visibility_resolve.handle, context.dispatcher);
+            command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, visibility_resolve.layout, 0, sets, nullptr, context.dispatcher);
+            command_buffer.pushConstants<VisibilityConstants>(visibility_resolve.layout, vk::ShaderStageFlagBits::eCompute, 0, constants, context.dispatcher);
+            command_buffer.dispatch(
+                (visibility_target.lit.width + resolve_group_size - 1) / resolve_group_size,
+                (visibility_target.lit.height + resolve_group_size - 1) / resolve_group_size,
+                1, context.dispatcher);
+
+            blit_to_offscreen(command_buffer, visibility_target.lit);
+        }
+
+        // Filters the finished offscreen colour into offscreen.aa, copied to the swapchain in its place
+        static void fxaa_post_pass(const vk::CommandBuffer command_buffer) {
+            std::array<vk::ImageMemoryBarrier, 2> fxaa_barriers{}; {
+                fxaa_barriers[0].image = offscreen.color.handle;
+                fxaa_barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                fxaa_barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                fxaa_barriers[0].subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+                fxaa_barriers[0].subresourceRange.layerCount = 1;
+                fxaa_barriers[0].subresourceRange.baseArrayLayer = 0;
+                fxaa_barriers[0].subresourceRange.levelCount = 1;
+                fxaa_barriers[0].subresourceRange.baseMipLevel = 0;
+                fxaa_barriers[0].oldLayout = vk::ImageLayout::eTransferSrcOptimal;
+                fxaa_barriers[0].newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+                fxaa_barriers[0].srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eTransferWrite;
+                fxaa_barriers[0].dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+                // The previous frame's copy to the swapchain must be done reading it
+                fxaa_barriers[1] = fxaa_barriers[0];
+                fxaa_barriers[1].image = offscreen.aa.handle;
+                fxaa_barriers[1].oldLayout = vk::ImageLayout::eUndefined;
+                fxaa_barriers[1].newLayout = vk::ImageLayout::eGeneral;
+                fxaa_barriers[1].srcAccessMask = vk::AccessFlagBits::eTransferRead;
+                fxaa_barriers[1].dstAccessMask = vk::AccessFlagBits::eShaderWrite;
+            }
+
+            command_buffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eTransfer,
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::DependencyFlagBits{},
+                nullptr,
+                nullptr,
+                fxaa_barriers,
+                context.dispatcher);
+
+            command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, fxaa_filter.handle, context.dispatcher);
+            command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, fxaa_filter.layout, 0, fxaa_set.handle(), nullptr, context.dispatcher);
+            command_buffer.dispatch(
+                (offscreen.aa.width + fxaa_group_size - 1) / fxaa_group_size,
+                (offscreen.aa.height + fxaa_group_size - 1) / fxaa_group_size,
+                1, context.dispatcher);
+
+            vk::ImageMemoryBarrier copy_barrier = fxaa_barriers[1]; {
+                copy_barrier.oldLayout = vk::ImageLayout::eGeneral;
+                copy_barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+                copy_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+                copy_barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+            }
+
+            command_buffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eTransfer,
+                vk::DependencyFlagBits{},
+                nullptr,
+                nullptr,
+                copy_barrier,
+                context.dispatcher);
         }
 
         static void copy_to_swapchain() {
@@ -450,7 +3229,7 @@ namespace tethys {
                 context.dispatcher);
 
             command_buffer.copyImage(
-                offscreen.color.handle, vk::ImageLayout::eTransferSrcOptimal,
+                fxaa ? offscreen.aa.handle : offscreen.color.handle, vk::ImageLayout::eTransferSrcOptimal,
                 context.swapchain.images[image_index], vk::ImageLayout::eTransferDstOptimal,
                 copy, context.dispatcher);
 
@@ -481,6 +3260,9 @@ namespace tethys {
 
 
         void draw(const RenderData& data) {
+            // Uploads recorded since the last frame are submitted ahead of it
+            api::flush_uploads();
+
             image_index = context.device.logical.acquireNextImageKHR(context.swapchain.handle, -1, image_available[current_frame], nullptr, context.dispatcher).value;
 
             if (!in_flight[current_frame]) {
@@ -493,60 +3275,191 @@ namespace tethys {
 
             context.device.logical.waitForFences(in_flight[current_frame], true, -1, context.dispatcher);
 
+            // The GPU is done with this frame, its counters are from the last time it was recorded
+            if (!cpu_culling) {
+                std::memcpy(&last_stats, cull_stats_buffer[current_frame].buf(), sizeof(CullStats));
+            }
+
+            read_light_stats();
+
+            if (statistics_written & 1u << current_frame) {
+                u64 invocations{};
+
+                const auto result = context.device.logical.getQueryPoolResults(
+                    statistics_pool, current_frame, 1, sizeof(u64), &invocations, sizeof(u64), vk::QueryResultFlagBits::e64, context.dispatcher);
+
+                if (result == vk::Result::eSuccess) {
+                    last_fragment_invocations = invocations;
+                }
+            }
+
             auto& command_buffer = command_buffers[image_index];
 
             vk::CommandBufferBeginInfo begin_info{}; {
                 begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
             }
 
+            // Host side updates go before recording, some of them wait on the other frames in flight
+            update_streaming();
+            update_transforms();
+            update_camera(data.camera);
+            update_point_lights();
+            update_directional_lights();
+            update_draws(data.camera);
+            update_geometry_bindings();
+            update_lighting(data.camera);
+
             command_buffer.begin(begin_info, context.dispatcher);
 
-            update_transforms(data);
-            update_camera(data.camera);
-            update_point_lights(data.point_lights);
-            update_directional_lights(data.directional_lights);
+            if (!deferred_shading) {
+                light_cluster_pass(command_buffer);
+            }
+
+            if (cpu_culling) {
+                cpu_cull_pass(data.camera);
+            } else {
+                cull_pass(command_buffer, data.camera, 0);
+            }
+
+            if (meshlet_culling) {
+                meshlet_pass(command_buffer, data.camera, 0);
+            }
+
+            if (compaction) {
+                compact_pass(command_buffer, data.camera, 0);
+            }
+
+            if (statistics_pool) {
+                command_buffer.resetQueryPool(statistics_pool, current_frame, 1, context.dispatcher);
+                command_buffer.beginQuery(statistics_pool, current_frame, vk::QueryControlFlags{}, context.dispatcher);
+            }
 
             /* Final color pass */ {
-                std::array<vk::ClearValue, 2> clear_values{}; {
+                std::array<vk::ClearValue, 3> clear_values{}; {
                     clear_values[0].color = vk::ClearColorValue{ std::array{ 0.01f, 0.01f, 0.01f, 0.0f } };
                     clear_values[1].depthStencil = vk::ClearDepthStencilValue{ { 1.0f, 0 } };
                 }
 
+                // The G-buffer has a second colour target before its depth
+                if (deferred_shading) {
+                    clear_values[1].color = vk::ClearColorValue{ std::array{ 0.0f, 0.0f, 0.0f, 0.0f } };
+                    clear_values[2].depthStencil = vk::ClearDepthStencilValue{ { 1.0f, 0 } };
+                }
+
+                // Triangle ID 0 marks pixels nothing was drawn to
+                if (visibility_shading) {
+                    clear_values[0].color = vk::ClearColorValue{ std::array{ 0u, 0u, 0u, 0u } };
+                }
+
                 vk::RenderPassBeginInfo render_pass_begin_info{}; {
                     render_pass_begin_info.renderArea.extent = context.swapchain.extent;
-                    render_pass_begin_info.framebuffer = offscreen_framebuffer;
-                    render_pass_begin_info.renderPass = offscreen_render_pass;
+                    render_pass_begin_info.framebuffer = draw_framebuffer();
+                    render_pass_begin_info.renderPass = draw_render_pass();
                     render_pass_begin_info.clearValueCount = clear_values.size();
                     render_pass_begin_info.pClearValues = clear_values.data();
                 }
 
-                vk::Viewport viewport{}; {
-                    viewport.width = context.swapchain.extent.width;
-                    viewport.height = -static_cast<float>(context.swapchain.extent.height);
-                    viewport.x = 0;
-                    viewport.y = context.swapchain.extent.height;
-                    viewport.minDepth = 0.0f;
-                    viewport.maxDepth = 1.0f;
+                const auto workers = std::min<usize>(worker_pools.size(), command_count / commands_per_worker);
+
+                if (workers > 1) {
+                    command_buffer.beginRenderPass(render_pass_begin_info, vk::SubpassContents::eSecondaryCommandBuffers, context.dispatcher);
+                    command_buffer.executeCommands(record_secondary(workers), context.dispatcher);
+                    recording_workers = workers;
+                } else {
+                    command_buffer.beginRenderPass(render_pass_begin_info, vk::SubpassContents::eInline, context.dispatcher);
+                    draw_inline(command_buffer, 0);
+                    recording_workers = 0;
+                }
+
+                command_buffer.endRenderPass(context.dispatcher);
+            }
+
+            // Second phase: draws that were hidden last frame but pass against this frame's depth
+            if (occlusion_culling && !command_list.empty()) {
+                build_depth_pyramid(command_buffer);
+                cull_pass(command_buffer, data.camera, 1);
+
+                if (meshlet_culling) {
+                    meshlet_pass(command_buffer, data.camera, 1);
                 }
 
-                vk::Rect2D scissor{}; {
-                    scissor.extent = context.swapchain.extent;
-                    scissor.offset = { { 0, 0 } };
+                if (compaction) {
+                    compact_pass(command_buffer, data.camera, 1);
                 }
 
-                command_buffer.setViewport(0, viewport, context.dispatcher);
-                command_buffer.setScissor(0, scissor, context.dispatcher);
+                vk::RenderPassBeginInfo render_pass_begin_info{}; {
+                    render_pass_begin_info.renderArea.extent = context.swapchain.extent;
+                    render_pass_begin_info.framebuffer = offscreen_framebuffer;
+                    render_pass_begin_info.renderPass = resume_render_pass;
+                }
 
                 command_buffer.beginRenderPass(render_pass_begin_info, vk::SubpassContents::eInline, context.dispatcher);
-                final_draw_pass(data);
+                draw_inline(command_buffer, 1);
                 command_buffer.endRenderPass(context.dispatcher);
             }
 
+            if (statistics_pool) {
+                command_buffer.endQuery(statistics_pool, current_frame, context.dispatcher);
+                statistics_written |= 1u << current_frame;
+            }
+
+            if (deferred_shading) {
+                deferred_lighting_pass(command_buffer);
+            }
+
+            if (visibility_shading) {
+                visibility_resolve_pass(command_buffer);
+            }
+
+            if (fxaa) {
+                fxaa_post_pass(command_buffer);
+            }
+
             copy_to_swapchain();
 
             command_buffer.end(context.dispatcher);
         }
 
+        void shutdown() {
+            // An import in progress finishes first, it may be running jobs
+            {
+                std::lock_guard lock{ loader.mutex };
+                loader.stop = true;
+            }
+
+            loader.condition.notify_one();
+
+            if (loader.thread.joinable()) {
+                loader.thread.join();
+            }
+
+            loader.requests.clear();
+            loader.decoded.clear();
+
+            for (const auto& asset : streamed_assets) {
+                api::wait_upload(asset.upload);
+            }
+
+            streamed_assets.clear();
+            context.device.logical.waitIdle(context.dispatcher);
+        }
+
+        CullStats cull_stats() {
+            return last_stats;
+        }
+
+        LightStats light_stats() {
+            return last_light_stats;
+        }
+
+        u64 fragment_invocations() {
+            return last_fragment_invocations;
+        }
+
+        u32 secondary_workers() {
+            return recording_workers;
+        }
+
         void submit() {
             vk::PipelineStageFlags wait_mask{ vk::PipelineStageFlagBits::eColorAttachmentOutput };
             vk::SubmitInfo submit_info{}; {
@@ -1,5 +1,5 @@
-#include <tethys/api/command_buffer.hpp>
 #include <tethys/api/static_buffer.hpp>
+#include <tethys/api/upload.hpp>
 #include <tethys/api/context.hpp>
 #include <tethys/api/sampler.hpp>
 #include <tethys/texture.hpp>
@@ -10,14 +10,17 @@
 
 #include <vulkan/vulkan.hpp>
 #include <fstream>
+#include <cstring>
 #include <string>
 #include <cmath>
 
 namespace tethys {
     using namespace api;
 
-    static void generate_mipmaps(const Texture& texture) {
-        auto command_buffer = api::begin_transient();
+    // Blits need a graphics queue, so the chain is recorded after the batch's copies
+    [[nodiscard]] static api::UploadToken generate_mipmaps(const Texture& texture) {
+        auto scope = api::record_upload();
+        auto command_buffer = scope.batch.graphics;
 
         vk::ImageMemoryBarrier barrier{}; {
             barrier.image = texture.image.handle;
@@ -106,10 +109,10 @@ namespace tethys {
             barrier,
             context.dispatcher);
 
-        end_transient(command_buffer);
+        return scope.batch.token;
     }
 
-    Texture load_texture(const char* path, const vk::Format format) {
+    ImageData decode_image(const char* path) {
         using namespace std::string_literals;
 
         if (!std::ifstream(path).is_open()) {
@@ -118,18 +121,32 @@ namespace tethys {
 
         i32 width, height, channels = 4;
 
+        auto data = stbi_load(path, &width, &height, &channels, STBI_rgb_alpha);
+
+        return { std::unique_ptr<u8, ImageDeleter>(data), static_cast<u32>(width), static_cast<u32>(height) };
+    }
+
+    void ImageDeleter::operator ()(u8* pixels) const {
+        stbi_image_free(pixels);
+    }
+
+    void free_image(ImageData& image) {
+        image.pixels.reset();
+    }
+
+    Texture load_texture(const char* path, const vk::Format format) {
+        using namespace std::string_literals;
+
         logger::info("Loading texture: "s + path);
 
-        auto data = stbi_load(path, &width, &height, &channels, STBI_rgb_alpha);
-        auto texture = load_texture(data, width, height, 4, format);
-        stbi_image_free(data);
+        auto image = decode_image(path);
+        auto texture = load_texture(image.pixels.get(), image.width, image.height, 4, format);
+        free_image(image);
 
         return texture;
     }
 
     Texture load_texture(const u8* data, const u32 width, const u32 height, const u32 channels, const vk::Format format) {
-        static usize texture_index = 0;
-
         if (!data) {
             throw std::runtime_error("Error, can't load texture without data");
         }
@@ -138,15 +155,6 @@ namespace tethys {
             throw std::runtime_error("wtf are you doing");
         }
 
-        auto texture_size = width * height * channels;
-
-        auto staging = api::make_buffer(texture_size, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_CPU_ONLY, VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT);
-
-        void* mapped{};
-        vmaMapMemory(context.allocator, staging.allocation, &mapped);
-        std::memcpy(mapped, data, texture_size);
-        vmaUnmapMemory(context.allocator, staging.allocation);
-
         Texture texture;
         texture.mips = std::floor(std::log2(std::max(width, height)));
 
@@ -163,13 +171,17 @@ namespace tethys {
             create_info.aspect = vk::ImageAspectFlagBits::eColor;
             create_info.tiling = vk::ImageTiling::eOptimal;
             create_info.samples = vk::SampleCountFlagBits::e1;
+            create_info.upload = true;
         }
         texture.image = api::make_image(create_info);
-        texture.index = texture_index++;
 
         api::transition_image_layout(texture.image.handle, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, texture.mips);
-        api::copy_buffer_to_image(staging.handle, texture.image.handle, width, height);
-        generate_mipmaps(texture);
+        // stb_image always returns pixels in memory it allocates itself and cannot decode into a caller's buffer, so
+        // decoded textures still take one copy into the staging ring. Geometry is written straight into it
+        api::upload_image(texture.image.handle, width, height, channels, [data](u8* mapped, const usize offset, const usize size) {
+            std::memcpy(mapped, data + offset, size);
+        });
+        texture.upload = generate_mipmaps(texture);
 
         logger::info(
             "Successfully loaded texture, width: {}, height: {}, channels: {}",
@@ -0,0 +1,232 @@
+#include <tethys/logger.hpp>
+#include <tethys/model.hpp>
+#include <tethys/tmesh.hpp>
+
+#include <filesystem>
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+#include <vector>
+
+namespace tethys::tmesh {
+    [[nodiscard]] static i64 source_time(const std::string& source) {
+        return std::filesystem::last_write_time(source).time_since_epoch().count();
+    }
+
+    [[nodiscard]] static bool valid(const Header& header) {
+        return std::memcmp(header.magic, magic, sizeof(magic)) == 0 && header.version == version && header.vertex_stride == sizeof(Vertex);
+    }
+
+    // [offset, offset + count) lies within [0, size), without overflowing
+    [[nodiscard]] static bool in_range(const u64 offset, const u64 count, const u64 size) {
+        return offset <= size && count <= size - offset;
+    }
+
+    // Appends count elements of the given size to a section ending at end, false when it would pass size
+    [[nodiscard]] static bool append_section(u64& end, const u64 count, const u64 element, const u64 size) {
+        if (count > (size - end) / element) {
+            return false;
+        }
+
+        end += count * element;
+
+        return true;
+    }
+
+    // Every range a loader follows must stay inside the mapping, the file may be truncated or corrupt
+    [[nodiscard]] static bool valid_submesh(const File& file, const SubMesh& submesh) {
+        const auto& header = *file.header;
+
+        if (!in_range(submesh.vertex_offset, submesh.vertex_count, header.vertex_count) ||
+            !in_range(submesh.index_offset, submesh.index_count, header.index_count) ||
+            !in_range(submesh.meshlet_offset, submesh.meshlet_count, header.meshlet_count) ||
+            submesh.lod_count > max_lods) {
+            return false;
+        }
+
+        for (u32 i = 0; i < submesh.lod_count; ++i) {
+            if (!in_range(submesh.lods[i].index_offset, submesh.lods[i].index_count, submesh.index_count)) {
+                return false;
+            }
+        }
+
+        for (u64 i = 0; i < submesh.meshlet_count; ++i) {
+            const auto& meshlet = file.meshlets[submesh.meshlet_offset + i];
+
+            if (!in_range(meshlet.index_offset, meshlet.index_count, submesh.index_count)) {
+                return false;
+            }
+        }
+
+        // Indices are relative to the submesh's first vertex
+        for (u64 i = 0; i < submesh.index_count; ++i) {
+            if (file.indices[submesh.index_offset + i] >= submesh.vertex_count) {
+                return false;
+            }
+        }
+
+        for (const auto name : submesh.textures) {
+            if (name == no_texture) {
+                continue;
+            }
+
+            if (name >= header.strings_size || !std::memchr(file.strings + name, '\0', header.strings_size - name)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::string baked_path(const std::string& source) {
+        return std::filesystem::path(source).replace_extension(".tmesh").generic_string();
+    }
+
+    bool up_to_date(const std::string& source) {
+        std::ifstream file(baked_path(source), std::ios::binary);
+
+        if (!file.is_open()) {
+            return false;
+        }
+
+        Header header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(Header));
+
+        if (!file || !valid(header)) {
+            return false;
+        }
+
+        // Baked files may ship without their source
+        std::error_code error{};
+        const auto time = std::filesystem::last_write_time(source, error);
+
+        return error || header.source_time == time.time_since_epoch().count();
+    }
+
+    void bake(const std::string& source, const std::string& output) {
+        // Geometry and texture names only, textures stay in their own files
+        auto result = import_model(source, true, false, false);
+        const auto model_path = source.substr(0, source.find_last_of('/') + 1);
+
+        std::vector<SubMesh> submeshes(result.meshes.size());
+        std::string strings{};
+        Header header{}; {
+            std::memcpy(header.magic, magic, sizeof(magic));
+            header.version = version;
+            header.source_time = source_time(source);
+            header.submesh_count = submeshes.size();
+            header.vertex_stride = sizeof(Vertex);
+        }
+
+        for (usize i = 0; i < submeshes.size(); ++i) {
+            auto& submesh = submeshes[i];
+
+            submesh.vertex_offset = header.vertex_count;
+            submesh.vertex_count = result.meshes[i].geometry.size();
+            submesh.index_offset = header.index_count;
+            submesh.index_count = result.meshes[i].indices.size();
+            submesh.meshlet_offset = header.meshlet_count;
+            submesh.meshlet_count = result.meshes[i].meshlets.size();
+            submesh.lod_count = result.meshes[i].lods.size();
+
+            for (usize j = 0; j < submesh.lod_count; ++j) {
+                submesh.lods[j] = result.meshes[i].lods[j];
+            }
+
+            for (usize j = 0; j < 3; ++j) {
+                submesh.textures[j] = no_texture;
+
+                if (!result.texture_paths[i][j].empty()) {
+                    submesh.textures[j] = strings.size();
+                    strings += result.texture_paths[i][j].substr(model_path.size());
+                    strings += '\0';
+                }
+            }
+
+            header.vertex_count += submesh.vertex_count;
+            header.index_count += submesh.index_count;
+            header.meshlet_count += submesh.meshlet_count;
+        }
+
+        header.strings_size = strings.size();
+
+        std::ofstream file(output, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open " + output + " for writing");
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(reinterpret_cast<const char*>(submeshes.data()), submeshes.size() * sizeof(SubMesh));
+
+        for (const auto& mesh : result.meshes) {
+            file.write(reinterpret_cast<const char*>(mesh.geometry.data()), mesh.geometry.size() * sizeof(Vertex));
+        }
+
+        for (const auto& mesh : result.meshes) {
+            file.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(u32));
+        }
+
+        for (const auto& mesh : result.meshes) {
+            file.write(reinterpret_cast<const char*>(mesh.meshlets.data()), mesh.meshlets.size() * sizeof(Meshlet));
+        }
+
+        file.write(strings.data(), strings.size());
+
+        logger::info("Baked {} into {}: {} submeshes, {} vertices, {} indices, {} meshlets", source, output, header.submesh_count, header.vertex_count, header.index_count, header.meshlet_count);
+    }
+
+    File open(const std::string& path) {
+        File file{};
+        file.mapping = util::map_file(path.c_str());
+
+        const auto data = file.mapping.data;
+        file.header = reinterpret_cast<const Header*>(data);
+
+        if (file.mapping.size < sizeof(Header) || !valid(*file.header)) {
+            util::unmap_file(file.mapping);
+            throw std::runtime_error("Invalid baked mesh: " + path);
+        }
+
+        const u64 size = file.mapping.size;
+        const u64 submeshes_offset = sizeof(Header);
+        auto end = submeshes_offset;
+
+        const auto sections_fit =
+            append_section(end, file.header->submesh_count, sizeof(SubMesh), size) &&
+            append_section(end, file.header->vertex_count, sizeof(Vertex), size) &&
+            append_section(end, file.header->index_count, sizeof(u32), size) &&
+            append_section(end, file.header->meshlet_count, sizeof(Meshlet), size) &&
+            append_section(end, file.header->strings_size, 1, size);
+
+        if (!sections_fit) {
+            util::unmap_file(file.mapping);
+            throw std::runtime_error("Truncated baked mesh: " + path);
+        }
+
+        const auto vertices_offset = submeshes_offset + file.header->submesh_count * sizeof(SubMesh);
+        const auto indices_offset = vertices_offset + file.header->vertex_count * sizeof(Vertex);
+        const auto meshlets_offset = indices_offset + file.header->index_count * sizeof(u32);
+        const auto strings_offset = meshlets_offset + file.header->meshlet_count * sizeof(Meshlet);
+
+        file.submeshes = reinterpret_cast<const SubMesh*>(data + submeshes_offset);
+        file.vertices = reinterpret_cast<const Vertex*>(data + vertices_offset);
+        file.indices = reinterpret_cast<const u32*>(data + indices_offset);
+        file.meshlets = reinterpret_cast<const Meshlet*>(data + meshlets_offset);
+        file.strings = reinterpret_cast<const char*>(data + strings_offset);
+
+        for (u32 i = 0; i < file.header->submesh_count; ++i) {
+            if (!valid_submesh(file, file.submeshes[i])) {
+                util::unmap_file(file.mapping);
+                throw std::runtime_error("Corrupt submesh " + std::to_string(i) + " in baked mesh: " + path);
+            }
+        }
+
+        return file;
+    }
+
+    void close(File& file) {
+        util::unmap_file(file.mapping);
+        file = {};
+    }
+} // namespace tethys::tmesh
@@ -5,6 +5,7 @@
 #include <chrono>
 #include <string>
 #include <cstring>
+#include <stdexcept>
 
 namespace tethys::util {
 #if _WIN32
@@ -19,6 +20,38 @@ namespace tethys::util {
     void close_module(HMODULE handle) {
         FreeLibrary(handle);
     }
+
+    MappedFile map_file(const char* path) {
+        MappedFile mapped{};
+
+        mapped.file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (mapped.file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error(std::string("Failed to open file: ") + path);
+        }
+
+        LARGE_INTEGER size{};
+        GetFileSizeEx(mapped.file, &size);
+        mapped.size = size.QuadPart;
+
+        mapped.mapping = CreateFileMappingA(mapped.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        mapped.data = static_cast<const u8*>(MapViewOfFile(mapped.mapping, FILE_MAP_READ, 0, 0, 0));
+
+        if (!mapped.data) {
+            CloseHandle(mapped.mapping);
+            CloseHandle(mapped.file);
+            throw std::runtime_error(std::string("Failed to map file: ") + path);
+        }
+
+        return mapped;
+    }
+
+    void unmap_file(MappedFile& mapped) {
+        UnmapViewOfFile(mapped.data);
+        CloseHandle(mapped.mapping);
+        CloseHandle(mapped.file);
+        mapped = {};
+    }
 #elif __linux__
     void* load_module(const char* name) {
         return dlopen(name, RTLD_LAZY | RTLD_LOCAL);
@@ -31,6 +64,32 @@ namespace tethys::util {
     void close_module(void* handle) {
         dlclose(handle);
     }
+
+    MappedFile map_file(const char* path) {
+        const auto file = open(path, O_RDONLY);
+
+        if (file == -1) {
+            throw std::runtime_error(std::string("Failed to open file: ") + path);
+        }
+
+        struct stat info{};
+        fstat(file, &info);
+
+        void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        // The mapping keeps its own reference to the file
+        close(file);
+
+        if (data == MAP_FAILED) {
+            throw std::runtime_error(std::string("Failed to map file: ") + path);
+        }
+
+        return { static_cast<const u8*>(data), static_cast<usize>(info.st_size) };
+    }
+
+    void unmap_file(MappedFile& mapped) {
+        munmap(const_cast<u8*>(mapped.data), mapped.size);
+        mapped = {};
+    }
 #endif
 
     std::string timestamp() {
@@ -0,0 +1,81 @@
+#include <tethys/vertex.hpp>
+
+#include <glm/gtc/packing.hpp>
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+
+namespace tethys {
+    // Unit vector to the [-1, 1] octahedron, the lower hemisphere is folded over the diagonals
+    [[nodiscard]] static glm::vec2 oct_encode(const glm::vec3& v) {
+        const auto length = glm::abs(v.x) + glm::abs(v.y) + glm::abs(v.z);
+
+        if (length == 0.0f) {
+            return glm::vec2(0.0f);
+        }
+
+        const auto n = v / length;
+        const auto sign = glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+
+        return n.z >= 0.0f ? glm::vec2(n) : (1.0f - glm::abs(glm::vec2(n.y, n.x))) * sign;
+    }
+
+    [[nodiscard]] static glm::vec3 oct_decode(const glm::vec2& e) {
+        auto v = glm::vec3(e, 1.0f - glm::abs(e.x) - glm::abs(e.y));
+
+        if (v.z < 0.0f) {
+            const auto sign = glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+            const auto folded = (1.0f - glm::abs(glm::vec2(v.y, v.x))) * sign;
+            v.x = folded.x;
+            v.y = folded.y;
+        }
+
+        return glm::normalize(v);
+    }
+
+    [[nodiscard]] static i16 snorm16(const f32 value) {
+        return static_cast<i16>(glm::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    [[nodiscard]] static u16 unorm16(const f32 value) {
+        return static_cast<u16>(glm::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+    }
+
+    PackedVertex pack_vertex(const Vertex& vertex, const glm::vec3& min, const glm::vec3& extent) {
+        const auto position = (vertex.pos - min) / extent;
+        const auto normal = oct_encode(vertex.norms);
+        const auto tangent = oct_encode(vertex.tangent);
+        const auto handedness = glm::dot(glm::cross(vertex.norms, vertex.tangent), vertex.bitangent) < 0.0f ? 0.0f : 1.0f;
+
+        PackedVertex packed{}; {
+            packed.pos[0] = unorm16(position.x);
+            packed.pos[1] = unorm16(position.y);
+            packed.pos[2] = unorm16(position.z);
+            packed.pos[3] = unorm16(handedness);
+            packed.norms[0] = snorm16(normal.x);
+            packed.norms[1] = snorm16(normal.y);
+            packed.tangent[0] = snorm16(tangent.x);
+            packed.tangent[1] = snorm16(tangent.y);
+            packed.uvs[0] = glm::packHalf1x16(vertex.uvs.x);
+            packed.uvs[1] = glm::packHalf1x16(vertex.uvs.y);
+        }
+
+        return packed;
+    }
+
+    Vertex unpack_vertex(const PackedVertex& packed, const glm::vec3& min, const glm::vec3& extent) {
+        const auto position = glm::vec3(packed.pos[0], packed.pos[1], packed.pos[2]) / 65535.0f;
+        const auto normal = oct_decode(glm::max(glm::vec2(packed.norms[0], packed.norms[1]) / 32767.0f, glm::vec2(-1.0f)));
+        const auto tangent = oct_decode(glm::max(glm::vec2(packed.tangent[0], packed.tangent[1]) / 32767.0f, glm::vec2(-1.0f)));
+        const auto sign = packed.pos[3] > 32767 ? 1.0f : -1.0f;
+
+        Vertex vertex{}; {
+            vertex.pos = min + position * extent;
+            vertex.norms = normal;
+            vertex.uvs = glm::vec2(glm::unpackHalf1x16(packed.uvs[0]), glm::unpackHalf1x16(packed.uvs[1]));
+            vertex.tangent = tangent;
+            vertex.bitangent = glm::cross(normal, tangent) * sign;
+        }
+
+        return vertex;
+    }
+} // namespace tethys
@@ -1,9 +1,13 @@
 #include <tethys/renderer/renderer.hpp>
 #include <tethys/window/window.hpp>
 #include <tethys/constants.hpp>
+#include <tethys/api/upload.hpp>
 #include <tethys/api/core.hpp>
+#include <tethys/culling.hpp>
+#include <tethys/jobs.hpp>
 
 #include <tethys/directional_light.hpp>
+#include <tethys/draw_data.hpp>
 #include <tethys/render_data.hpp>
 #include <tethys/point_light.hpp>
 #include <tethys/handle.hpp>
@@ -19,13 +23,351 @@
 
 #include "camera_util.hpp"
 
+#include <filesystem>
 #include <algorithm>
+#include <cstring>
+#include <cstdlib>
 #include <numeric>
+#include <random>
+#include <chrono>
 #include <vector>
 
-int main() {
+// Untimed iterations before the benchmarks start the clock, and timed frames of the renderer benchmarks
+constexpr tethys::usize bench_warmup = 10;
+constexpr tethys::usize bench_frames = 500;
+
+// Runs warmup untimed iterations then iterations timed ones, returns the milliseconds per timed iteration
+template <typename Fn>
+static double time_loop(const tethys::usize warmup, const tethys::usize iterations, Fn&& iteration) {
+    for (tethys::usize i = 0; i < warmup; ++i) {
+        iteration();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (tethys::usize i = 0; i < iterations; ++i) {
+        iteration();
+    }
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / iterations;
+}
+
+static void start_bench(const char* title, const tethys::renderer::Settings& settings) {
+    tethys::window::initialise(1280, 720, title);
+    tethys::api::initialise();
+    tethys::jobs::initialise();
+    tethys::renderer::initialise(settings);
+}
+
+static void stop_bench() {
+    tethys::renderer::shutdown();
+    tethys::jobs::shutdown();
+}
+
+// Adds count instances of model, position returns where the ith one goes
+template <typename Fn>
+static void add_instances(const tethys::Handle<tethys::Model> model, const tethys::Pipeline& shader, const tethys::usize count, Fn&& position) {
+    for (tethys::usize i = 0; i < count; ++i) {
+        [[maybe_unused]] auto instance = tethys::renderer::add_instance(tethys::DrawCommand{
+            .model = model,
+            .transform = glm::translate(glm::mat4(1.0f), position(i)),
+            .shader = shader
+        });
+    }
+}
+
+static tethys::RenderData bench_view(const glm::vec3 eye, const glm::vec3 target) {
+    tethys::RenderData data{};
+    data.camera = {
+        glm::perspective(glm::radians(60.f), 1280 / 720.0f, 0.1f, 1000.f),
+        glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)),
+        glm::vec4(eye, 0.0f)
+    };
+
+    return data;
+}
+
+static void draw_frame(const tethys::RenderData& data) {
+    tethys::renderer::draw(data);
+    tethys::renderer::submit();
+    tethys::window::poll();
+}
+
+// Run with --bench-culling, reports CPU culling throughput over 100k spheres
+static void bench_culling() {
+    constexpr tethys::usize objects = 100000;
+    constexpr tethys::usize iterations = 100;
+
+    tethys::culling::Spheres spheres{};
+    tethys::culling::resize(spheres, objects);
+
+    std::mt19937 engine{ 42 };
+    std::uniform_real_distribution position{ -500.0f, 500.0f };
+    std::uniform_real_distribution radius{ 0.5f, 5.0f };
+
+    for (tethys::usize i = 0; i < objects; ++i) {
+        tethys::culling::write(spheres, i, glm::vec4(position(engine), position(engine), position(engine), radius(engine)));
+    }
+
+    const auto projection = glm::perspective(glm::radians(60.f), 1280 / 720.0f, 0.1f, 1000.f);
+    const auto view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const auto planes = tethys::culling::frustum_planes(projection * view);
+
+    std::vector<tethys::u32> visible{};
+    visible.reserve(objects);
+
+    const auto milliseconds = time_loop(0, iterations, [&]() {
+        visible.clear();
+        tethys::culling::cull(spheres, planes, glm::vec3(0.0f), 400.0f, visible);
+    });
+
+    std::printf("Culled %llu objects, %zu visible, %.2f objects/us\n", objects, visible.size(), objects / (milliseconds * 1000.0));
+}
+
+// Run with --bench-import, reports the load time of every .obj under resources/models
+static void bench_import() {
+    start_bench("Import benchmark", {});
+
+    std::vector<std::filesystem::path> models{};
+
+    for (const auto& directory : std::filesystem::directory_iterator("../resources/models")) {
+        for (const auto& file : std::filesystem::directory_iterator(directory)) {
+            if (file.path().extension() == ".obj") {
+                models.emplace_back(file.path());
+            }
+        }
+    }
+
+    std::sort(models.begin(), models.end());
+
+    double total = 0.0;
+
+    for (const auto& path : models) {
+        const auto start = std::chrono::steady_clock::now();
+
+        [[maybe_unused]] auto model = tethys::renderer::upload_model(path.generic_string());
+        tethys::api::wait_upload(tethys::api::flush_uploads());
+
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        total += elapsed.count();
+
+        std::printf("Loaded %s in %.2f ms\n", path.generic_string().c_str(), elapsed.count());
+    }
+
+    std::printf("Loaded %zu models in %.2f ms with %u workers\n", models.size(), total, tethys::jobs::worker_count());
+
+    stop_bench();
+}
+
+// Run with --bench-lod [off], draws a field of 1000 dragons and reports triangles submitted and frame time
+static void bench_lod(const bool lod) {
+    start_bench("LOD benchmark", { .lod = lod });
+
+    auto& minimal = tethys::shader::get<tethys::shader::minimal>();
+    const auto dragon = tethys::renderer::add_model(tethys::renderer::upload_model("../resources/models/dragon/dragon.obj"));
+
+    // 40 by 25 dragons spaced 4 units apart, the camera looks down the long side
+    add_instances(dragon, minimal, 1000, [](const tethys::usize i) {
+        return glm::vec3((static_cast<float>(i % 25) - 12.0f) * 4.0f, 0.0f, -static_cast<float>(i / 25) * 4.0f);
+    });
+
+    const auto data = bench_view(glm::vec3(0.0f, 6.0f, 10.0f), glm::vec3(0.0f, 0.0f, -40.0f));
+
+    tethys::usize frame = 0;
+    double triangles = 0.0;
+
+    const auto milliseconds = time_loop(bench_warmup, bench_frames, [&]() {
+        draw_frame(data);
+
+        if (++frame > bench_warmup) {
+            triangles += tethys::renderer::cull_stats().submitted_triangles;
+        }
+    });
+
+    std::printf("LOD %s: %.0f triangles submitted per frame, %.3f ms per frame\n", lod ? "on" : "off", triangles / bench_frames, milliseconds);
+
+    stop_bench();
+}
+
+// Run with --bench-instancing [off], draws 10k spheres sharing one mesh and reports frame time and recording threads,
+// with instancing off the commands are enough to record on several threads
+static void bench_instancing(const bool instancing) {
+    start_bench("Instancing benchmark", { .instancing = instancing });
+
+    auto& minimal = tethys::shader::get<tethys::shader::minimal>();
+    const auto sphere = tethys::renderer::add_model(tethys::renderer::upload_model("../resources/models/sphere/sphere.obj"));
+
+    // 100 by 100 spheres spaced 3 units apart in front of the camera
+    add_instances(sphere, minimal, 10000, [](const tethys::usize i) {
+        return glm::vec3((static_cast<float>(i % 100) - 50.0f) * 3.0f, (static_cast<float>(i / 100) - 50.0f) * 3.0f, -160.0f);
+    });
+
+    const auto data = bench_view(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+
+    const auto milliseconds = time_loop(bench_warmup, bench_frames, [&data]() {
+        draw_frame(data);
+    });
+
+    std::printf("Instancing %s: %.3f ms per frame, recorded on %u threads\n", instancing ? "on" : "off", milliseconds, std::max(1u, tethys::renderer::secondary_workers()));
+
+    stop_bench();
+}
+
+// Run with --bench-lights [deferred|visibility], draws 400 spheres under 4096 point lights and reports frame time
+// Run with --bench-aa <samples> [sample-shading] [fxaa] for the same scene under an antialiasing configuration
+static void bench_lights(const tethys::renderer::Settings& settings, const char* label) {
+    start_bench("Lighting benchmark", settings);
+
+    auto& pbr = tethys::shader::get<tethys::shader::pbr>();
+    const auto sphere = tethys::renderer::add_model(tethys::renderer::upload_model_pbr("../resources/models/sphere/sphere.obj"));
+
+    // 20 by 20 spheres on the ground plane, lights are scattered just above them
+    add_instances(sphere, pbr, 400, [](const tethys::usize i) {
+        return glm::vec3((static_cast<float>(i % 20) - 10.0f) * 3.0f, 0.0f, -static_cast<float>(i / 20) * 3.0f);
+    });
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (tethys::usize i = 0; i < 4096; ++i) {
+        [[maybe_unused]] auto light = tethys::renderer::add_point_light(tethys::PointLight{
+            .position = glm::vec3(unit(generator) * 60.0f - 30.0f, unit(generator) * 2.0f + 0.5f, -unit(generator) * 60.0f),
+            .color = glm::vec3(unit(generator), unit(generator), unit(generator)),
+            .intensity = 1.0f,
+            .constant = 1.0f,
+            .linear = 0.7f,
+            .quadratic = 1.8f
+        });
+    }
+
+    const auto data = bench_view(glm::vec3(0.0f, 8.0f, 10.0f), glm::vec3(0.0f, 0.0f, -30.0f));
+
+    const auto milliseconds = time_loop(bench_warmup, bench_frames, [&data]() {
+        draw_frame(data);
+    });
+
+    // Lights past the list caps are either dropped (clusters) or shaded the slow way (deferred tiles)
+    const auto stats = tethys::renderer::light_stats();
+
+    std::printf("%s: %.3f ms per frame, %u full clusters, %u overflowing tiles, %u lights in the fullest tile\n",
+        label, milliseconds, stats.overflow_clusters, stats.overflow_tiles, stats.peak_tile_lights);
+
+    stop_bench();
+}
+
+// Run with --check-async-lod, instances of a model still loading must leave the other draws alone with LOD on. The
+// path does not exist so the placeholder stays for the whole check, the dragons must be drawn exactly as before
+static bool check_async_lod() {
+    start_bench("Async loading check", { .lod = true });
+
+    auto& minimal = tethys::shader::get<tethys::shader::minimal>();
+    const auto dragon = tethys::renderer::add_model(tethys::renderer::upload_model("../resources/models/dragon/dragon.obj"));
+
+    add_instances(dragon, minimal, 100, [](const tethys::usize i) {
+        return glm::vec3((static_cast<float>(i % 10) - 5.0f) * 4.0f, 0.0f, -static_cast<float>(i / 10) * 4.0f);
+    });
+
+    const auto data = bench_view(glm::vec3(0.0f, 6.0f, 10.0f), glm::vec3(0.0f, 0.0f, -20.0f));
+
+    (void)time_loop(bench_warmup, 0, [&data]() {
+        draw_frame(data);
+    });
+
+    const auto before = tethys::renderer::cull_stats();
+    const auto fragments_before = tethys::renderer::fragment_invocations();
+
+    const auto pending = tethys::renderer::upload_model_async("../resources/models/missing/missing.obj");
+
+    // In view between the dragons, where a stray instance would be drawn
+    add_instances(pending, minimal, 100, [](const tethys::usize i) {
+        return glm::vec3((static_cast<float>(i % 10) - 5.0f) * 4.0f + 2.0f, 1.0f, -static_cast<float>(i / 10) * 4.0f - 2.0f);
+    });
+
+    (void)time_loop(bench_warmup, 0, [&data]() {
+        draw_frame(data);
+    });
+
+    const auto after = tethys::renderer::cull_stats();
+    const auto fragments_after = tethys::renderer::fragment_invocations();
+
+    const auto unchanged =
+        before.frustum_draws == after.frustum_draws &&
+        before.submitted_triangles == after.submitted_triangles &&
+        fragments_before == fragments_after;
+
+    std::printf("Async load with LOD: %u -> %u triangles submitted, %llu -> %llu fragments, %s\n",
+        before.submitted_triangles, after.submitted_triangles,
+        static_cast<unsigned long long>(fragments_before), static_cast<unsigned long long>(fragments_after),
+        unchanged ? "unchanged" : "CHANGED");
+
+    stop_bench();
+
+    return unchanged;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--check-async-lod") == 0) {
+        return check_async_lod() ? 0 : 1;
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--bench-culling") == 0) {
+        bench_culling();
+        return 0;
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--bench-import") == 0) {
+        bench_import();
+        return 0;
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--bench-lod") == 0) {
+        bench_lod(!(argc > 2 && std::strcmp(argv[2], "off") == 0));
+        return 0;
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--bench-instancing") == 0) {
+        bench_instancing(!(argc > 2 && std::strcmp(argv[2], "off") == 0));
+        return 0;
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--bench-lights") == 0) {
+        tethys::renderer::Settings settings{};
+        const char* label = "Forward shading";
+
+        if (argc > 2 && std::strcmp(argv[2], "deferred") == 0) {
+            settings.shading = tethys::renderer::Shading::deferred;
+            label = "Deferred shading";
+        } else if (argc > 2 && std::strcmp(argv[2], "visibility") == 0) {
+            settings.shading = tethys::renderer::Shading::visibility;
+            label = "Visibility shading";
+        }
+
+        bench_lights(settings, label);
+        return 0;
+    }
+
+    if (argc > 2 && std::strcmp(argv[1], "--bench-aa") == 0) {
+        tethys::renderer::Settings settings{};
+        settings.samples = static_cast<tethys::u32>(std::strtoul(argv[2], nullptr, 10));
+
+        for (int i = 3; i < argc; ++i) {
+            settings.sample_shading |= std::strcmp(argv[i], "sample-shading") == 0;
+            settings.fxaa |= std::strcmp(argv[i], "fxaa") == 0;
+        }
+
+        char label[64];
+        std::snprintf(label, sizeof(label), "%ux MSAA, sample shading %s, FXAA %s",
+            settings.samples, settings.sample_shading ? "on" : "off", settings.fxaa ? "on" : "off");
+
+        bench_lights(settings, label);
+        return 0;
+    }
+
     tethys::window::initialise(1280, 720, "Test");
     tethys::api::initialise();
+    tethys::jobs::initialise();
     tethys::renderer::initialise();
 
     auto& minimal = tethys::shader::get<tethys::shader::minimal>();
@@ -47,6 +389,23 @@ int main() {
     sun.submeshes[0].metallic.index = 0;
     sun.submeshes[0].occlusion.index = 0;
 
+    auto sphere = tethys::renderer::add_model(sphere_model);
+    auto sun_sphere = tethys::renderer::add_model(sun);
+
+    [[maybe_unused]] auto sphere_instance = tethys::renderer::add_instance(tethys::DrawCommand{
+        .model = sphere,
+        .transform = glm::scale(glm::mat4(1.0f), glm::vec3(0.5f)),
+        .shader = pbr
+    });
+
+    auto sun_instance = tethys::renderer::add_instance(tethys::DrawCommand{
+        .model = sun_sphere,
+        .transform = glm::mat4(1.0f),
+        .shader = minimal
+    });
+
+    auto light = tethys::renderer::add_point_light(tethys::PointLight{});
+
     static CameraUtil camera;
 
     glfwSetCursorPosCallback(tethys::window::handle(), [](GLFWwindow*, double xpos, double ypos) {
@@ -87,29 +446,16 @@ int main() {
             glm::vec4(camera.cam_pos, 0.0f)
         };
 
-        data.draw_commands = {
-            tethys::DrawCommand{
-                .model = sphere_model,
-                .transform = glm::scale(glm::mat4(1.0f), glm::vec3(0.5f)),
-                .shader = pbr
-            },
-            tethys::DrawCommand{
-                .model = sun,
-                .transform = glm::translate(glm::scale(glm::mat4(1.0f), glm::vec3(0.10f)), light_pos),
-                .shader = minimal
-            }
-        };
+        tethys::renderer::update_instance(sun_instance, glm::translate(glm::scale(glm::mat4(1.0f), glm::vec3(0.10f)), light_pos));
 
-        data.point_lights = {
-            tethys::PointLight{
-                .position = light_pos,
-                .color = glm::vec3(1.0f),
-                .intensity = 6.0f,
-                .constant = 1.0f,
-                .linear = 0.14f,
-                .quadratic = 0.007f
-            }
-        };
+        tethys::renderer::update_point_light(light, tethys::PointLight{
+            .position = light_pos,
+            .color = glm::vec3(1.0f),
+            .intensity = 6.0f,
+            .constant = 1.0f,
+            .linear = 0.14f,
+            .quadratic = 0.007f
+        });
 
         tethys::renderer::draw(data);
         tethys::renderer::submit();
@@ -123,5 +469,8 @@ int main() {
         tethys::window::poll();
     }
 
+    tethys::renderer::shutdown();
+    tethys::jobs::shutdown();
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include <tethys/logger.hpp>
+#include <tethys/tmesh.hpp>
+#include <tethys/jobs.hpp>
+
+#include <exception>
+#include <cstdio>
+
+// Usage: tethys-bake <model> [output], the output defaults to the model path with a .tmesh extension
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::printf("Usage: %s <model> [output]\n", argv[0]);
+        return 1;
+    }
+
+    tethys::jobs::initialise();
+
+    try {
+        const std::string source = argv[1];
+
+        tethys::tmesh::bake(source, argc > 2 ? argv[2] : tethys::tmesh::baked_path(source));
+    } catch (const std::exception& error) {
+        tethys::logger::error("Bake failed: {}", error.what());
+        return 1;
+    }
+
+    return 0;
+}